@@ -0,0 +1,98 @@
+// Measures the energy drift and running time of each scene integrator
+// on a stiff spring chain, at several step sizes.
+// Build with 'make NO_ASAN=true bin/bench_integrators' for meaningful times.
+
+#include "forces.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+const size_t CHAIN_LENGTH = 32;
+const double SPRING_K = 1000;
+const double LINK_MASS = 1;
+const double SIMULATED_TIME = 10;
+
+const char *INTEGRATOR_NAMES[] = {"default", "symplectic_euler",
+                                  "velocity_verlet", "rk4"};
+const int FORCE_EVALUATIONS[] = {1, 1, 2, 4};
+
+list_t *make_square() {
+  list_t *shape = list_init(4, free);
+  vector_t corners[] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = corners[i];
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+// A chain of masses joined by springs, with an anchor at each end.
+// The masses start displaced sideways in the shape of the lowest mode.
+scene_t *make_chain() {
+  scene_t *scene = scene_init();
+  for (size_t i = 0; i < CHAIN_LENGTH + 2; i++) {
+    bool anchor = i == 0 || i == CHAIN_LENGTH + 1;
+    body_t *body = body_init(make_square(), anchor ? INFINITY : LINK_MASS,
+                             (rgb_color_t){0, 0, 0});
+    double offset = 5 * sin(M_PI * i / (CHAIN_LENGTH + 1));
+    body_set_centroid(body, (vector_t){10.0 * i, offset});
+    scene_add_body(scene, body);
+    if (i > 0) {
+      create_spring(scene, SPRING_K, scene_get_body(scene, i - 1), body);
+    }
+  }
+  return scene;
+}
+
+double chain_energy(scene_t *scene) {
+  double energy = 0;
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    body_t *body = scene_get_body(scene, i);
+    if (body_get_mass(body) != INFINITY) {
+      vector_t v = body_get_velocity(body);
+      energy += 0.5 * body_get_mass(body) * vec_dot(v, v);
+    }
+    if (i > 0) {
+      body_t *previous = scene_get_body(scene, i - 1);
+      vector_t stretch =
+          vec_subtract(body_get_centroid(body), body_get_centroid(previous));
+      energy += 0.5 * SPRING_K * vec_dot(stretch, stretch);
+    }
+  }
+  return energy;
+}
+
+int main(void) {
+  const double steps[] = {1e-2, 5e-3, 2e-3, 1e-3, 5e-4};
+  printf("integrator,dt,force_evaluations,seconds,max_energy_drift\n");
+  for (integrator_t integrator = 0; integrator < INTEGRATOR_KINDS;
+       integrator++) {
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+      double dt = steps[i];
+      scene_t *scene = make_chain();
+      scene_set_integrator(scene, integrator);
+      double initial_energy = chain_energy(scene);
+      double max_drift = 0;
+      size_t ticks = (size_t)round(SIMULATED_TIME / dt);
+      double seconds = 0;
+      for (size_t tick = 0; tick < ticks; tick++) {
+        clock_t start = clock();
+        scene_tick(scene, dt);
+        seconds += (double)(clock() - start) / CLOCKS_PER_SEC;
+        double drift =
+            fabs(chain_energy(scene) - initial_energy) / initial_energy;
+        // A simulation that blows up reports infinite drift
+        if (!isfinite(drift)) {
+          max_drift = INFINITY;
+        } else if (drift > max_drift) {
+          max_drift = drift;
+        }
+      }
+      printf("%s,%g,%zu,%f,%g\n", INTEGRATOR_NAMES[integrator], dt,
+             FORCE_EVALUATIONS[integrator] * ticks, seconds, max_drift);
+      scene_free(scene);
+    }
+  }
+}
@@ -0,0 +1,135 @@
+// Measures the cost of find_collision() and polygon_centroid()
+// for regular polygons with 3 to 256 vertices. Collisions are measured
+// with the two polygons overlapping, separated, and just touching.
+// Each row gives the mean and standard deviation, over several batches,
+// of the nanoseconds per call.
+// Build with 'make NO_ASAN=true bin/bench_narrow_phase' for meaningful times.
+
+#include "collision.h"
+#include "polygon.h"
+#include "timing.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+const double RADIUS = 10;
+// Each batch runs for about this long, so it is much longer than
+// the clock's resolution, and the batches' times are compared
+const double BATCH_SECONDS = 0.02;
+const size_t BATCHES = 15;
+// How much of their width touching polygons overlap by. Polygons that
+// touch exactly may or may not collide, depending on rounding.
+const double TOUCH_OVERLAP = 1e-9;
+
+typedef enum { OVERLAPPING, SEPARATED, TOUCHING, CONFIGURATIONS } config_t;
+
+const char *CONFIG_NAMES[] = {"overlapping", "separated", "touching"};
+const bool CONFIG_COLLIDES[] = {true, false, true};
+
+// A regular polygon, with an edge facing +x, centered at the given x
+list_t *make_polygon(size_t sides, double x) {
+  list_t *shape = list_init(sides, free);
+  for (size_t i = 0; i < sides; i++) {
+    double angle = M_PI * (2 * i + 1) / sides;
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t){x + RADIUS * cos(angle), RADIUS * sin(angle)};
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+// Finds how far apart two copies of the polygon are when their
+// facing edges meet along x
+double touching_distance(list_t *shape) {
+  double min_x = INFINITY, max_x = -INFINITY;
+  for (size_t i = 0; i < list_size(shape); i++) {
+    vector_t *v = list_get(shape, i);
+    min_x = fmin(min_x, v->x);
+    max_x = fmax(max_x, v->x);
+  }
+  return max_x - min_x;
+}
+
+typedef struct measurement {
+  double mean_ns;
+  double stddev_ns;
+  size_t calls;
+} measurement_t;
+
+// Keeps the results used, so the calls aren't optimized away
+volatile double sink;
+
+// The calls being measured, returning part of their results
+typedef double (*bench_call_t)(list_t *shape1, list_t *shape2);
+
+double call_find_collision(list_t *shape1, list_t *shape2) {
+  return find_collision(shape1, shape2).depth;
+}
+
+double call_polygon_centroid(list_t *shape1, list_t *shape2) {
+  return polygon_centroid(shape1).x;
+}
+
+/**
+ * Runs a call in batches and computes the mean and standard deviation
+ * of the batches' times per call.
+ */
+measurement_t measure(bench_call_t call, list_t *shape1, list_t *shape2) {
+  // Calibrate the batch size so each batch takes about BATCH_SECONDS
+  size_t calls_per_batch = 1;
+  while (true) {
+    double start = timing_now();
+    for (size_t i = 0; i < calls_per_batch; i++) {
+      sink = call(shape1, shape2);
+    }
+    if (timing_now() - start >= BATCH_SECONDS / 4) {
+      calls_per_batch *= 4;
+      break;
+    }
+    calls_per_batch *= 2;
+  }
+
+  double sum = 0, sum_squares = 0;
+  for (size_t batch = 0; batch < BATCHES; batch++) {
+    double start = timing_now();
+    for (size_t i = 0; i < calls_per_batch; i++) {
+      sink = call(shape1, shape2);
+    }
+    double ns = 1e9 * (timing_now() - start) / calls_per_batch;
+    sum += ns;
+    sum_squares += ns * ns;
+  }
+  double mean = sum / BATCHES;
+  double variance = (sum_squares - BATCHES * mean * mean) / (BATCHES - 1);
+  return (measurement_t){.mean_ns = mean,
+                         .stddev_ns = sqrt(fmax(variance, 0)),
+                         .calls = calls_per_batch * BATCHES};
+}
+
+int main(void) {
+  const size_t vertex_counts[] = {3, 4, 8, 16, 32, 64, 128, 256};
+  printf("function,vertices,configuration,collided,calls,mean_ns,stddev_ns\n");
+  for (size_t i = 0; i < sizeof(vertex_counts) / sizeof(vertex_counts[0]);
+       i++) {
+    size_t n = vertex_counts[i];
+    list_t *shape1 = make_polygon(n, 0);
+    double touching = touching_distance(shape1);
+    const double distances[] = {touching / 2, 2 * touching,
+                                touching * (1 - TOUCH_OVERLAP)};
+    for (config_t config = 0; config < CONFIGURATIONS; config++) {
+      list_t *shape2 = make_polygon(n, distances[config]);
+      bool collided = find_collision(shape1, shape2).collided;
+      // Every size must measure the same outcome
+      assert(collided == CONFIG_COLLIDES[config]);
+      measurement_t result = measure(call_find_collision, shape1, shape2);
+      printf("find_collision,%zu,%s,%d,%zu,%f,%f\n", n, CONFIG_NAMES[config],
+             collided, result.calls, result.mean_ns, result.stddev_ns);
+      list_free(shape2);
+    }
+    measurement_t result = measure(call_polygon_centroid, shape1, NULL);
+    printf("polygon_centroid,%zu,,,%zu,%f,%f\n", n, result.calls,
+           result.mean_ns, result.stddev_ns);
+    list_free(shape1);
+  }
+}
@@ -0,0 +1,68 @@
+// Measures the cost of drawing scenes of rotating star-shaped bodies
+// into a window-sized offscreen image, and prints a hash of the last
+// frame so changes to the draw path can be checked for differences.
+// Build with 'make NO_ASAN=true bin/bench_render' for meaningful times.
+
+#include "raster.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+const vector_t MIN_POSITION = {0, 0};
+const vector_t MAX_POSITION = {1000, 500};
+const size_t WIDTH = 1000;
+const size_t HEIGHT = 500;
+const size_t FRAMES = 100;
+const size_t STAR_POINTS = 5;
+const double STAR_RADIUS = 10;
+const double DT = 0.01;
+
+list_t *make_star_shape() {
+  list_t *shape = list_init(2 * STAR_POINTS, free);
+  for (size_t i = 0; i < 2 * STAR_POINTS; i++) {
+    double radius = i % 2 == 0 ? STAR_RADIUS : STAR_RADIUS / 2;
+    double angle = M_PI * i / STAR_POINTS;
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t){radius * cos(angle), radius * sin(angle)};
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+// Lays bodies out on a grid, spinning at different rates
+scene_t *make_scene(size_t bodies) {
+  scene_t *scene = scene_init();
+  size_t columns = (size_t)ceil(sqrt(2.0 * bodies));
+  double spacing = MAX_POSITION.x / columns;
+  for (size_t i = 0; i < bodies; i++) {
+    body_t *body = body_init(make_star_shape(), 1,
+                             (rgb_color_t){i % 3 / 2.0, 0.5, 0});
+    body_set_centroid(body, (vector_t){(i % columns + 0.5) * spacing,
+                                       (i / columns + 0.5) * spacing});
+    body_set_angular_velocity(body, 1 + i % 5);
+    scene_add_body(scene, body);
+  }
+  return scene;
+}
+
+int main(void) {
+  const size_t body_counts[] = {10, 100, 1000};
+  printf("bodies,frames,seconds,ms_per_frame,frame_hash\n");
+  raster_t *raster = raster_init(MIN_POSITION, MAX_POSITION, WIDTH, HEIGHT);
+  for (size_t i = 0; i < sizeof(body_counts) / sizeof(body_counts[0]); i++) {
+    scene_t *scene = make_scene(body_counts[i]);
+    double seconds = 0;
+    for (size_t frame = 0; frame < FRAMES; frame++) {
+      scene_tick(scene, DT);
+      clock_t start = clock();
+      raster_render_scene(raster, scene);
+      seconds += (double)(clock() - start) / CLOCKS_PER_SEC;
+    }
+    printf("%zu,%zu,%f,%f,%016" PRIx64 "\n", body_counts[i], FRAMES, seconds,
+           1000 * seconds / FRAMES, raster_hash(raster));
+    scene_free(scene);
+  }
+  raster_free(raster);
+}
@@ -0,0 +1,175 @@
+// Measures how the cost of scene_tick() grows with the number of bodies,
+// on synthetic scenes of each kind the demos use, and prints JSON.
+// Build with 'make NO_ASAN=true bin/bench_scene' for meaningful times.
+
+#include "forces.h"
+#include "mem_stats.h"
+#include "timing.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+const vector_t WORLD_SIZE = {1000, 500};
+const double DT = 1e-3;
+// Each measurement runs at least this many ticks, for at least this long
+const size_t MIN_TICKS = 50;
+const double MIN_SECONDS = 0.5;
+const double ELASTICITY = 0.9;
+const double SPRING_K = 100;
+const double G = 100;
+const unsigned SEED = 3;
+
+double random_between(double min, double max) {
+  return min + (max - min) * rand() / RAND_MAX;
+}
+
+// A convex polygon with the given number of sides and radius
+list_t *make_polygon(size_t sides, double radius) {
+  list_t *shape = list_init(sides, free);
+  for (size_t i = 0; i < sides; i++) {
+    double angle = 2 * M_PI * i / sides;
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t){radius * cos(angle), radius * sin(angle)};
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+list_t *make_rectangle(double width, double height) {
+  list_t *shape = list_init(4, free);
+  vector_t corners[] = {{-width / 2, -height / 2},
+                        {width / 2, -height / 2},
+                        {width / 2, height / 2},
+                        {-width / 2, height / 2}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = corners[i];
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+body_t *add_random_body(scene_t *scene, list_t *shape, double mass) {
+  body_t *body = body_init(shape, mass, (rgb_color_t){0, 0, 0});
+  body_set_centroid(body, (vector_t){random_between(0, WORLD_SIZE.x),
+                                     random_between(0, WORLD_SIZE.y)});
+  vector_t velocity = {random_between(-50, 50), random_between(-50, 50)};
+  body_set_velocity(body, velocity);
+  scene_add_body(scene, body);
+  return body;
+}
+
+// Random polygons that bounce off each other, with a collision per pair
+scene_t *make_polygons(size_t n) {
+  scene_t *scene = scene_init();
+  for (size_t i = 0; i < n; i++) {
+    add_random_body(scene, make_polygon(3 + rand() % 6, 8), 1);
+  }
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = i + 1; j < n; j++) {
+      create_physics_collision(scene, ELASTICITY, scene_get_body(scene, i),
+                               scene_get_body(scene, j));
+    }
+  }
+  return scene;
+}
+
+// A field of static bricks, each breakable by a few balls
+scene_t *make_bricks(size_t n) {
+  const size_t balls = 4;
+  const size_t columns = 20;
+  const vector_t brick_size = {WORLD_SIZE.x / columns, 10};
+  scene_t *scene = scene_init();
+  for (size_t i = 0; i < balls; i++) {
+    add_random_body(scene, make_polygon(16, 5), 1);
+  }
+  for (size_t i = 0; i < n; i++) {
+    body_t *brick = body_init(make_rectangle(brick_size.x - 2, brick_size.y),
+                              INFINITY, (rgb_color_t){1, 0, 0});
+    body_set_centroid(brick,
+                      (vector_t){(i % columns + 0.5) * brick_size.x,
+                                 WORLD_SIZE.y - (i / columns + 0.5) *
+                                                    brick_size.y});
+    body_set_static(brick, true);
+    scene_add_body(scene, brick);
+    for (size_t j = 0; j < balls; j++) {
+      create_physics_collision(scene, 1, scene_get_body(scene, j), brick);
+    }
+  }
+  return scene;
+}
+
+// A chain of bodies joined by springs
+scene_t *make_springs(size_t n) {
+  scene_t *scene = scene_init();
+  for (size_t i = 0; i < n; i++) {
+    body_t *body = add_random_body(scene, make_polygon(4, 3), 1);
+    if (i > 0) {
+      create_spring(scene, SPRING_K, scene_get_body(scene, i - 1), body);
+    }
+  }
+  return scene;
+}
+
+// Bodies that all attract each other, with a gravity force per pair
+scene_t *make_gravity(size_t n) {
+  scene_t *scene = scene_init();
+  for (size_t i = 0; i < n; i++) {
+    add_random_body(scene, make_polygon(5, 4), random_between(1, 10));
+  }
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = i + 1; j < n; j++) {
+      create_newtonian_gravity(scene, G, scene_get_body(scene, i),
+                               scene_get_body(scene, j));
+    }
+  }
+  return scene;
+}
+
+typedef struct scenario {
+  const char *name;
+  scene_t *(*make_scene)(size_t n);
+} scenario_t;
+
+const scenario_t SCENARIOS[] = {{"polygons", make_polygons},
+                                {"bricks", make_bricks},
+                                {"springs", make_springs},
+                                {"gravity", make_gravity}};
+const size_t BODY_COUNTS[] = {16, 32, 64, 128, 256, 512};
+
+int main(void) {
+  size_t scenarios = sizeof(SCENARIOS) / sizeof(SCENARIOS[0]);
+  size_t sizes = sizeof(BODY_COUNTS) / sizeof(BODY_COUNTS[0]);
+  printf("{\n  \"benchmark\": \"scene\",\n  \"dt\": %g,\n  \"results\": [", DT);
+  for (size_t i = 0; i < scenarios; i++) {
+    for (size_t j = 0; j < sizes; j++) {
+      srand(SEED);
+      scene_t *scene = SCENARIOS[i].make_scene(BODY_COUNTS[j]);
+      // Some scenarios add bodies besides the n being swept, like balls
+      size_t bodies = scene_bodies(scene);
+      // The first tick builds caches, so it is left out
+      scene_tick(scene, DT);
+
+      size_t ticks = 0;
+      size_t allocations = mem_alloc_calls();
+      double start = timing_now();
+      double seconds = 0;
+      while (ticks < MIN_TICKS || seconds < MIN_SECONDS) {
+        scene_tick(scene, DT);
+        ticks++;
+        seconds = timing_now() - start;
+      }
+      allocations = mem_alloc_calls() - allocations;
+
+      printf("%s\n    {\"scenario\": \"%s\", \"bodies\": %zu, "
+             "\"scene_bodies\": %zu, \"ticks\": %zu, \"seconds\": %f, "
+             "\"ticks_per_second\": %f, \"ns_per_body\": %f, "
+             "\"allocations_per_tick\": %f}",
+             i == 0 && j == 0 ? "" : ",", SCENARIOS[i].name, BODY_COUNTS[j],
+             bodies, ticks, seconds, ticks / seconds,
+             1e9 * seconds / ticks / bodies, (double)allocations / ticks);
+      scene_free(scene);
+    }
+  }
+  printf("\n  ]\n}\n");
+}
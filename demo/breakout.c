@@ -76,6 +76,8 @@ typedef struct state {
   scene_tuple_t *scene_tup;
   double last_time;
   double time;
+  // Set by a collision handler to start over once the tick is done
+  bool restart;
 } state_t;
 
 void reset_init(state_t *state);
@@ -109,6 +111,8 @@ body_t *make_brick(double x_in, double y_in, int brick_num) {
   brick_info->body_type = BRICK_TYPE;
   body_t *brick = body_init_with_info(shape, MASS, BRICK_COLORS[brick_num],
                                       brick_info, (free_func_t)free);
+  // Bricks only change when they break, so they are drawn as scenery
+  body_set_static(brick, true);
   return brick;
 }
 
@@ -155,6 +159,7 @@ body_t *make_horizontal_wall() {
   player_info->body_type = PLAY_TYPE;
   body_t *player = body_init_with_info(shape, INFINITY, COLOR_WALL, player_info,
                                        (free_func_t)free);
+  body_set_static(player, true);
   return player;
 }
 
@@ -176,6 +181,7 @@ body_t *make_vertical_wall() {
   player_info->body_type = PLAY_TYPE;
   body_t *player = body_init_with_info(shape, INFINITY, COLOR_WALL, player_info,
                                        (free_func_t)free);
+  body_set_static(player, true);
   return player;
 }
 
@@ -254,9 +260,8 @@ void special_case(body_t *ball, body_t *brick, vector_t axis, void *aux) {
 
 void restart_game(body_t *ball, body_t *wall, vector_t axis, void *aux) {
   state_t *state = aux;
-  sdl_clear();
-  free(state->scene_tup);
-  reset_init(state);
+  // The scene is still ticking, so it is replaced in emscripten_main()
+  state->restart = true;
 }
 
 void exit_game(body_t *ball, body_t *wall, vector_t axis, void *aux) {
@@ -353,6 +358,7 @@ void reset_init(state_t *state) {
   state->scene_tup->update_time = 0;
   state->last_time = 0;
   state->time = 0;
+  state->restart = false;
 }
 
 state_t *emscripten_init() {
@@ -368,6 +374,7 @@ state_t *emscripten_init() {
   state->scene_tup->update_time = 0;
   state->last_time = 0;
   state->time = 0;
+  state->restart = false;
   return state;
 }
 
@@ -386,6 +393,12 @@ void emscripten_main(state_t *state) {
     exit(1);
   }
   scene_tick(state->scene, state->last_time);
+  if (state->restart) {
+    sdl_clear();
+    free(state->scene_tup);
+    scene_free(state->scene);
+    reset_init(state);
+  }
   sdl_render_scene(state->scene);
 }
 
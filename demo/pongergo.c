@@ -151,6 +151,7 @@ body_t *make_horizontal_wall() {
   wall_info->width = MAX.y;
   body_t *wall = body_init_with_info(shape, INFINITY, COLOR_WALL, wall_info,
                                      (free_func_t)free);
+  body_set_static(wall, true);
   return wall;
 }
 
@@ -174,6 +175,7 @@ body_t *make_vertical_wall() {
   wall_info->width = WALL_BUFF;
   body_t *wall = body_init_with_info(shape, INFINITY, COLOR_WALL, wall_info,
                                      (free_func_t)free);
+  body_set_static(wall, true);
   return wall;
 }
 
@@ -731,12 +733,17 @@ scene_t *game_init() {
   scene_add_body(scene,
                  make_goal((vector_t){MAX.x * 0.75, MIN.y + (WALL_BUFF / 2)},
                            GOAL_HEIGHT, GOAL_WIDTH, GOAL2_TYPE));
-  scene_add_body(scene, make_goal((vector_t){MIN.x + (WALL_BUFF / 2), CENTER.y},
-                                  STATIC_GOAL_HEIGHT, STATIC_GOAL_WIDTH,
-                                  STATIC_GOAL1_TYPE));
-  scene_add_body(scene, make_goal((vector_t){MAX.x - (WALL_BUFF / 2), CENTER.y},
-                                  STATIC_GOAL_HEIGHT, STATIC_GOAL_WIDTH,
-                                  STATIC_GOAL2_TYPE));
+  body_t *static_goal1 =
+      make_goal((vector_t){MIN.x + (WALL_BUFF / 2), CENTER.y},
+                STATIC_GOAL_HEIGHT, STATIC_GOAL_WIDTH, STATIC_GOAL1_TYPE);
+  body_t *static_goal2 =
+      make_goal((vector_t){MAX.x - (WALL_BUFF / 2), CENTER.y},
+                STATIC_GOAL_HEIGHT, STATIC_GOAL_WIDTH, STATIC_GOAL2_TYPE);
+  // Powerups rescale the static goals, which just redraws the scenery
+  body_set_static(static_goal1, true);
+  body_set_static(static_goal2, true);
+  scene_add_body(scene, static_goal1);
+  scene_add_body(scene, static_goal2);
   return scene;
 }
 
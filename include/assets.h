@@ -0,0 +1,126 @@
+#ifndef __ASSETS_H__
+#define __ASSETS_H__
+
+#include "list.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Loads an asset from a file, such as decoding an image.
+ * May run on the loader thread, so it must not touch the renderer.
+ *
+ * @param path the path passed to asset_load()
+ * @param aux the auxiliary value passed to asset_load()
+ * @return the loaded asset, or NULL if loading failed
+ */
+typedef void *(*asset_load_t)(const char *path, void *aux);
+
+/**
+ * The states of an asset.
+ */
+typedef enum { ASSET_LOADING, ASSET_READY, ASSET_FAILED } asset_state_t;
+
+/**
+ * Loads assets in the background, in the order they are requested,
+ * so a game can start drawing frames before its assets finish loading.
+ * Under Emscripten, where the demos are built without threads,
+ * assets load one at a time in asset_manager_poll() instead.
+ */
+typedef struct asset_manager asset_manager_t;
+
+/**
+ * A reference-counted handle to an asset that may still be loading.
+ * Requesting the same file with the same loader again shares the handle.
+ * The asset is freed when its last reference is released.
+ */
+typedef struct asset asset_t;
+
+/**
+ * Allocates an asset manager.
+ *
+ * @param use_thread whether to load assets on a thread of its own;
+ *   if false (or under Emscripten), they load in asset_manager_poll()
+ * @return a pointer to the newly allocated manager
+ */
+asset_manager_t *asset_manager_init(bool use_thread);
+
+/**
+ * Stops an asset manager's loader thread, once it finishes loading
+ * the current asset, and releases the manager's memory.
+ * Every asset loaded with it must already have been released.
+ *
+ * @param manager a pointer returned from asset_manager_init()
+ */
+void asset_manager_free(asset_manager_t *manager);
+
+/**
+ * Loads the oldest requested asset on the calling thread,
+ * if the manager has no loader thread. Otherwise does nothing.
+ * Call it once per frame so loading is spread across frames.
+ *
+ * @param manager a pointer returned from asset_manager_init()
+ */
+void asset_manager_poll(asset_manager_t *manager);
+
+/**
+ * Waits until every requested asset has finished loading.
+ *
+ * @param manager a pointer returned from asset_manager_init()
+ */
+void asset_manager_wait(asset_manager_t *manager);
+
+/**
+ * Gets the fraction of the requested assets that have finished loading
+ * (successfully or not), so a loading screen can show progress.
+ *
+ * @param manager a pointer returned from asset_manager_init()
+ * @return a number from 0 to 1; 1 if nothing is loading
+ */
+double asset_manager_progress(asset_manager_t *manager);
+
+/**
+ * Requests an asset, without waiting for it to load.
+ *
+ * @param manager a pointer returned from asset_manager_init()
+ * @param path the file to load; copied
+ * @param load the function that loads it
+ * @param freer the function that releases it
+ * @param aux a value to pass to load
+ * @return a handle with a reference owned by the caller
+ */
+asset_t *asset_load(asset_manager_t *manager, const char *path,
+                    asset_load_t load, free_func_t freer, void *aux);
+
+/**
+ * Adds a reference to an asset.
+ *
+ * @param asset a handle returned from asset_load()
+ */
+void asset_retain(asset_t *asset);
+
+/**
+ * Removes a reference to an asset, freeing it if it was the last one.
+ *
+ * @param asset a handle returned from asset_load(), or NULL
+ */
+void asset_release(asset_t *asset);
+
+/**
+ * Gets whether an asset is still loading, loaded, or failed to load.
+ * Can be called from any thread.
+ *
+ * @param asset a handle returned from asset_load()
+ * @return the asset's state
+ */
+asset_state_t asset_get_state(asset_t *asset);
+
+/**
+ * Gets a loaded asset. Can be called from any thread.
+ *
+ * @param asset a handle returned from asset_load()
+ * @return the value returned by the asset's loader,
+ *   or NULL if it is still loading or failed to load
+ */
+void *asset_get(asset_t *asset);
+
+#endif // #ifndef __ASSETS_H__
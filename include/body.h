@@ -5,6 +5,7 @@
 #include "list.h"
 #include "vector.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
  * A rigid body constrained to the plane.
@@ -16,6 +17,52 @@ typedef struct body body_t;
 
 typedef struct info info_t;
 
+/**
+ * A set of up to 32 layers, one per bit.
+ * Scene-wide force fields only act on bodies in one of their layers
+ * (see scene_add_uniform_field()).
+ */
+typedef uint32_t layer_mask_t;
+
+/** The layers a new body is in: just layer 0 */
+#define LAYER_DEFAULT ((layer_mask_t)1)
+/** Every layer */
+#define LAYER_ALL ((layer_mask_t)UINT32_MAX)
+
+/**
+ * A body's shape split into triangles, in the body's own frame.
+ * The vertices are relative to the body's centroid and are rotated by
+ * the body's rotation at the time the mesh was built, so the body's
+ * current vertices are centroid + vec_rotate(v, rotation - mesh rotation).
+ * Moving or rotating the body keeps the mesh; only reshaping rebuilds it.
+ */
+typedef struct {
+  size_t vertex_count;
+  const vector_t *vertices;
+  double rotation;
+  size_t triangle_count;
+  /** 3 indices into vertices per triangle */
+  const size_t *indices;
+} body_mesh_t;
+
+/**
+ * The plain-data state of a body, excluding its shape and info.
+ * Used to copy bodies into and out of flat buffers (see flat_scene.h).
+ */
+typedef struct {
+  vector_t velocity;
+  double max_velocity;
+  double ang_velocity;
+  double rotation;
+  double max_rotation;
+  vector_t force;
+  vector_t impulse;
+  double mass;
+  rgb_color_t color;
+  layer_mask_t layers;
+  bool removed;
+} body_state_t;
+
 /**
  * Initializes a body without any info.
  * Acts like body_init_with_info() where info and info_freer are NULL.
@@ -54,6 +101,99 @@ void body_free(body_t *body);
  */
 list_t *body_get_shape(body_t *body);
 
+/**
+ * Gets the shape a body owns, without copying it.
+ * Useful for read-only queries like find_collision() that run every tick.
+ * The list must not be modified or freed.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's own list of vertices
+ */
+list_t *body_peek_shape(body_t *body);
+
+/**
+ * Gets a body's triangle mesh for drawing.
+ * The mesh is built on first use and cached until the body's shape changes
+ * (body_y_scale() or body_set_vertices()), so drawing a moving body only
+ * needs to transform the cached vertices.
+ * Shapes with fewer than 3 vertices get a mesh with no triangles.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's mesh, valid until the body is reshaped or freed
+ *   unless it is retained
+ */
+const body_mesh_t *body_get_mesh(body_t *body);
+
+/**
+ * Keeps a mesh alive after its body is reshaped or freed,
+ * e.g. while another thread draws it. Meshes are never modified,
+ * so a retained mesh can be read from any thread.
+ * Each call must be matched by a call to body_mesh_release().
+ *
+ * @param mesh a mesh returned from body_get_mesh()
+ */
+void body_mesh_retain(const body_mesh_t *mesh);
+
+/**
+ * Gives up a reference to a mesh taken with body_mesh_retain().
+ * The mesh is freed once neither its body nor anything else holds it.
+ * Safe to call from any thread.
+ *
+ * @param mesh a retained mesh
+ */
+void body_mesh_release(const body_mesh_t *mesh);
+
+/**
+ * Gets the number of vertices in a body's shape.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the number of vertices of the body's polygon
+ */
+size_t body_num_vertices(body_t *body);
+
+/**
+ * Gets the number of bytes a body has allocated for itself and its shape list,
+ * plus its mesh if it has one. Does not include the vertices or the info.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the memory used by the body, in bytes
+ */
+size_t body_memory_size(body_t *body);
+
+/**
+ * Gets the plain-data state of a body.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's velocity, rotation, accumulated forces, mass, etc.
+ */
+body_state_t body_get_state(body_t *body);
+
+/**
+ * Overwrites the plain-data state of a body.
+ * Does not change the body's shape or info.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param state the state to copy into the body
+ */
+void body_set_state(body_t *body, body_state_t state);
+
+/**
+ * Copies the vertices of a body's shape into an array.
+ * Unlike body_get_shape(), this does not allocate any memory.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param vertices an array with space for body_num_vertices(body) vectors
+ */
+void body_copy_vertices(body_t *body, vector_t *vertices);
+
+/**
+ * Overwrites the vertices of a body's shape from an array.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param vertices an array of body_num_vertices(body) vectors
+ */
+void body_set_vertices(body_t *body, const vector_t *vertices);
+
 /**
  * Gets the current center of mass of a body.
  * While this could be calculated with polygon_centroid(), that becomes too slow
@@ -146,6 +286,54 @@ void body_set_velocity(body_t *body, vector_t v);
  */
 void body_set_max_velocity(body_t *body, double m);
 
+/**
+ * Gets the layers a body is in.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's layers; LAYER_DEFAULT unless changed
+ */
+layer_mask_t body_get_layers(body_t *body);
+
+/**
+ * Changes the layers a body is in.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param layers the body's new layers
+ */
+void body_set_layers(body_t *body, layer_mask_t layers);
+
+/**
+ * Gets whether a body is part of the static scenery.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return whether the body is static
+ */
+bool body_is_static(body_t *body);
+
+/**
+ * Marks a body as part of the static scenery (e.g. a wall).
+ * Renderers may draw static bodies once and reuse the image
+ * until one of them changes (see body_get_version()).
+ * Static bodies can still be moved, reshaped or removed; that just
+ * costs a redraw of the scenery.
+ * Static bodies are drawn beneath all other bodies (see sdl_render_scene()).
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param is_static whether the body is static
+ */
+void body_set_static(body_t *body, bool is_static);
+
+/**
+ * Gets a number that changes whenever a body's vertices or color change.
+ * Versions are never shared between bodies, so a cache can store
+ * a body's pointer and version to tell when its entry is stale,
+ * even if the body is freed and another one reuses its memory.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's version
+ */
+uint64_t body_get_version(body_t *body);
+
 /**
  * Changes a body's velocity (the time-derivative of its position).
  *
@@ -196,6 +384,14 @@ void body_reset_rotation(body_t *body);
  */
 void body_add_force(body_t *body, vector_t force);
 
+/**
+ * Replaces the force accumulated on a body during the current tick.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param force the new total force
+ */
+void body_set_force(body_t *body, vector_t force);
+
 /**
  * Returns the force attribute of a body
  *
@@ -217,6 +413,39 @@ void body_add_impulse(body_t *body, vector_t impulse);
 
 void body_set_impulse(body_t *body, vector_t impulse);
 
+/**
+ * Gets the impulse accumulated on a body during the current tick.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the sum of the impulses added with body_add_impulse()
+ */
+vector_t body_get_impulse(body_t *body);
+
+/**
+ * Limits each component of a velocity to a body's maximum velocity.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param velocity the velocity to limit
+ * @return the velocity with each component clamped to the body's
+ *   maximum velocity set by body_set_max_velocity()
+ */
+vector_t body_clamp_velocity(body_t *body, vector_t velocity);
+
+/**
+ * Finishes a tick whose new position and velocity were computed elsewhere,
+ * e.g. by one of the scene's integrators.
+ * Moves the body to the given centroid, sets its velocity,
+ * rotates it by its angular velocity over the tick,
+ * and resets the forces and impulses accumulated on the body.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param centroid the body's new centroid
+ * @param velocity the body's new velocity
+ * @param dt the number of seconds elapsed since the last tick
+ */
+void body_end_tick(body_t *body, vector_t centroid, vector_t velocity,
+                   double dt);
+
 /**
  * Updates the body after a given time interval has elapsed.
  * Sets acceleration and velocity according to the forces and impulses
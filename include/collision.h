@@ -19,6 +19,11 @@ typedef struct {
    * If collided is false, this value is undefined.
    */
   vector_t axis;
+  /**
+   * If the shapes are colliding, how far they overlap along the axis.
+   * If collided is false, this value is undefined.
+   */
+  double depth;
 } collision_info_t;
 
 /**
@@ -34,4 +39,33 @@ typedef struct {
  */
 collision_info_t find_collision(list_t *shape1, list_t *shape2);
 
+/**
+ * Checks whether the axis-aligned bounding boxes of two shapes overlap.
+ * This is much cheaper than find_collision(), and shapes whose boxes
+ * don't overlap can't be colliding.
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @return whether the shapes' bounding boxes overlap
+ */
+bool bounding_boxes_overlap(list_t *shape1, list_t *shape2);
+
+/**
+ * Gets the number of times find_collision() has been called,
+ * by any thread, since the program started.
+ * Only counted when compiled with SCENE_PROFILE (see scene_get_stats()).
+ *
+ * @return the number of collision tests, or 0 without SCENE_PROFILE
+ */
+size_t collision_tests(void);
+
+/**
+ * Gets the number of calls to find_collision() that found a collision,
+ * by any thread, since the program started.
+ * Only counted when compiled with SCENE_PROFILE.
+ *
+ * @return the number of collisions found, or 0 without SCENE_PROFILE
+ */
+size_t collision_hits(void);
+
 #endif // #ifndef __COLLISION_H__
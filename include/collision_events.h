@@ -0,0 +1,174 @@
+#ifndef __COLLISION_EVENTS_H__
+#define __COLLISION_EVENTS_H__
+
+#include "body.h"
+#include "jobs.h"
+#include "list.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A function called when a collision occurs.
+ * @param body1 the first body passed to create_collision()
+ * @param body2 the second body passed to create_collision()
+ * @param axis a unit vector pointing from body1 towards body2
+ *   that defines the direction the two bodies are colliding in
+ * @param aux the auxiliary value passed to create_collision()
+ */
+typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
+                                    void *aux);
+
+/**
+ * A pair of bodies whose collisions are tested, with the values
+ * it was added with (see collision_events_add()).
+ */
+typedef struct {
+  body_t *body1;
+  body_t *body2;
+  collision_handler_t handler;
+  void *aux;
+  /** The number of bytes allocated for aux, or 0 if it is unknown */
+  size_t aux_size;
+  free_func_t freer;
+  size_t tag;
+  /** Whether the bodies were touching at the last detection */
+  bool touching;
+} collision_pair_t;
+
+/**
+ * A collision found during a tick, waiting for its handler to run.
+ */
+typedef struct {
+  /** The index of the pair that collided */
+  size_t pair;
+  body_t *body1;
+  body_t *body2;
+  /** A unit vector pointing from body1 towards body2 */
+  vector_t axis;
+  /** How far the bodies overlap along the axis */
+  double depth;
+  /** The tag the pair was added with */
+  size_t tag;
+} collision_event_t;
+
+/**
+ * The pairs of bodies whose collisions trigger game logic,
+ * and a queue of the collisions found in the current tick.
+ * Detection only tests the pairs and records an event each time
+ * a pair starts touching, so it can run in parallel and never changes
+ * the scene. The handlers run later, in the order the pairs were added,
+ * when the events are dispatched. This lets handlers remove bodies,
+ * add forces or play sounds without disturbing the physics step.
+ */
+typedef struct collision_events collision_events_t;
+
+/**
+ * Allocates memory for an empty set of collision pairs.
+ *
+ * @return a pointer to the newly allocated collision events
+ */
+collision_events_t *collision_events_init(void);
+
+/**
+ * Releases the memory allocated for collision events,
+ * freeing each pair's auxiliary value with its freer.
+ *
+ * @param events a pointer returned from collision_events_init()
+ */
+void collision_events_free(collision_events_t *events);
+
+/**
+ * Adds a pair of bodies to test for collisions.
+ *
+ * @param events a pointer returned from collision_events_init()
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param handler the function to call when the bodies start colliding,
+ *   or NULL to only record the events
+ * @param aux an auxiliary value to pass to the handler
+ * @param aux_size the number of bytes allocated for aux, or 0 if unknown
+ * @param freer if non-NULL, a function to call in order to free aux
+ * @param tag a value to identify the pair's events by
+ */
+void collision_events_add(collision_events_t *events, body_t *body1,
+                          body_t *body2, collision_handler_t handler, void *aux,
+                          size_t aux_size, free_func_t freer, size_t tag);
+
+/**
+ * Gets the number of pairs being tested for collisions.
+ *
+ * @param events a pointer returned from collision_events_init()
+ * @return the number of pairs
+ */
+size_t collision_events_pairs(collision_events_t *events);
+
+/**
+ * Gets a pair being tested for collisions, in the order they were added.
+ * Asserts that the index is valid.
+ *
+ * @param events a pointer returned from collision_events_init()
+ * @param index the index of the pair
+ * @return a pointer to the pair, valid until pairs are added or removed
+ */
+collision_pair_t *collision_events_get_pair(collision_events_t *events,
+                                            size_t index);
+
+/**
+ * Replaces the queued events with the collisions that started since
+ * the last detection, in the order the pairs were added.
+ * A pair only gets an event on the first detection where it touches,
+ * not again until it has stopped touching.
+ * Only reads the bodies, so it never changes the scene.
+ *
+ * @param events a pointer returned from collision_events_init()
+ * @param pool a pool to test the pairs on in parallel, or NULL
+ * @return the number of events queued
+ */
+size_t collision_events_detect(collision_events_t *events, job_pool_t *pool);
+
+/**
+ * Gets the number of events queued by the last detection.
+ *
+ * @param events a pointer returned from collision_events_init()
+ * @return the number of events
+ */
+size_t collision_events_size(collision_events_t *events);
+
+/**
+ * Gets an event queued by the last detection.
+ * Asserts that the index is valid.
+ *
+ * @param events a pointer returned from collision_events_init()
+ * @param index the index of the event
+ * @return a pointer to the event, valid until the next detection,
+ *   or until pairs are removed
+ */
+collision_event_t *collision_events_get(collision_events_t *events,
+                                        size_t index);
+
+/**
+ * Calls the handler of each queued event, in order, on the calling thread.
+ * Events are dispatched once; a second call does nothing.
+ *
+ * @param events a pointer returned from collision_events_init()
+ */
+void collision_events_dispatch(collision_events_t *events);
+
+/**
+ * Removes the pairs with a removed body, freeing their auxiliary values.
+ * The remaining pairs keep their order.
+ *
+ * @param events a pointer returned from collision_events_init()
+ * @return the number of pairs removed
+ */
+size_t collision_events_remove_dead(collision_events_t *events);
+
+/**
+ * Gets the number of bytes allocated for collision events.
+ *
+ * @param events a pointer returned from collision_events_init()
+ * @return the memory used by the pairs and the event queue, in bytes
+ */
+size_t collision_events_memory_size(collision_events_t *events);
+
+#endif // #ifndef __COLLISION_EVENTS_H__
@@ -0,0 +1,97 @@
+#ifndef __CONTACT_SOLVER_H__
+#define __CONTACT_SOLVER_H__
+
+#include "force_batch.h"
+#include "jobs.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Resolves all of a scene's physics collisions together
+ * with sequential impulses.
+ * Each tick, the solver finds which pairs are touching, then sweeps over
+ * the contacts several times. Each sweep nudges each contact's accumulated
+ * normal impulse towards the value that gives the bodies their target
+ * separating velocity, clamped so contacts only ever push.
+ * Bodies touching several others at once (a ball between a paddle and
+ * a wall, a stack of boxes) converge to impulses that agree with each other,
+ * instead of each pair overriding the last.
+ * The solve is warm started from the impulses found the previous tick,
+ * so persistent contacts converge in few sweeps.
+ * Finding the touching pairs can be spread across a job pool:
+ * a broad phase compares the pairs' bounding boxes, then a narrow phase
+ * runs find_collision() on the pairs whose boxes overlap.
+ * The sweeps themselves always run in order on the calling thread.
+ */
+typedef struct contact_solver contact_solver_t;
+
+/**
+ * Allocates memory for a contact solver.
+ *
+ * @param iterations the number of velocity sweeps per solve (at least 1)
+ * @return a pointer to the newly allocated solver
+ */
+contact_solver_t *contact_solver_init(size_t iterations);
+
+/**
+ * Releases the memory allocated for a contact solver.
+ *
+ * @param solver a pointer to a solver returned from contact_solver_init()
+ */
+void contact_solver_free(contact_solver_t *solver);
+
+/**
+ * Sets the number of velocity sweeps a contact solver makes per solve.
+ *
+ * @param solver a pointer to a solver returned from contact_solver_init()
+ * @param iterations the number of sweeps (at least 1)
+ */
+void contact_solver_set_iterations(contact_solver_t *solver,
+                                   size_t iterations);
+
+/**
+ * Gets the number of velocity sweeps a contact solver makes per solve.
+ *
+ * @param solver a pointer to a solver returned from contact_solver_init()
+ * @return the number of sweeps
+ */
+size_t contact_solver_get_iterations(contact_solver_t *solver);
+
+/**
+ * Sets whether a contact solver starts from the previous tick's impulses.
+ * Warm starting is on by default.
+ *
+ * @param solver a pointer to a solver returned from contact_solver_init()
+ * @param warm_start whether to warm start
+ */
+void contact_solver_set_warm_start(contact_solver_t *solver, bool warm_start);
+
+/**
+ * Sets the job pool a contact solver finds touching pairs on.
+ * Solvers start without a pool, and test every pair on the calling thread.
+ * The contacts are the same either way.
+ *
+ * @param solver a pointer to a solver returned from contact_solver_init()
+ * @param pool a pointer to a pool returned from job_pool_init(), or NULL
+ */
+void contact_solver_set_job_pool(contact_solver_t *solver, job_pool_t *pool);
+
+/**
+ * Resolves the physics collisions in a batch by adding impulses to the bodies.
+ * Each body's velocity at the end of the tick is predicted from its current
+ * velocity and the forces and impulses already applied this tick.
+ * The impulse along each collision axis makes the bodies separate at
+ * elasticity times the speed they approached at, or leaves them alone
+ * if they are already separating.
+ * The impulse for each pair is stored in the batch to warm start the next
+ * solve (see force_batch_get_impulse()).
+ *
+ * @param solver a pointer to a solver returned from contact_solver_init()
+ * @param contacts a batch of FORCE_PHYSICS_COLLISION forces
+ * @param dt the length of the tick, in seconds
+ * @return the number of pairs that were touching
+ */
+size_t contact_solver_solve(contact_solver_t *solver, force_batch_t *contacts,
+                            double dt);
+
+#endif // #ifndef __CONTACT_SOLVER_H__
@@ -0,0 +1,214 @@
+#ifndef __FLAT_SCENE_H__
+#define __FLAT_SCENE_H__
+
+#include "body.h"
+#include "collision_events.h"
+#include "scene.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * The index stored for a force creator's body that is not in the scene.
+ */
+#define FLAT_NO_BODY ((size_t)-1)
+
+/**
+ * A body stored in a flat scene.
+ * Its vertices are the range [vertex_start, vertex_start + vertex_count)
+ * of the flat scene's vertex buffer.
+ */
+typedef struct {
+  body_state_t state;
+  /** The body's info. Not owned by the flat scene. */
+  void *info;
+  size_t vertex_start;
+  size_t vertex_count;
+} flat_body_t;
+
+/**
+ * The kinds of forces stored in a flat scene.
+ */
+typedef enum {
+  /** Added with scene_add_bodies_force_creator() */
+  FLAT_FORCE_CREATOR,
+  /** Added with scene_add_batched_force() */
+  FLAT_BATCHED_FORCE,
+  /** A collision pair, added with create_collision() */
+  FLAT_COLLISION
+} flat_force_type_t;
+
+/**
+ * A force creator, batched force or collision pair stored in a flat scene.
+ * Its bodies are the range [body_start, body_start + body_count)
+ * of the flat scene's body index buffer.
+ */
+typedef struct {
+  flat_force_type_t type;
+  /** The force creator, or NULL for other types */
+  force_creator_t forcer;
+  /** The handler of a collision pair, which may be NULL */
+  collision_handler_t handler;
+  /**
+   * The auxiliary value of a force creator or collision pair.
+   * Not owned by the flat scene.
+   */
+  void *aux;
+  /** The kind of a batched force, or FORCE_KINDS for other types */
+  force_kind_t kind;
+  /** The constant of a batched force */
+  double constant;
+  /** The tag of a collision pair */
+  size_t tag;
+  /** Whether a collision pair's bodies were touching when captured */
+  bool touching;
+  size_t body_start;
+  size_t body_count;
+} flat_force_t;
+
+/**
+ * A relocatable copy of a scene's bodies, vertices, forces and fields.
+ * Everything lives in a few contiguous buffers that refer to each other
+ * by index instead of by pointer, so copying a flat scene is just a memcpy()
+ * of each buffer. Info and aux values are shared with the scene, not copied.
+ */
+typedef struct flat_scene flat_scene_t;
+
+/**
+ * Allocates memory for an empty flat scene.
+ *
+ * @return the new flat scene
+ */
+flat_scene_t *flat_scene_init(void);
+
+/**
+ * Releases the memory allocated for a flat scene.
+ *
+ * @param flat a pointer to a flat scene returned from flat_scene_init()
+ */
+void flat_scene_free(flat_scene_t *flat);
+
+/**
+ * Packs the current state of a scene into a flat scene,
+ * reusing the flat scene's buffers when they are large enough.
+ *
+ * @param flat a pointer to a flat scene returned from flat_scene_init()
+ * @param scene the scene to capture
+ */
+void flat_scene_capture(flat_scene_t *flat, scene_t *scene);
+
+/**
+ * Copies one flat scene into another with one memcpy() per buffer.
+ *
+ * @param dst the flat scene to overwrite
+ * @param src the flat scene to copy
+ */
+void flat_scene_copy(flat_scene_t *dst, flat_scene_t *src);
+
+/**
+ * Allocates a new flat scene holding a copy of another.
+ *
+ * @param src the flat scene to copy
+ * @return the new flat scene
+ */
+flat_scene_t *flat_scene_clone(flat_scene_t *src);
+
+/**
+ * Writes the body states and vertices stored in a flat scene
+ * back into the scene they were captured from, along with whether
+ * each collision pair was touching, so the same collisions start again.
+ * Asserts that the scene still has the same bodies, vertex counts and
+ * collision pairs. The forces and fields themselves are not changed.
+ *
+ * @param flat a flat scene captured from the scene
+ * @param scene the scene to restore
+ */
+void flat_scene_restore(flat_scene_t *flat, scene_t *scene);
+
+/**
+ * Gets the number of bodies in a flat scene.
+ *
+ * @param flat a pointer to a flat scene returned from flat_scene_init()
+ * @return the number of bodies captured
+ */
+size_t flat_scene_bodies(flat_scene_t *flat);
+
+/**
+ * Gets the body at a given index in a flat scene.
+ * Asserts that the index is valid.
+ *
+ * @param flat a pointer to a flat scene returned from flat_scene_init()
+ * @param index the index of the body (the same as in the captured scene)
+ * @return a pointer to the body record, valid until the flat scene changes
+ */
+flat_body_t *flat_scene_get_body(flat_scene_t *flat, size_t index);
+
+/**
+ * Gets the vertices of the body at a given index in a flat scene.
+ * Asserts that the index is valid.
+ *
+ * @param flat a pointer to a flat scene returned from flat_scene_init()
+ * @param index the index of the body
+ * @return a pointer to the body's first vertex in the vertex buffer
+ */
+vector_t *flat_scene_get_vertices(flat_scene_t *flat, size_t index);
+
+/**
+ * Gets the number of forces in a flat scene.
+ * The scene's force creators come first, followed by its batched forces,
+ * then its collision pairs (see scene_get_collision_events()).
+ *
+ * @param flat a pointer to a flat scene returned from flat_scene_init()
+ * @return the number of force creators, batched forces and collision
+ *   pairs captured
+ */
+size_t flat_scene_forces(flat_scene_t *flat);
+
+/**
+ * Gets the force at a given index in a flat scene.
+ * Asserts that the index is valid.
+ *
+ * @param flat a pointer to a flat scene returned from flat_scene_init()
+ * @param index the index of the force creator
+ * @return a pointer to the force record, valid until the flat scene changes
+ */
+flat_force_t *flat_scene_get_force(flat_scene_t *flat, size_t index);
+
+/**
+ * Gets the index of one of a force's bodies in a flat scene.
+ * Asserts that both indices are valid.
+ *
+ * @param flat a pointer to a flat scene returned from flat_scene_init()
+ * @param force the index of the force
+ * @param body the index of the body within the force's body list
+ * @return the index of the body in the flat scene, or FLAT_NO_BODY
+ */
+size_t flat_scene_get_force_body(flat_scene_t *flat, size_t force,
+                                 size_t body);
+
+/**
+ * Gets the number of force fields in a flat scene.
+ *
+ * @param flat a pointer to a flat scene returned from flat_scene_init()
+ * @return the number of fields captured
+ */
+size_t flat_scene_fields(flat_scene_t *flat);
+
+/**
+ * Gets the force field at a given index in a flat scene.
+ * Asserts that the index is valid.
+ *
+ * @param flat a pointer to a flat scene returned from flat_scene_init()
+ * @param index the index of the field (the same as in the captured scene)
+ * @return a pointer to the field, valid until the flat scene changes
+ */
+force_field_t *flat_scene_get_field(flat_scene_t *flat, size_t index);
+
+/**
+ * Gets the number of bytes used by a flat scene's buffers.
+ *
+ * @param flat a pointer to a flat scene returned from flat_scene_init()
+ * @return the memory used by the flat scene, in bytes
+ */
+size_t flat_scene_memory_size(flat_scene_t *flat);
+
+#endif // #ifndef __FLAT_SCENE_H__
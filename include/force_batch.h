@@ -0,0 +1,155 @@
+#ifndef __FORCE_BATCH_H__
+#define __FORCE_BATCH_H__
+
+#include "body.h"
+#include <stddef.h>
+
+/**
+ * Gravity is not applied between bodies closer than this,
+ * since its magnitude blows up as the distance goes to 0.
+ */
+extern const double MIN_GRAVITY_DISTANCE;
+
+/**
+ * The kinds of built-in forces that are evaluated in batches.
+ * Each kind's parameters are stored in typed arrays
+ * and applied in a single loop, instead of one force creator call each.
+ */
+typedef enum {
+  /** Drag on one body, proportional to its velocity */
+  FORCE_DRAG,
+  /** A Hooke's-law spring between two bodies */
+  FORCE_SPRING,
+  /** Newtonian gravity between two bodies */
+  FORCE_GRAVITY,
+  /**
+   * A contact between two bodies, resolved with impulses
+   * by the contact solver (see contact_solver.h)
+   */
+  FORCE_PHYSICS_COLLISION,
+  FORCE_KINDS
+} force_kind_t;
+
+/**
+ * A growable collection of forces of one kind.
+ * Stores the bodies and constant of each force in parallel arrays.
+ */
+typedef struct force_batch force_batch_t;
+
+/**
+ * Allocates memory for an empty batch of forces of the given kind.
+ *
+ * @param kind the kind of force stored in the batch
+ * @param initial_size the number of forces to allocate space for
+ * @return a pointer to the newly allocated batch
+ */
+force_batch_t *force_batch_init(force_kind_t kind, size_t initial_size);
+
+/**
+ * Releases the memory allocated for a batch.
+ * Does not free the bodies.
+ *
+ * @param batch a pointer to a batch returned from force_batch_init()
+ */
+void force_batch_free(force_batch_t *batch);
+
+/**
+ * Gets the kind of force stored in a batch.
+ *
+ * @param batch a pointer to a batch returned from force_batch_init()
+ * @return the kind passed to force_batch_init()
+ */
+force_kind_t force_batch_kind(force_batch_t *batch);
+
+/**
+ * Gets the number of forces in a batch.
+ *
+ * @param batch a pointer to a batch returned from force_batch_init()
+ * @return the number of forces added with force_batch_add()
+ */
+size_t force_batch_size(force_batch_t *batch);
+
+/**
+ * Adds a force to a batch.
+ *
+ * @param batch a pointer to a batch returned from force_batch_init()
+ * @param constant the force's constant: gamma for drag, k for springs,
+ *   G for gravity, or the elasticity of a physics collision
+ * @param body1 the first body
+ * @param body2 the second body, or NULL for drag
+ */
+void force_batch_add(force_batch_t *batch, double constant, body_t *body1,
+                     body_t *body2);
+
+/**
+ * Gets the constant of the force at a given index in a batch.
+ * Asserts that the index is valid.
+ *
+ * @param batch a pointer to a batch returned from force_batch_init()
+ * @param index the index of the force (starting at 0)
+ * @return the constant passed to force_batch_add()
+ */
+double force_batch_get_constant(force_batch_t *batch, size_t index);
+
+/**
+ * Gets the normal impulse the contact solver applied to
+ * the physics collision at a given index during the last tick.
+ * Asserts that the index is valid.
+ *
+ * @param batch a pointer to a batch returned from force_batch_init()
+ * @param index the index of the force (starting at 0)
+ * @return the impulse, or 0 if the bodies were not touching
+ */
+double force_batch_get_impulse(force_batch_t *batch, size_t index);
+
+/**
+ * Stores the normal impulse applied to the physics collision at a given index,
+ * so the next solve can start from it.
+ * Asserts that the index is valid.
+ *
+ * @param batch a pointer to a batch returned from force_batch_init()
+ * @param index the index of the force (starting at 0)
+ * @param impulse the magnitude of the impulse along the collision axis
+ */
+void force_batch_set_impulse(force_batch_t *batch, size_t index,
+                             double impulse);
+
+/**
+ * Gets one of the bodies of the force at a given index in a batch.
+ * Asserts that the index is valid.
+ *
+ * @param batch a pointer to a batch returned from force_batch_init()
+ * @param index the index of the force (starting at 0)
+ * @param which 0 for the first body, 1 for the second
+ * @return the body, or NULL for the second body of a drag force
+ */
+body_t *force_batch_get_body(force_batch_t *batch, size_t index, size_t which);
+
+/**
+ * Applies every force in a batch to its bodies.
+ * Forces and impulses are accumulated on the bodies as in body_add_force().
+ * Does nothing for physics collisions, which need the whole scene's
+ * contacts at once; see contact_solver_solve().
+ *
+ * @param batch a pointer to a batch returned from force_batch_init()
+ */
+void force_batch_apply(force_batch_t *batch);
+
+/**
+ * Removes every force that acts on a body marked for removal,
+ * preserving the order of the remaining forces.
+ *
+ * @param batch a pointer to a batch returned from force_batch_init()
+ * @return the number of forces removed
+ */
+size_t force_batch_remove_dead(force_batch_t *batch);
+
+/**
+ * Gets the number of bytes a batch has allocated.
+ *
+ * @param batch a pointer to a batch returned from force_batch_init()
+ * @return the memory used by the batch, in bytes
+ */
+size_t force_batch_memory_size(force_batch_t *batch);
+
+#endif // #ifndef __FORCE_BATCH_H__
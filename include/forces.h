@@ -2,17 +2,7 @@
 #define __FORCES_H__
 
 #include "scene.h"
-
-/**
- * A function called when a collision occurs.
- * @param body1 the first body passed to create_collision()
- * @param body2 the second body passed to create_collision()
- * @param axis a unit vector pointing from body1 towards body2
- *   that defines the direction the two bodies are colliding in
- * @param aux the auxiliary value passed to create_collision()
- */
-typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
-                                    void *aux);
+#include "spring_network.h"
 
 /**
  * Holds auxillary data necessary for force handler.
@@ -42,6 +32,20 @@ typedef struct aux {
 void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
                               body_t *body2);
 
+/**
+ * Adds a force creator to a scene that applies gravity
+ * between every pair of bodies in the scene with finite mass,
+ * including bodies added after the force creator.
+ * Each tick builds a Barnes-Hut quadtree over the bodies (see nbody.h),
+ * so the forces on N bodies are computed in O(N log N).
+ *
+ * @param scene the scene containing the bodies
+ * @param G the gravitational proportionality constant
+ * @param theta the Barnes-Hut opening angle (around 0.5 is typical).
+ *   0 selects the brute-force reference, which sums over every pair.
+ */
+void create_nbody_gravity(scene_t *scene, double G, double theta);
+
 /**
  * Adds a force creator to a scene that acts like a spring between two bodies.
  * The force creator will be called each tick
@@ -55,6 +59,18 @@ void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
  */
 void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2);
 
+/**
+ * Adds a force creator to a scene that applies every spring in a network.
+ * The force creator will be called each tick
+ * to evaluate all of the network's springs in one pass.
+ * Bodies and springs should be added to the network before this is called;
+ * the force creator is removed if any of the network's bodies are removed.
+ *
+ * @param scene the scene containing the bodies
+ * @param network a spring network, which the scene takes ownership of
+ */
+void create_spring_network(scene_t *scene, spring_network_t *network);
+
 /**
  * Adds a force creator to a scene that applies a drag force on a body.
  * The force creator will be called each tick
@@ -69,12 +85,16 @@ void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2);
 void create_drag(scene_t *scene, double gamma, body_t *body);
 
 /**
- * Adds a force creator to a scene that calls a given collision handler
- * function each time two bodies collide.
+ * Adds a pair of bodies to a scene whose collisions call a given collision
+ * handler function each time they start colliding.
  * This generalizes create_destructive_collision() from last week,
  * allowing different things to happen on a collision.
  * The handler is passed the bodies, the collision axis, and an auxiliary value.
  * It should only be called once while the bodies are still colliding.
+ * Collisions are detected at the start of each tick, but the handlers run
+ * after the bodies have moved (see scene_tick()), in the order the pairs
+ * were added, so they may freely change the scene.
+ * The pair is removed when either body is removed.
  *
  * @param scene the scene containing the bodies
  * @param body1 the first body
@@ -88,7 +108,40 @@ void create_collision(scene_t *scene, body_t *body1, body_t *body2,
                       free_func_t freer);
 
 /**
- * Adds a force creator to a scene that destroys two bodies when they collide.
+ * Adds a collision like create_collision(), tagging the events the pair
+ * queues so they can be told apart (see scene_get_collision_events()).
+ *
+ * @param scene the scene containing the bodies
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param handler a function to call whenever the bodies collide,
+ *   or NULL to only queue the events
+ * @param aux an auxiliary value to pass to the handler
+ * @param freer if non-NULL, a function to call in order to free aux
+ * @param tag a value to identify the pair's events by
+ */
+void create_tagged_collision(scene_t *scene, body_t *body1, body_t *body2,
+                             collision_handler_t handler, void *aux,
+                             free_func_t freer, size_t tag);
+
+/**
+ * Adds a collision like create_collision(), recording the size of its
+ * auxiliary value for scene_memory_stats().
+ *
+ * @param scene the scene containing the bodies
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param handler a function to call whenever the bodies collide
+ * @param aux an auxiliary value to pass to the handler
+ * @param aux_size the number of bytes allocated for aux
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void create_sized_collision(scene_t *scene, body_t *body1, body_t *body2,
+                            collision_handler_t handler, void *aux,
+                            size_t aux_size, free_func_t freer);
+
+/**
+ * Adds a collision to a scene that destroys two bodies when they collide.
  * The bodies should be destroyed by calling body_remove().
  * This should be represented as an on-collision callback
  * registered with create_collision().
@@ -102,13 +155,12 @@ void create_destructive_collision(scene_t *scene, body_t *body1, body_t *body2);
 /**
  * Adds a force creator to a scene that applies impulses
  * to resolve collisions between two bodies in the scene.
- * This should be represented as an on-collision callback
- * registered with create_collision().
- *
- * You may remember from project01 that you should avoid applying impulses
- * multiple times while the bodies are still colliding.
- * You should also have a special case that allows either body1 or body2
- * to have mass INFINITY, as this is useful for simulating walls.
+ * The scene's contact solver resolves all of its physics collisions together
+ * each tick (see contact_solver.h), so a body touching several others
+ * gets impulses that agree with each other.
+ * Impulses are only applied while the bodies are approaching each other,
+ * and either body1 or body2 may have mass INFINITY,
+ * which is useful for simulating walls.
  *
  * @param scene the scene containing the bodies
  * @param elasticity the "coefficient of restitution" of the collision;
@@ -119,6 +171,17 @@ void create_destructive_collision(scene_t *scene, body_t *body1, body_t *body2);
 void create_physics_collision(scene_t *scene, double elasticity, body_t *body1,
                               body_t *body2);
 
+/**
+ * Adds a force creator to a scene that bounces a body off a spinning body,
+ * taking the second body's angular velocity into account.
+ * Unlike create_collision(), the impulse is applied as soon as
+ * the collision is found, since it is part of the physics step.
+ *
+ * @param scene the scene containing the bodies
+ * @param elasticity the "coefficient of restitution" of the collision
+ * @param body1 the first body
+ * @param body2 the second, spinning body
+ */
 void create_angular_collision(scene_t *scene, double elasticity, body_t *body1,
                               body_t *body2);
 
@@ -0,0 +1,94 @@
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The kinds of input events.
+ */
+typedef enum { INPUT_KEY, INPUT_BUTTON, INPUT_AXIS } input_kind_t;
+
+/**
+ * A key, controller button or controller axis event,
+ * already translated from the windowing library's representation.
+ */
+typedef struct {
+  input_kind_t kind;
+  /** When the event happened, in milliseconds */
+  uint32_t timestamp;
+  /** The key, button or axis, as passed to the handlers in sdl_wrapper.h */
+  char key;
+  /** The controller the event came from; unused for keys */
+  int which;
+  /** Whether a key or button was pressed (true) or released (false) */
+  bool pressed;
+  /** The position of an axis */
+  int value;
+  /** How long a key or button has been held, in seconds */
+  double held_time;
+} input_event_t;
+
+/**
+ * A fixed-size ring buffer of input events, filled as events arrive
+ * and drained once per frame, oldest first.
+ *
+ * An analog stick reports many positions per frame but only the last
+ * matters, so an axis event replaces any queued event for the same axis
+ * of the same controller, keeping its place in the queue. Events that
+ * arrive when the buffer is full are dropped and counted.
+ */
+typedef struct input_buffer input_buffer_t;
+
+/**
+ * Allocates an empty input buffer.
+ *
+ * @param capacity the maximum number of events it holds; positive
+ * @return a pointer to the newly allocated buffer
+ */
+input_buffer_t *input_buffer_init(size_t capacity);
+
+/**
+ * Releases the memory allocated for an input buffer.
+ *
+ * @param buffer a pointer returned from input_buffer_init()
+ */
+void input_buffer_free(input_buffer_t *buffer);
+
+/**
+ * Adds an event to the end of an input buffer,
+ * or coalesces it with a queued event for the same axis.
+ *
+ * @param buffer a pointer returned from input_buffer_init()
+ * @param event the event to add
+ * @return false if the buffer was full and the event was dropped
+ */
+bool input_buffer_push(input_buffer_t *buffer, input_event_t event);
+
+/**
+ * Removes the oldest event from an input buffer.
+ *
+ * @param buffer a pointer returned from input_buffer_init()
+ * @param event where to store the event
+ * @return false if the buffer was empty
+ */
+bool input_buffer_pop(input_buffer_t *buffer, input_event_t *event);
+
+/**
+ * Gets the number of events queued in an input buffer.
+ *
+ * @param buffer a pointer returned from input_buffer_init()
+ * @return the number of events
+ */
+size_t input_buffer_size(input_buffer_t *buffer);
+
+/**
+ * Gets the number of events dropped because an input buffer was full.
+ *
+ * @param buffer a pointer returned from input_buffer_init()
+ * @return the number of events dropped since the buffer was created
+ */
+size_t input_buffer_dropped(input_buffer_t *buffer);
+
+#endif // #ifndef __INPUT_H__
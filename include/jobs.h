@@ -0,0 +1,114 @@
+#ifndef __JOBS_H__
+#define __JOBS_H__
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+/**
+ * A task that can run on any of a pool's threads.
+ *
+ * @param aux the auxiliary value passed to job_pool_spawn()
+ */
+typedef void (*job_task_t)(void *aux);
+
+/**
+ * A function that performs one item of a parallel loop.
+ *
+ * @param aux the auxiliary value passed to job_pool_parallel_for()
+ * @param index the index of the item, from 0 up to the item count
+ */
+typedef void (*job_func_t)(void *aux, size_t index);
+
+/**
+ * Counts the tasks spawned into it that have not finished yet.
+ * Usually lives on the stack of the function that spawns the tasks,
+ * which must call job_pool_join() on it before returning.
+ */
+typedef struct job_join {
+  atomic_size_t pending;
+} job_join_t;
+
+/**
+ * A fixed set of worker threads that run tasks with work stealing.
+ * Each thread keeps its own deque of tasks. It pushes the tasks it spawns
+ * and pops them back from the same end, so it works on the most recently
+ * spawned (smallest, hottest) tasks first. Idle threads steal from the
+ * other end of other threads' deques, taking the oldest (largest) tasks.
+ *
+ * The thread that created the pool acts as one of its threads while it
+ * spawns tasks or waits for them. Only one thread outside the pool may use
+ * it at a time. Under Emscripten, where the demos are built without
+ * threads, every task runs as soon as it is spawned.
+ */
+typedef struct job_pool job_pool_t;
+
+/**
+ * Allocates a pool and starts its worker threads.
+ *
+ * @param threads the total number of threads to run tasks on,
+ *   including the caller's; 1 runs every task on the caller's thread
+ * @return a pointer to the newly allocated pool
+ */
+job_pool_t *job_pool_init(size_t threads);
+
+/**
+ * Stops a pool's worker threads and releases its memory.
+ * Must not be called while any task is running.
+ *
+ * @param pool a pointer to a pool returned from job_pool_init()
+ */
+void job_pool_free(job_pool_t *pool);
+
+/**
+ * Gets the number of threads a pool runs tasks on.
+ *
+ * @param pool a pointer to a pool returned from job_pool_init()
+ * @return the number of threads, including the caller's
+ */
+size_t job_pool_threads(job_pool_t *pool);
+
+/**
+ * Prepares a join to have tasks spawned into it.
+ *
+ * @param join a pointer to the join
+ */
+void job_join_init(job_join_t *join);
+
+/**
+ * Queues a task to run on one of a pool's threads (fork).
+ * Tasks may spawn more tasks and wait for them. The allocations a task
+ * makes are counted as the spawning thread's (see mem_count_calls()).
+ *
+ * @param pool a pointer to a pool returned from job_pool_init()
+ * @param join the join to wait on for the task (see job_pool_join())
+ * @param task the function to run
+ * @param aux an auxiliary value to pass to the task;
+ *   it must stay valid until the task has been joined
+ */
+void job_pool_spawn(job_pool_t *pool, job_join_t *join, job_task_t task,
+                    void *aux);
+
+/**
+ * Waits for every task spawned into a join to finish (join).
+ * The waiting thread runs other queued tasks in the meantime.
+ *
+ * @param pool a pointer to a pool returned from job_pool_init()
+ * @param join the join the tasks were spawned into
+ */
+void job_pool_join(job_pool_t *pool, job_join_t *join);
+
+/**
+ * Calls a function once for each index from 0 to count - 1,
+ * spreading the calls across the pool's threads in no particular order.
+ * The range is split in halves recursively into tasks, down to a few
+ * chunks per thread. Returns once every call has finished.
+ *
+ * @param pool a pointer to a pool returned from job_pool_init()
+ * @param count the number of items
+ * @param func the function to call for each item
+ * @param aux an auxiliary value to pass to each call
+ */
+void job_pool_parallel_for(job_pool_t *pool, size_t count, job_func_t func,
+                           void *aux);
+
+#endif // #ifndef __JOBS_H__
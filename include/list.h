@@ -2,6 +2,7 @@
 #define __LIST_H__
 
 #include "poly_list.h"
+#include <stdbool.h>
 #include <stddef.h>
 
 /**
@@ -17,6 +18,12 @@ typedef struct list list_t;
  */
 typedef void (*free_func_t)(void *);
 
+/**
+ * A predicate that can be called on list elements, e.g. to select elements
+ * for list_erase_if(). Takes in an auxiliary value that can store parameters.
+ */
+typedef bool (*list_pred_t)(void *value, void *aux);
+
 /**
  * Allocates memory for a new list with space for the given number of elements.
  * The list is initially empty.
@@ -45,6 +52,15 @@ void list_free(list_t *list);
  */
 size_t list_size(list_t *list);
 
+/**
+ * Gets the number of bytes a list has allocated for itself,
+ * i.e. its header and its capacity. Does not include the elements.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @return the memory used by the list, in bytes
+ */
+size_t list_memory_size(list_t *list);
+
 /**
  * Gets the element at a given index in a list.
  * Asserts that the index is valid, given the list's current size.
@@ -76,4 +92,58 @@ void *list_remove(list_t *list, size_t index);
  */
 void list_add(list_t *list, void *value);
 
+/**
+ * Ensures a list has space for at least the given number of elements,
+ * so that many elements can be added without further resizing.
+ * Does nothing if the list's capacity is already large enough.
+ * Asserts that the resize succeeded.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param capacity the number of elements to allocate space for
+ */
+void list_reserve(list_t *list, size_t capacity);
+
+/**
+ * Releases any capacity a list holds beyond its current size.
+ * An empty list keeps space for one element.
+ *
+ * @param list a pointer to a list returned from list_init()
+ */
+void list_shrink_to_fit(list_t *list);
+
+/**
+ * Appends all the elements of one list to the end of another,
+ * resizing the destination list at most once.
+ * The elements are not copied, so the source list should not free them
+ * if both lists are freed.
+ *
+ * @param list a pointer to the list to append to
+ * @param other a pointer to the list whose elements are appended
+ */
+void list_extend(list_t *list, list_t *other);
+
+/**
+ * Removes the element at a given index in a list and returns it,
+ * moving the last element of the list into its place.
+ * Runs in constant time, but does not preserve the order of the list.
+ * Asserts that the index is valid, given the list's current size.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param index an index in the list (the first element is at 0)
+ * @return the element at the given index in the list
+ */
+void *list_swap_remove(list_t *list, size_t index);
+
+/**
+ * Removes every element of a list for which a predicate returns true,
+ * in a single pass that preserves the order of the remaining elements.
+ * Removed elements are released with the list's freer, if it has one.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param pred the predicate selecting which elements to remove
+ * @param aux an auxiliary value to pass to pred when it is called
+ * @return the number of elements removed
+ */
+size_t list_erase_if(list_t *list, list_pred_t pred, void *aux);
+
 #endif // #ifndef __LIST_H__
@@ -0,0 +1,110 @@
+#ifndef __MEM_STATS_H__
+#define __MEM_STATS_H__
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+/**
+ * The kinds of allocations made by the engine.
+ * Library allocations go through mem_alloc(), mem_realloc() and mem_free(),
+ * tagged with the kind that best describes what the memory is used for.
+ */
+typedef enum {
+  MEM_LIST,
+  MEM_BODY,
+  MEM_VERTEX,
+  MEM_SCENE,
+  MEM_FORCE,
+  MEM_AUX,
+  MEM_FLAT,
+  MEM_TIMING,
+  MEM_INPUT,
+  MEM_ASSET,
+  MEM_AUDIO,
+  MEM_KINDS
+} mem_kind_t;
+
+/**
+ * Allocates memory like malloc() and records the allocation.
+ * Asserts that the required memory was allocated.
+ *
+ * @param kind what the memory is used for
+ * @param size the number of bytes to allocate
+ * @return a pointer to the newly allocated memory
+ */
+void *mem_alloc(mem_kind_t kind, size_t size);
+
+/**
+ * Resizes memory like realloc() and records the reallocation.
+ * Asserts that the required memory was allocated.
+ * A new size of 0 frees the memory like mem_free() and returns NULL.
+ *
+ * @param kind what the memory is used for
+ * @param ptr memory returned from mem_alloc() or mem_realloc(), or NULL
+ * @param old_size the number of bytes currently allocated at ptr
+ * @param new_size the number of bytes to allocate
+ * @return a pointer to the resized memory
+ */
+void *mem_realloc(mem_kind_t kind, void *ptr, size_t old_size,
+                  size_t new_size);
+
+/**
+ * Releases memory returned from mem_alloc() or mem_realloc().
+ *
+ * @param kind the kind the memory was allocated with
+ * @param ptr the memory to free
+ * @param size the number of bytes allocated at ptr
+ */
+void mem_free(mem_kind_t kind, void *ptr, size_t size);
+
+/**
+ * Frees a vector allocated with mem_alloc(MEM_VERTEX, sizeof(vector_t)).
+ * Can be used as the freer of a vertex list.
+ *
+ * @param vertex the vector to free
+ */
+void mem_vertex_free(void *vertex);
+
+/**
+ * Gets the number of allocator calls (allocations and reallocations)
+ * made through the counting wrappers since the program started.
+ *
+ * @return the total number of allocator calls
+ */
+size_t mem_alloc_calls(void);
+
+/**
+ * Charges the allocator calls the calling thread makes to a counter,
+ * as well as to mem_alloc_calls(), until another counter replaces it.
+ * Tasks run by a job pool are charged to the counter of the thread
+ * that spawned them (see jobs.h).
+ *
+ * @param counter the counter to add to, or NULL to stop counting
+ * @return the counter it replaces, to be restored afterwards
+ */
+atomic_size_t *mem_count_calls(atomic_size_t *counter);
+
+/**
+ * Gets the counter the calling thread's allocator calls are charged to.
+ *
+ * @return the counter set with mem_count_calls(), or NULL
+ */
+atomic_size_t *mem_call_counter(void);
+
+/**
+ * Gets the number of bytes currently allocated for a given kind.
+ *
+ * @param kind the kind of allocation
+ * @return the number of live bytes of that kind
+ */
+size_t mem_live_bytes(mem_kind_t kind);
+
+/**
+ * Gets the number of live allocations of a given kind.
+ *
+ * @param kind the kind of allocation
+ * @return the number of allocations of that kind not yet freed
+ */
+size_t mem_live_count(mem_kind_t kind);
+
+#endif // #ifndef __MEM_STATS_H__
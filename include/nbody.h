@@ -0,0 +1,72 @@
+#ifndef __NBODY_H__
+#define __NBODY_H__
+
+#include "scene.h"
+#include <stddef.h>
+
+/**
+ * Newtonian gravity between every pair of bodies in a scene.
+ * Each call to nbody_apply() builds a Barnes-Hut quadtree over the bodies
+ * and approximates distant groups of bodies by their center of mass,
+ * computing all the forces in O(N log N) instead of O(N^2).
+ * Bodies with infinite mass are ignored.
+ * The tree is stored in buffers that are reused from tick to tick.
+ */
+typedef struct nbody nbody_t;
+
+/**
+ * Allocates memory for an N-body gravity field.
+ *
+ * @param G the gravitational proportionality constant
+ * @param theta the Barnes-Hut opening angle. A group of bodies of width s
+ *   at distance d is approximated by its center of mass when s / d < theta.
+ *   Larger values are faster but less accurate; 0 computes every pair.
+ * @return a pointer to the newly allocated field
+ */
+nbody_t *nbody_init(double G, double theta);
+
+/**
+ * Releases the memory allocated for an N-body gravity field.
+ * Does not free the scene.
+ *
+ * @param nbody a pointer to a field returned from nbody_init()
+ */
+void nbody_free(nbody_t *nbody);
+
+/**
+ * Gets the opening angle of an N-body gravity field.
+ *
+ * @param nbody a pointer to a field returned from nbody_init()
+ * @return the opening angle passed to nbody_init()
+ */
+double nbody_get_theta(nbody_t *nbody);
+
+/**
+ * Adds the gravitational force on each body in a scene from all the others,
+ * using the Barnes-Hut approximation.
+ * Gravity is not applied between bodies closer than MIN_GRAVITY_DISTANCE.
+ *
+ * @param nbody a pointer to a field returned from nbody_init()
+ * @param scene the scene containing the bodies
+ */
+void nbody_apply(nbody_t *nbody, scene_t *scene);
+
+/**
+ * Adds the gravitational force on each body in a scene from all the others
+ * by summing over every pair of bodies. This is the O(N^2) reference
+ * that nbody_apply() approximates, useful for checking its accuracy.
+ *
+ * @param nbody a pointer to a field returned from nbody_init()
+ * @param scene the scene containing the bodies
+ */
+void nbody_apply_brute_force(nbody_t *nbody, scene_t *scene);
+
+/**
+ * Gets the number of quadtree nodes built by the last call to nbody_apply().
+ *
+ * @param nbody a pointer to a field returned from nbody_init()
+ * @return the number of nodes in the tree
+ */
+size_t nbody_tree_size(nbody_t *nbody);
+
+#endif // #ifndef __NBODY_H__
@@ -47,4 +47,22 @@ void polygon_translate(list_t *polygon, vector_t translation);
  */
 void polygon_rotate(list_t *polygon, double angle, vector_t point);
 
+/**
+ * Splits a simple polygon into triangles.
+ * Convex polygons are split into a triangle fan in linear time;
+ * others are split by ear clipping, which works for concave polygons
+ * listed in either direction. Each triangle is listed in the same
+ * direction as the polygon. Allocates no memory.
+ * See https://en.wikipedia.org/wiki/Polygon_triangulation#Ear_clipping_method.
+ *
+ * @param polygon the list of vertices that make up the polygon,
+ *   with at least 3 vertices
+ * @param indices an array to store 3 vertex indices per triangle in;
+ *   must have room for 3 * (size - 2) indices
+ * @param scratch an array the caller keeps for reuse across calls;
+ *   must have room for size indices
+ * @return the number of triangles, size - 2
+ */
+size_t polygon_triangulate(list_t *polygon, size_t *indices, size_t *scratch);
+
 #endif // #ifndef __POLYGON_H__
@@ -0,0 +1,75 @@
+#ifndef __PTR_MAP_H__
+#define __PTR_MAP_H__
+
+#include "mem_stats.h"
+#include <stddef.h>
+
+/**
+ * A hash map from pointers (e.g. bodies) to indices.
+ * Uses open addressing with linear probing in flat arrays,
+ * and keeps its memory when cleared so it can be refilled every tick
+ * without allocating.
+ */
+typedef struct ptr_map ptr_map_t;
+
+/**
+ * Allocates memory for an empty map.
+ *
+ * @param kind what the map's memory is counted as (see mem_stats.h)
+ * @param initial_size the number of keys to allocate space for
+ * @return a pointer to the newly allocated map
+ */
+ptr_map_t *ptr_map_init(mem_kind_t kind, size_t initial_size);
+
+/**
+ * Releases the memory allocated for a map.
+ * Does not free the keys.
+ *
+ * @param map a pointer to a map returned from ptr_map_init()
+ */
+void ptr_map_free(ptr_map_t *map);
+
+/**
+ * Removes every key from a map, keeping room for a given number of keys.
+ *
+ * @param map a pointer to a map returned from ptr_map_init()
+ * @param expected_size the number of keys about to be added
+ */
+void ptr_map_clear(ptr_map_t *map, size_t expected_size);
+
+/**
+ * Maps a key to a value, replacing any value it had.
+ *
+ * @param map a pointer to a map returned from ptr_map_init()
+ * @param key the key, which must not be NULL
+ * @param value the value
+ */
+void ptr_map_put(ptr_map_t *map, const void *key, size_t value);
+
+/**
+ * Gets the value of a key in a map.
+ *
+ * @param map a pointer to a map returned from ptr_map_init()
+ * @param key the key
+ * @param missing the value to return if the key is not in the map
+ * @return the key's value, or missing
+ */
+size_t ptr_map_get(ptr_map_t *map, const void *key, size_t missing);
+
+/**
+ * Gets the number of keys in a map.
+ *
+ * @param map a pointer to a map returned from ptr_map_init()
+ * @return the number of distinct keys added since the last clear
+ */
+size_t ptr_map_size(ptr_map_t *map);
+
+/**
+ * Gets the number of bytes a map has allocated.
+ *
+ * @param map a pointer to a map returned from ptr_map_init()
+ * @return the memory used by the map, in bytes
+ */
+size_t ptr_map_memory_size(ptr_map_t *map);
+
+#endif // #ifndef __PTR_MAP_H__
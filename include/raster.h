@@ -0,0 +1,101 @@
+#ifndef __RASTER_H__
+#define __RASTER_H__
+
+#include "color.h"
+#include "list.h"
+#include "scene.h"
+#include "vector.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * An offscreen image that scenes can be drawn into without SDL or a display.
+ * It maps scene coordinates to pixels the same way sdl_wrapper.c maps them
+ * to the window, and draws bodies the same way: from their cached meshes
+ * (see body_get_mesh()), one triangle at a time.
+ * Drawing is deterministic, so frames can be hashed and compared
+ * in regression tests, and render benchmarks can run on a headless machine.
+ *
+ * Pixels are filled when their centers lie inside a triangle. Pixels whose
+ * centers lie exactly on an edge shared by two triangles belong to exactly
+ * one of them, so a polygon covers each pixel at most once.
+ */
+typedef struct raster raster_t;
+
+/**
+ * Allocates an image, cleared to white.
+ *
+ * @param min the x and y coordinates of the bottom left of the scene
+ * @param max the x and y coordinates of the top right of the scene
+ * @param width the width of the image in pixels
+ * @param height the height of the image in pixels
+ * @return a pointer to the newly allocated image
+ */
+raster_t *raster_init(vector_t min, vector_t max, size_t width, size_t height);
+
+/**
+ * Releases the memory allocated for an image.
+ *
+ * @param raster a pointer returned from raster_init()
+ */
+void raster_free(raster_t *raster);
+
+/**
+ * Gets the width of an image.
+ *
+ * @param raster a pointer returned from raster_init()
+ * @return the width in pixels
+ */
+size_t raster_width(raster_t *raster);
+
+/**
+ * Gets the height of an image.
+ *
+ * @param raster a pointer returned from raster_init()
+ * @return the height in pixels
+ */
+size_t raster_height(raster_t *raster);
+
+/**
+ * Gets the pixels of an image, row by row from the top,
+ * with 4 bytes (red, green, blue, alpha) per pixel.
+ *
+ * @param raster a pointer returned from raster_init()
+ * @return the pixels, valid until the image is freed
+ */
+const uint8_t *raster_pixels(raster_t *raster);
+
+/**
+ * Fills an image with white, like sdl_clear().
+ *
+ * @param raster a pointer returned from raster_init()
+ */
+void raster_clear(raster_t *raster);
+
+/**
+ * Draws a polygon from the given list of vertices and a color,
+ * like sdl_draw_polygon().
+ *
+ * @param raster a pointer returned from raster_init()
+ * @param points the list of vertices of the polygon
+ * @param color the color used to fill in the polygon
+ */
+void raster_draw_polygon(raster_t *raster, list_t *points, rgb_color_t color);
+
+/**
+ * Clears an image and draws all bodies in a scene, like sdl_render_scene().
+ *
+ * @param raster a pointer returned from raster_init()
+ * @param scene the scene to draw
+ */
+void raster_render_scene(raster_t *raster, scene_t *scene);
+
+/**
+ * Computes a 64-bit FNV-1a hash of an image's size and pixels.
+ *
+ * @param raster a pointer returned from raster_init()
+ * @return the hash; equal images always have equal hashes
+ */
+uint64_t raster_hash(raster_t *raster);
+
+#endif // #ifndef __RASTER_H__
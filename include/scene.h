@@ -2,6 +2,9 @@
 #define __SCENE_H__
 
 #include "body.h"
+#include "collision_events.h"
+#include "contact_solver.h"
+#include "force_batch.h"
 #include "list.h"
 
 /**
@@ -11,6 +14,120 @@
  */
 typedef struct scene scene_t;
 
+/**
+ * The stages of scene_tick() that are timed by scene_get_stats().
+ * Integrators that evaluate the forces several times per tick
+ * add up the time of each evaluation.
+ */
+typedef enum {
+  /** Finding the collisions that call handlers */
+  TICK_DETECT,
+  /** Applying force fields, batched forces and force creators */
+  TICK_FORCES,
+  /** Resolving the physics collisions */
+  TICK_CONTACTS,
+  /** Advancing the bodies, apart from evaluating the forces */
+  TICK_INTEGRATE,
+  /** Calling the handlers of the collisions found */
+  TICK_HANDLERS,
+  /** Freeing removed bodies and the forces on them */
+  TICK_REMOVE,
+  TICK_STAGES
+} tick_stage_t;
+
+/**
+ * Where the time in recent scene_tick()s went, averaged per tick.
+ * Only recorded when the library is compiled with SCENE_PROFILE defined
+ * (run 'make PROFILE=true ...'); otherwise every field is 0.
+ */
+typedef struct {
+  /** The number of recent ticks averaged over */
+  size_t ticks;
+  /** The wall time of each stage, in seconds */
+  double stage_seconds[TICK_STAGES];
+  /** The wall time of the whole tick, in seconds */
+  double tick_seconds;
+  /** The number of force creator calls */
+  double force_creators;
+  /**
+   * The number of find_collision() calls. Counted across all threads,
+   * so ticks of other scenes at the same time are included.
+   */
+  double collision_tests;
+  /** The number of those calls that found a collision */
+  double collisions;
+  /** The number of bodies advanced */
+  double bodies_integrated;
+  /** The number of bodies removed */
+  double bodies_removed;
+} scene_tick_stats_t;
+
+/**
+ * A summary of the memory held by a scene and the allocations it makes.
+ * Byte counts include the lists that hold each kind of object.
+ */
+typedef struct {
+  /** The number of bodies in the scene */
+  size_t body_count;
+  /** The memory used by the bodies and their shape lists */
+  size_t body_bytes;
+  /** The total number of vertices in the bodies' shapes */
+  size_t vertex_count;
+  /** The memory used by the vertices */
+  size_t vertex_bytes;
+  /** The number of force creators and batched forces in the scene */
+  size_t force_count;
+  /** The memory used by the forces and their body lists */
+  size_t force_bytes;
+  /**
+   * The number of force creators and collision pairs with an auxiliary value
+   */
+  size_t aux_count;
+  /**
+   * The memory used by the auxiliary values whose sizes are known
+   * (see scene_add_sized_force_creator() and create_sized_collision()).
+   */
+  size_t aux_bytes;
+  /**
+   * The number of allocator calls made during the last scene_tick(),
+   * by the scene's own thread and its job pool (see mem_count_calls())
+   */
+  size_t tick_allocs;
+  /** The number of allocator calls made during all scene_tick()s */
+  size_t total_tick_allocs;
+  /** The number of times scene_tick() has been called */
+  size_t ticks;
+} scene_memory_stats_t;
+
+/**
+ * The methods a scene can use to advance its bodies over a tick.
+ * Methods that evaluate the forces more than once per tick invoke every
+ * batched force and force creator once per evaluation, with the bodies
+ * moved to intermediate positions and velocities.
+ * Impulses from all evaluations are added to the final velocity.
+ */
+typedef enum {
+  /**
+   * Explicit Euler on the velocity, moving each body at the average of its
+   * old and new velocities (see body_tick()). 1 force evaluation.
+   */
+  INTEGRATOR_DEFAULT,
+  /**
+   * Semi-implicit (symplectic) Euler: updates the velocity first,
+   * then moves each body at its new velocity. 1 force evaluation.
+   */
+  INTEGRATOR_SYMPLECTIC_EULER,
+  /**
+   * Velocity Verlet, in kick-drift-kick form: half a velocity update,
+   * a full position update, then another half velocity update
+   * with the forces at the new positions. 2 force evaluations.
+   */
+  INTEGRATOR_VELOCITY_VERLET,
+  /** Classical 4th-order Runge-Kutta. 4 force evaluations. */
+  INTEGRATOR_RK4,
+  INTEGRATOR_KINDS
+} integrator_t;
+
 /**
  * A function which adds some forces or impulses to bodies,
  * e.g. from collisions, gravity, or spring forces.
@@ -98,10 +215,217 @@ void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
                                     void *aux, list_t *bodies,
                                     free_func_t freer);
 
+/**
+ * Adds a force creator like scene_add_bodies_force_creator(),
+ * recording the size of its auxiliary value for scene_memory_stats().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param forcer a force creator function
+ * @param aux an auxiliary value to pass to forcer when it is called
+ * @param aux_size the number of bytes allocated for aux
+ * @param bodies the list of bodies affected by the force creator
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_sized_force_creator(scene_t *scene, force_creator_t forcer,
+                                   void *aux, size_t aux_size, list_t *bodies,
+                                   free_func_t freer);
+
+/**
+ * Adds a built-in force to a scene, to be applied every time scene_tick()
+ * is called. Forces of the same kind are stored together and applied
+ * in one batch before the scene's force creators are invoked.
+ * The force is removed when any of its bodies are removed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param kind the kind of force
+ * @param constant the force's constant (see force_batch_add())
+ * @param body1 the first body
+ * @param body2 the second body, or NULL for drag
+ */
+void scene_add_batched_force(scene_t *scene, force_kind_t kind,
+                             double constant, body_t *body1, body_t *body2);
+
+/**
+ * Gets the batch holding a scene's built-in forces of a given kind.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param kind the kind of force
+ * @return the batch of forces of that kind
+ */
+force_batch_t *scene_get_force_batch(scene_t *scene, force_kind_t kind);
+
+/**
+ * Adds a force field that gives every body in one of its layers the same
+ * acceleration, like gravity. Bodies with infinite mass are not moved.
+ * All of a scene's fields are applied together in one pass over the bodies,
+ * before the batched forces, without registering a force per body.
+ * Fields stay for the lifetime of the scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param acceleration the acceleration the field gives each body
+ * @param layers the layers of the bodies the field acts on
+ *   (see body_set_layers()), e.g. LAYER_ALL
+ */
+void scene_add_uniform_field(scene_t *scene, vector_t acceleration,
+                             layer_mask_t layers);
+
+/**
+ * Adds a force field that applies linear drag, -gamma * v,
+ * to every body in one of its layers (see scene_add_uniform_field()).
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param gamma the drag coefficient
+ * @param layers the layers of the bodies the field acts on
+ */
+void scene_add_global_drag(scene_t *scene, double gamma, layer_mask_t layers);
+
+/**
+ * A force field added with scene_add_uniform_field() or
+ * scene_add_global_drag(). It gives each body in its layers an
+ * acceleration of acceleration - drag * v.
+ */
+typedef struct {
+  vector_t acceleration;
+  double drag;
+  layer_mask_t layers;
+} force_field_t;
+
+/**
+ * Gets the number of force fields in a given scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of uniform fields and global drags added to the scene
+ */
+size_t scene_fields(scene_t *scene);
+
+/**
+ * Gets the force field at a given index in a scene.
+ * Asserts that the index is valid.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param index the index of the field, in the order fields were added
+ * @return the field's acceleration, drag and layers
+ */
+force_field_t scene_get_field(scene_t *scene, size_t index);
+
+/**
+ * Gets the number of force creators in a given scene.
+ * Does not include the built-in forces added with scene_add_batched_force().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of force creators added to the scene
+ */
+size_t scene_forces(scene_t *scene);
+
+/**
+ * Gets the force creator function at a given index in a scene.
+ * Asserts that the index is valid.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param index the index of the force creator (starting at 0)
+ * @return the force creator function
+ */
+force_creator_t scene_get_forcer(scene_t *scene, size_t index);
+
+/**
+ * Gets the auxiliary value of the force creator at a given index in a scene.
+ * Asserts that the index is valid.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param index the index of the force creator (starting at 0)
+ * @return the auxiliary value passed to the force creator
+ */
+void *scene_get_force_aux(scene_t *scene, size_t index);
+
+/**
+ * Gets the bodies the force creator at a given index in a scene depends on.
+ * Asserts that the index is valid.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param index the index of the force creator (starting at 0)
+ * @return the list of bodies registered with the force creator
+ */
+list_t *scene_get_force_bodies(scene_t *scene, size_t index);
+
+/**
+ * Sets the method a scene uses to advance its bodies in scene_tick().
+ * New scenes use INTEGRATOR_DEFAULT.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param integrator the integration method
+ */
+void scene_set_integrator(scene_t *scene, integrator_t integrator);
+
+/**
+ * Gets the method a scene uses to advance its bodies in scene_tick().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the integration method
+ */
+integrator_t scene_get_integrator(scene_t *scene);
+
+/**
+ * Gets the solver a scene uses to resolve its physics collisions,
+ * e.g. to change its number of iterations (8 by default).
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scene's contact solver
+ */
+contact_solver_t *scene_get_contact_solver(scene_t *scene);
+
+/**
+ * Sets how many threads a scene ticks on.
+ * With more than 1 thread, each stage of a tick is split into tasks on
+ * a work-stealing job pool (see jobs.h): finding the touching physics
+ * collisions, advancing the bodies, and finding the removed forces.
+ * Force creators that share no bodies also run at the same time,
+ * so each force creator may only modify the bodies it was added with
+ * (see scene_add_bodies_force_creator()) and must not touch other
+ * shared state. A force creator added with no bodies runs on its own.
+ * Each body still receives its forces in the order the force creators
+ * were added, so the results do not depend on the number of threads.
+ * Scenes start with 1 thread, which runs everything in order.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param threads the number of threads, at least 1
+ */
+void scene_set_threads(scene_t *scene, size_t threads);
+
+/**
+ * Gets how many threads a scene ticks on.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of threads set with scene_set_threads()
+ */
+size_t scene_get_threads(scene_t *scene);
+
+/**
+ * Gets how many rounds the force creators are split into when they run
+ * on several threads. Force creators in the same round share no bodies.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of rounds
+ */
+size_t scene_force_levels(scene_t *scene);
+
+/**
+ * Gets the pairs of bodies whose collisions call game logic handlers
+ * (see create_collision()), and the events found in the last tick.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scene's collision events
+ */
+collision_events_t *scene_get_collision_events(scene_t *scene);
+
 /**
  * Executes a tick of a given scene over a small time interval.
- * This requires executing all the force creators
- * and then ticking each body (see body_tick()).
+ * This requires detecting the collisions that call handlers,
+ * applying the force fields and all the batched forces,
+ * executing all the force creators, resolving all the physics collisions
+ * together (see contact_solver_solve()) and then advancing each body
+ * with the scene's integrator (see scene_set_integrator()).
+ * The handlers of the collisions found are then called in order
+ * (see collision_events_dispatch()).
  * If any bodies are marked for removal, they should be removed from the scene
  * and freed, along with any force creators acting on them.
  *
@@ -110,4 +434,22 @@ void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
  */
 void scene_tick(scene_t *scene, double dt);
 
+/**
+ * Reports how much memory a scene holds and how many allocations it makes.
+ * Counts are gathered from the allocation wrappers in mem_stats.h.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scene's memory and allocation statistics
+ */
+scene_memory_stats_t scene_memory_stats(scene_t *scene);
+
+/**
+ * Reports the per-stage time and work of a scene's recent ticks,
+ * averaged over up to the last 60 ticks.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the averages, or all zeros without SCENE_PROFILE
+ */
+scene_tick_stats_t scene_get_stats(scene_t *scene);
+
 #endif // #ifndef __SCENE_H__
@@ -5,6 +5,7 @@
 #include "list.h"
 #include "scene.h"
 #include "state.h"
+#include "timing.h"
 #include "vector.h"
 #include <stdbool.h>
 
@@ -67,6 +68,21 @@ typedef enum { BUTTON_PRESSED, BUTTON_RELEASED } button_event_type_t;
 
 typedef enum { AXIS_PRESSED, AXIS_RELEASED } axis_event_type_t;
 
+/**
+ * The parts of a frame whose durations are recorded.
+ * FRAME_TIME is the time between calls to time_since_last_tick().
+ * UPDATE_TIME runs from there until sdl_render_scene() is called,
+ * covering the game's logic and scene_tick().
+ * RENDER_TIME is the time spent drawing a frame, not counting
+ * waiting to present it.
+ */
+typedef enum {
+  FRAME_TIME,
+  UPDATE_TIME,
+  RENDER_TIME,
+  FRAME_STAGES
+} frame_stage_t;
+
 /**
  * A keypress handler.
  * When a key is pressed or released, the handler is passed its char value.
@@ -100,6 +116,8 @@ void sdl_init(vector_t min, vector_t max);
 /**
  * Processes all SDL events and returns whether the window has been closed.
  * This function must be called in order to handle keypresses.
+ * While the simulation thread runs, the input is queued for it instead
+ * (see sdl_start_simulation_thread()).
  *
  * @return true if the window was closed, false otherwise
  */
@@ -112,6 +130,9 @@ void sdl_clear(void);
 
 /**
  * Draws a polygon from the given list of vertices and a color.
+ * The polygon is split into triangles and batched with the other polygons
+ * of the frame, which are all submitted together by sdl_show()
+ * (or earlier, if an image or text is drawn over them).
  *
  * @param points the list of vertices of the polygon
  * @param color the color used to fill in the polygon
@@ -128,11 +149,66 @@ void sdl_show(void);
  * Draws all bodies in a scene.
  * This internally calls sdl_clear(), sdl_draw_polygon(), and sdl_show(),
  * so those functions should not be called directly.
+ * The background image and static bodies (see body_set_static()) are
+ * drawn into a cached texture, which is only redrawn when one of them
+ * changes; each frame copies it and draws just the other bodies.
+ * Static bodies are therefore always drawn beneath the other bodies,
+ * whatever their order in the scene; the other bodies are drawn in
+ * scene order, as are the static bodies among themselves.
  *
  * @param scene the scene to draw
  */
 void sdl_render_scene(scene_t *scene, char *message);
 
+/**
+ * A function that runs one of the game's frames: its logic, scene_tick()
+ * and sdl_render_scene().
+ *
+ * @param aux the auxiliary value passed to sdl_start_simulation_thread()
+ */
+typedef void (*sdl_step_t)(void *aux);
+
+/**
+ * Moves the game's frames onto a separate thread, so a slow frame no longer
+ * delays the next scene_tick(). SDL only allows the window, its events and
+ * drawing on the thread that created the window, so those stay on the
+ * calling thread, which should then loop over sdl_is_done() and
+ * sdl_show_latest(). sdl_render_scene() only publishes a snapshot of the
+ * scene's meshes, transforms and colors (see snapshot.h), which
+ * sdl_show_latest() draws; the two threads never wait for each other.
+ * Input polled by sdl_is_done() is queued for the simulation thread,
+ * whose step should call sdl_handle_input(), so handlers run on the
+ * thread that owns the scene.
+ * Must be called after sdl_init() and before anything is drawn.
+ * While it runs, sdl_render_scene() is the only way for the step to draw,
+ * and sdl_clear() does nothing. Does nothing under Emscripten.
+ *
+ * @param step the function to call repeatedly on the simulation thread
+ * @param aux an auxiliary value to pass to step
+ */
+void sdl_start_simulation_thread(sdl_step_t step, void *aux);
+
+/**
+ * Stops the thread started by sdl_start_simulation_thread(),
+ * once it has finished its current step. Call it when the program exits.
+ */
+void sdl_stop_simulation_thread(void);
+
+/**
+ * Draws and shows the newest snapshot published by the simulation thread,
+ * or waits briefly if it has already been shown.
+ * Must be called on the thread that called sdl_init().
+ */
+void sdl_show_latest(void);
+
+/**
+ * Passes the input queued by sdl_is_done() to the handlers.
+ * sdl_is_done() calls this itself unless the simulation thread is running.
+ *
+ * @param scene_tup the value passed to each handler
+ */
+void sdl_handle_input(void *scene_tup);
+
 /**
  * Registers a function to be called every time a key is pressed.
  * Overwrites any existing handler.
@@ -172,23 +248,62 @@ void sdl_on_button(controller_handler_t handler);
  */
 double time_since_last_tick(void);
 
+/**
+ * Summarizes the durations of a part of the most recent frames,
+ * measured with timing_now(). Can be called from any thread.
+ *
+ * @param stage the part of the frame
+ * @return the percentiles of its recent durations, in seconds
+ */
+timing_summary_t sdl_get_timing(frame_stage_t stage);
+
+/**
+ * Prints the percentiles of each part of the most recent frames,
+ * in milliseconds. The demos call it on exit only when the
+ * PRINT_FRAME_TIMING environment variable is set.
+ */
+void sdl_print_timing(void);
+
+/**
+ * The init_* functions below only request their files, which load on a
+ * background thread (or a frame at a time under Emscripten). Until a
+ * file has loaded, it is left out of drawing, or stays silent.
+ */
 void init_img(char *path);
 
 void init_text(char *path, int font_size);
 
 void init_audio(char *hit, char *powerup, char *wall, char *bg);
 
+/**
+ * Gets how much of the requested images, fonts and sounds have loaded.
+ *
+ * @return the fraction loaded, from 0 to 1; 1 if nothing is loading
+ */
+double sdl_loading_progress(void);
+
 void play_audio(void);
 
 void play_wall_audio(void);
 
 void play_powerup_audio(void);
 
+/**
+ * Starts looping the background music, streamed from its file,
+ * as soon as it has loaded.
+ */
 void play_bg(void);
 
 void play_powerup_audio(void);
 
-void create_text(char *text);
+/**
+ * Selects the text drawn by render_text(), centered in the window.
+ * Recently drawn strings keep their textures, so only new strings are
+ * rasterized and uploaded; init_text() must be called first.
+ *
+ * @param text the string to draw
+ */
+void create_text(const char *text);
 
 void render_text(void);
 
@@ -0,0 +1,119 @@
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include "body.h"
+#include "scene.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * What a renderer needs to draw one body, copied out of the scene.
+ */
+typedef struct {
+  /** Identifies the body for caches; must not be dereferenced */
+  const body_t *body;
+  /** The body's version (see body_get_version()) */
+  uint64_t version;
+  /** The body's mesh, retained for as long as the snapshot holds it */
+  const body_mesh_t *mesh;
+  /** Where to move the mesh's origin */
+  vector_t position;
+  /** How far to rotate the mesh, in radians */
+  double angle;
+  rgb_color_t color;
+  bool is_static;
+} snapshot_body_t;
+
+/**
+ * An immutable copy of what a scene looked like after a tick:
+ * each body's mesh, transform and color, plus a message to display.
+ * Readers never touch the scene, so they can run on another thread
+ * while the scene keeps ticking.
+ */
+typedef struct snapshot snapshot_t;
+
+/**
+ * Three snapshots handed from one writer thread to one reader thread
+ * without locks (triple buffering). The writer always has a snapshot
+ * to fill and the reader always has one to read; the third holds the
+ * latest published snapshot, which the two swap in and out atomically.
+ * Neither side ever waits for the other, so the scene can tick at its
+ * own rate however long drawing takes, and the reader always gets the
+ * newest snapshot. Snapshots the reader never saw are skipped.
+ */
+typedef struct snapshot_buffer snapshot_buffer_t;
+
+/**
+ * Allocates a snapshot buffer with nothing published yet.
+ *
+ * @return a pointer to the newly allocated buffer
+ */
+snapshot_buffer_t *snapshot_buffer_init(void);
+
+/**
+ * Releases the memory of a snapshot buffer and the meshes it holds.
+ * Neither the writer nor the reader may be using it.
+ *
+ * @param buffer a pointer returned from snapshot_buffer_init()
+ */
+void snapshot_buffer_free(snapshot_buffer_t *buffer);
+
+/**
+ * Copies a scene into the writer's snapshot and publishes it,
+ * replacing any published snapshot the reader has not acquired.
+ * Must only be called from the writer thread, which owns the scene.
+ *
+ * @param buffer a pointer returned from snapshot_buffer_init()
+ * @param scene the scene to copy
+ * @param message the text to display with it (copied), or NULL for none
+ */
+void snapshot_buffer_publish(snapshot_buffer_t *buffer, scene_t *scene,
+                             const char *message);
+
+/**
+ * Gets the most recently published snapshot.
+ * Must only be called from the reader thread.
+ *
+ * @param buffer a pointer returned from snapshot_buffer_init()
+ * @return the latest snapshot, valid until the next call,
+ *   or NULL if nothing has been published
+ */
+const snapshot_t *snapshot_buffer_acquire(snapshot_buffer_t *buffer);
+
+/**
+ * Gets the number of snapshots published before a snapshot,
+ * so a reader can tell whether it has already drawn it.
+ *
+ * @param snapshot a snapshot returned from snapshot_buffer_acquire()
+ * @return the snapshot's sequence number, starting from 0
+ */
+size_t snapshot_sequence(const snapshot_t *snapshot);
+
+/**
+ * Gets the number of bodies in a snapshot.
+ *
+ * @param snapshot a snapshot returned from snapshot_buffer_acquire()
+ * @return the number of bodies the scene had
+ */
+size_t snapshot_bodies(const snapshot_t *snapshot);
+
+/**
+ * Gets a body in a snapshot, in the scene's order.
+ * Asserts that the index is valid.
+ *
+ * @param snapshot a snapshot returned from snapshot_buffer_acquire()
+ * @param index the index of the body
+ * @return a pointer to the body's copy
+ */
+const snapshot_body_t *snapshot_get_body(const snapshot_t *snapshot,
+                                         size_t index);
+
+/**
+ * Gets the message published with a snapshot.
+ *
+ * @param snapshot a snapshot returned from snapshot_buffer_acquire()
+ * @return the message, or NULL if there was none
+ */
+const char *snapshot_message(const snapshot_t *snapshot);
+
+#endif // #ifndef __SNAPSHOT_H__
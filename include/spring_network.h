@@ -0,0 +1,103 @@
+#ifndef __SPRING_NETWORK_H__
+#define __SPRING_NETWORK_H__
+
+#include "body.h"
+#include <stddef.h>
+
+/**
+ * A set of Hooke's-law springs connecting a set of bodies,
+ * such as the edges of a rope, cloth or soft body.
+ * Each spring has its own constant and rest length.
+ * The springs are stored as a compressed sparse row (CSR) adjacency list,
+ * so applying the network reads each body's centroid once
+ * and adds each body's total spring force once.
+ */
+typedef struct spring_network spring_network_t;
+
+/**
+ * Allocates memory for an empty spring network.
+ *
+ * @param initial_bodies the number of bodies to allocate space for
+ * @param initial_springs the number of springs to allocate space for
+ * @return a pointer to the newly allocated network
+ */
+spring_network_t *spring_network_init(size_t initial_bodies,
+                                      size_t initial_springs);
+
+/**
+ * Releases the memory allocated for a spring network.
+ * Does not free the bodies.
+ *
+ * @param network a pointer to a network returned from spring_network_init()
+ */
+void spring_network_free(spring_network_t *network);
+
+/**
+ * Adds a body to a spring network.
+ *
+ * @param network a pointer to a network returned from spring_network_init()
+ * @param body the body
+ * @return the index of the body in the network, to pass to
+ *   spring_network_add_spring()
+ */
+size_t spring_network_add_body(spring_network_t *network, body_t *body);
+
+/**
+ * Adds a spring between two bodies in a spring network.
+ * The spring pulls the bodies together when they are farther apart
+ * than its rest length and pushes them apart when they are closer.
+ * Asserts that the body indices are valid and distinct.
+ *
+ * @param network a pointer to a network returned from spring_network_init()
+ * @param body1 the index of the first body
+ * @param body2 the index of the second body
+ * @param k the Hooke's constant for the spring
+ * @param rest_length the distance between the bodies' centroids
+ *   at which the spring exerts no force (0 matches create_spring())
+ */
+void spring_network_add_spring(spring_network_t *network, size_t body1,
+                               size_t body2, double k, double rest_length);
+
+/**
+ * Gets the number of bodies in a spring network.
+ *
+ * @param network a pointer to a network returned from spring_network_init()
+ * @return the number of bodies added with spring_network_add_body()
+ */
+size_t spring_network_bodies(spring_network_t *network);
+
+/**
+ * Gets the body at a given index in a spring network.
+ * Asserts that the index is valid.
+ *
+ * @param network a pointer to a network returned from spring_network_init()
+ * @param index the index returned from spring_network_add_body()
+ * @return the body
+ */
+body_t *spring_network_get_body(spring_network_t *network, size_t index);
+
+/**
+ * Gets the number of springs in a spring network.
+ *
+ * @param network a pointer to a network returned from spring_network_init()
+ * @return the number of springs added with spring_network_add_spring()
+ */
+size_t spring_network_springs(spring_network_t *network);
+
+/**
+ * Adds the force of every spring in a network to its bodies.
+ * Rebuilds the adjacency list first if springs were added since the last call.
+ *
+ * @param network a pointer to a network returned from spring_network_init()
+ */
+void spring_network_apply(spring_network_t *network);
+
+/**
+ * Gets the number of bytes a spring network has allocated.
+ *
+ * @param network a pointer to a network returned from spring_network_init()
+ * @return the memory used by the network, in bytes
+ */
+size_t spring_network_memory_size(spring_network_t *network);
+
+#endif // #ifndef __SPRING_NETWORK_H__
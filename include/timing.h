@@ -0,0 +1,70 @@
+#ifndef __TIMING_H__
+#define __TIMING_H__
+
+#include <stddef.h>
+
+/**
+ * Percentiles of the durations in a timing histogram, in seconds.
+ * All are 0 if it has no samples.
+ */
+typedef struct {
+  size_t samples;
+  double p50;
+  double p95;
+  double p99;
+  double max;
+} timing_summary_t;
+
+/**
+ * The most recent durations of something that happens every frame,
+ * such as drawing it, kept so their distribution can be summarized.
+ * Occasional slow frames (jank) show up in the high percentiles
+ * even when the average looks fine.
+ *
+ * Samples may be added on one thread while another summarizes them.
+ */
+typedef struct timing_histogram timing_histogram_t;
+
+/**
+ * Reads a monotonic clock with sub-microsecond resolution.
+ * Unlike clock(), which counts the CPU time used by the process,
+ * it measures wall time and never goes backwards.
+ *
+ * @return the number of seconds since an arbitrary starting point
+ */
+double timing_now(void);
+
+/**
+ * Allocates a histogram with no samples.
+ *
+ * @param window the number of most recent samples to keep; positive
+ * @return a pointer to the newly allocated histogram
+ */
+timing_histogram_t *timing_histogram_init(size_t window);
+
+/**
+ * Releases the memory allocated for a histogram.
+ *
+ * @param histogram a pointer returned from timing_histogram_init()
+ */
+void timing_histogram_free(timing_histogram_t *histogram);
+
+/**
+ * Adds a duration to a histogram, replacing its oldest sample
+ * if it already holds as many as its window.
+ *
+ * @param histogram a pointer returned from timing_histogram_init()
+ * @param seconds the duration
+ */
+void timing_histogram_add(timing_histogram_t *histogram, double seconds);
+
+/**
+ * Computes percentiles of the samples in a histogram.
+ * Uses the nearest-rank method, so every value is an actual sample.
+ *
+ * @param histogram a pointer returned from timing_histogram_init()
+ * @return the percentiles of the samples
+ */
+timing_summary_t timing_histogram_summary(timing_histogram_t *histogram);
+
+#endif // #ifndef __TIMING_H__
@@ -0,0 +1,85 @@
+#ifndef __VOICE_POOL_H__
+#define __VOICE_POOL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A function that starts playing a sound on a voice,
+ * replacing whatever the voice was playing.
+ *
+ * @param sound the sound passed to voice_pool_queue()
+ * @param voice the index of the voice (mixer channel) to play it on
+ * @param aux the auxiliary value passed to voice_pool_flush()
+ */
+typedef void (*voice_play_t)(size_t sound, size_t voice, void *aux);
+
+/**
+ * Decides which of a fixed number of voices (mixer channels)
+ * each requested sound plays on.
+ *
+ * Game code queues sounds as things happen, for example from collision
+ * handlers, and the queue is flushed once per frame. A sound queued
+ * several times in one frame plays once. Each sound may only play on a
+ * few voices at a time; past that, its oldest voice is restarted.
+ * When every voice is busy, the oldest one is stolen.
+ */
+typedef struct voice_pool voice_pool_t;
+
+/**
+ * Allocates a voice pool with every voice free and nothing queued.
+ *
+ * @param sounds the number of different sounds, identified by 0 to sounds-1
+ * @param voices the number of voices; positive
+ * @param max_per_sound the most voices one sound may play on at once;
+ *   positive
+ * @return a pointer to the newly allocated pool
+ */
+voice_pool_t *voice_pool_init(size_t sounds, size_t voices,
+                              size_t max_per_sound);
+
+/**
+ * Releases the memory allocated for a voice pool.
+ *
+ * @param pool a pointer returned from voice_pool_init()
+ */
+void voice_pool_free(voice_pool_t *pool);
+
+/**
+ * Requests a sound to play at the next flush.
+ * Does nothing if it is already queued.
+ *
+ * @param pool a pointer returned from voice_pool_init()
+ * @param sound the sound to play
+ */
+void voice_pool_queue(voice_pool_t *pool, size_t sound);
+
+/**
+ * Records that a voice has finished playing, so it can be reused.
+ *
+ * @param pool a pointer returned from voice_pool_init()
+ * @param voice the index of the voice
+ */
+void voice_pool_finished(voice_pool_t *pool, size_t voice);
+
+/**
+ * Plays the queued sounds, in the order they were first queued,
+ * and empties the queue.
+ *
+ * @param pool a pointer returned from voice_pool_init()
+ * @param play the function that starts a sound on a voice
+ * @param aux a value to pass to play
+ * @return the number of sounds started
+ */
+size_t voice_pool_flush(voice_pool_t *pool, voice_play_t play, void *aux);
+
+/**
+ * Gets the number of voices a sound is playing on.
+ *
+ * @param pool a pointer returned from voice_pool_init()
+ * @param sound the sound
+ * @return the number of voices
+ */
+size_t voice_pool_playing(voice_pool_t *pool, size_t sound);
+
+#endif // #ifndef __VOICE_POOL_H__
@@ -0,0 +1,278 @@
+#include "assets.h"
+#include "mem_stats.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#ifndef __EMSCRIPTEN__
+#include <pthread.h>
+#endif
+
+typedef struct asset {
+  asset_manager_t *manager;
+  char *path;
+  asset_load_t load;
+  free_func_t freer;
+  void *aux;
+  // Set after data, so readers that see ASSET_READY also see the data
+  atomic_int state;
+  void *data;
+  // Guarded by the manager's lock. While the asset is queued,
+  // the queue holds one of these references.
+  size_t references;
+  // The next asset in the manager's list of assets
+  struct asset *next;
+  // The next asset in the manager's queue of assets to load
+  struct asset *next_queued;
+} asset_t;
+
+typedef struct asset_manager {
+#ifndef __EMSCRIPTEN__
+  pthread_mutex_t lock;
+  // Signaled when an asset is queued or finishes loading
+  pthread_cond_t changed;
+  pthread_t thread;
+  bool stopping;
+#endif
+  bool use_thread;
+  // Every asset that has not been freed
+  asset_t *assets;
+  asset_t *queue_head;
+  asset_t *queue_tail;
+  // Counts since nothing was loading, for asset_manager_progress()
+  size_t requested;
+  size_t finished;
+} asset_manager_t;
+
+void lock_manager(asset_manager_t *manager) {
+#ifndef __EMSCRIPTEN__
+  pthread_mutex_lock(&manager->lock);
+#endif
+}
+
+void unlock_manager(asset_manager_t *manager) {
+#ifndef __EMSCRIPTEN__
+  pthread_mutex_unlock(&manager->lock);
+#endif
+}
+
+/**
+ * Removes the oldest asset from the queue. Its queue reference now
+ * belongs to the caller. Must be called with the lock held.
+ */
+asset_t *dequeue(asset_manager_t *manager) {
+  asset_t *asset = manager->queue_head;
+  if (asset != NULL) {
+    manager->queue_head = asset->next_queued;
+    if (manager->queue_head == NULL) {
+      manager->queue_tail = NULL;
+    }
+  }
+  return asset;
+}
+
+/**
+ * Loads a dequeued asset without the lock held,
+ * then releases the queue's reference to it.
+ */
+void load_asset(asset_t *asset) {
+  asset->data = asset->load(asset->path, asset->aux);
+  atomic_store_explicit(&asset->state,
+                        asset->data != NULL ? ASSET_READY : ASSET_FAILED,
+                        memory_order_release);
+  asset_manager_t *manager = asset->manager;
+  lock_manager(manager);
+  manager->finished++;
+  if (manager->queue_head == NULL) {
+    manager->requested = 0;
+    manager->finished = 0;
+  }
+#ifndef __EMSCRIPTEN__
+  pthread_cond_broadcast(&manager->changed);
+#endif
+  unlock_manager(manager);
+  asset_release(asset);
+}
+
+#ifndef __EMSCRIPTEN__
+void *loader_main(void *aux) {
+  asset_manager_t *manager = aux;
+  pthread_mutex_lock(&manager->lock);
+  while (true) {
+    while (manager->queue_head == NULL && !manager->stopping) {
+      pthread_cond_wait(&manager->changed, &manager->lock);
+    }
+    if (manager->stopping) {
+      break;
+    }
+    asset_t *asset = dequeue(manager);
+    pthread_mutex_unlock(&manager->lock);
+    load_asset(asset);
+    pthread_mutex_lock(&manager->lock);
+  }
+  pthread_mutex_unlock(&manager->lock);
+  return NULL;
+}
+#endif
+
+asset_manager_t *asset_manager_init(bool use_thread) {
+  asset_manager_t *manager = mem_alloc(MEM_ASSET, sizeof(asset_manager_t));
+  manager->assets = NULL;
+  manager->queue_head = NULL;
+  manager->queue_tail = NULL;
+  manager->requested = 0;
+  manager->finished = 0;
+#ifdef __EMSCRIPTEN__
+  manager->use_thread = false;
+#else
+  manager->use_thread = use_thread;
+  pthread_mutex_init(&manager->lock, NULL);
+  pthread_cond_init(&manager->changed, NULL);
+  manager->stopping = false;
+  if (use_thread) {
+    int error = pthread_create(&manager->thread, NULL, loader_main, manager);
+    assert(error == 0);
+  }
+#endif
+  return manager;
+}
+
+void asset_manager_free(asset_manager_t *manager) {
+#ifndef __EMSCRIPTEN__
+  if (manager->use_thread) {
+    pthread_mutex_lock(&manager->lock);
+    manager->stopping = true;
+    pthread_cond_broadcast(&manager->changed);
+    pthread_mutex_unlock(&manager->lock);
+    pthread_join(manager->thread, NULL);
+  }
+#endif
+  // Drop the queue's references to assets that never loaded
+  asset_t *asset;
+  while ((asset = dequeue(manager)) != NULL) {
+    asset_release(asset);
+  }
+  assert(manager->assets == NULL);
+#ifndef __EMSCRIPTEN__
+  pthread_cond_destroy(&manager->changed);
+  pthread_mutex_destroy(&manager->lock);
+#endif
+  mem_free(MEM_ASSET, manager, sizeof(asset_manager_t));
+}
+
+void asset_manager_poll(asset_manager_t *manager) {
+  if (manager->use_thread) {
+    return;
+  }
+  asset_t *asset = dequeue(manager);
+  if (asset != NULL) {
+    load_asset(asset);
+  }
+}
+
+void asset_manager_wait(asset_manager_t *manager) {
+  if (!manager->use_thread) {
+    while (manager->queue_head != NULL) {
+      asset_manager_poll(manager);
+    }
+    return;
+  }
+#ifndef __EMSCRIPTEN__
+  pthread_mutex_lock(&manager->lock);
+  while (manager->requested > 0) {
+    pthread_cond_wait(&manager->changed, &manager->lock);
+  }
+  pthread_mutex_unlock(&manager->lock);
+#endif
+}
+
+double asset_manager_progress(asset_manager_t *manager) {
+  lock_manager(manager);
+  double progress = manager->requested > 0
+                        ? (double)manager->finished / manager->requested
+                        : 1;
+  unlock_manager(manager);
+  return progress;
+}
+
+asset_t *asset_load(asset_manager_t *manager, const char *path,
+                    asset_load_t load, free_func_t freer, void *aux) {
+  lock_manager(manager);
+  for (asset_t *asset = manager->assets; asset != NULL; asset = asset->next) {
+    if (asset->load == load && asset->aux == aux &&
+        strcmp(asset->path, path) == 0) {
+      asset->references++;
+      unlock_manager(manager);
+      return asset;
+    }
+  }
+
+  asset_t *asset = mem_alloc(MEM_ASSET, sizeof(asset_t));
+  size_t path_size = strlen(path) + 1;
+  asset->path = mem_alloc(MEM_ASSET, path_size);
+  memcpy(asset->path, path, path_size);
+  asset->manager = manager;
+  asset->load = load;
+  asset->freer = freer;
+  asset->aux = aux;
+  atomic_init(&asset->state, ASSET_LOADING);
+  asset->data = NULL;
+  // One reference for the caller and one for the queue
+  asset->references = 2;
+  asset->next = manager->assets;
+  manager->assets = asset;
+  asset->next_queued = NULL;
+  if (manager->queue_tail != NULL) {
+    manager->queue_tail->next_queued = asset;
+  } else {
+    manager->queue_head = asset;
+  }
+  manager->queue_tail = asset;
+  manager->requested++;
+#ifndef __EMSCRIPTEN__
+  pthread_cond_broadcast(&manager->changed);
+#endif
+  unlock_manager(manager);
+  return asset;
+}
+
+void asset_retain(asset_t *asset) {
+  lock_manager(asset->manager);
+  assert(asset->references > 0);
+  asset->references++;
+  unlock_manager(asset->manager);
+}
+
+void asset_release(asset_t *asset) {
+  if (asset == NULL) {
+    return;
+  }
+  asset_manager_t *manager = asset->manager;
+  lock_manager(manager);
+  assert(asset->references > 0);
+  bool last = --asset->references == 0;
+  if (last) {
+    asset_t **link = &manager->assets;
+    while (*link != asset) {
+      link = &(*link)->next;
+    }
+    *link = asset->next;
+  }
+  unlock_manager(manager);
+  if (!last) {
+    return;
+  }
+  if (asset->data != NULL) {
+    asset->freer(asset->data);
+  }
+  mem_free(MEM_ASSET, asset->path, strlen(asset->path) + 1);
+  mem_free(MEM_ASSET, asset, sizeof(asset_t));
+}
+
+asset_state_t asset_get_state(asset_t *asset) {
+  return atomic_load_explicit(&asset->state, memory_order_acquire);
+}
+
+void *asset_get(asset_t *asset) {
+  return asset_get_state(asset) == ASSET_READY ? asset->data : NULL;
+}
@@ -1,12 +1,15 @@
+#include "mem_stats.h"
 #include "polygon.h"
 #include <assert.h>
 #include <body.h>
 #include <math.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 
 typedef struct body {
   list_t *shape;
+  vector_t centroid;
   double rotation;
   double max_rotation;
   vector_t velocity;
@@ -16,39 +19,42 @@ typedef struct body {
   vector_t impulse;
   double mass;
   rgb_color_t color;
+  layer_mask_t layers;
+  bool is_static;
+  // Incremented whenever the vertices or color change
+  uint64_t version;
+  // Built by body_get_mesh(); NULL until then and after reshaping
+  body_mesh_t *mesh;
   bool removed;
   void *info;
   free_func_t info_freer;
 } body_t;
 
+// The number of bodies ever created, used to give each its own versions
+atomic_uint_fast64_t bodies_created = 0;
+
 body_t *body_init(list_t *shape, double mass, rgb_color_t color) {
-  body_t *body = malloc(sizeof(body_t));
-  assert(body != NULL);
-  body->rotation = 0.0;
-  body->max_rotation = 360.0;
-  body->force = (vector_t){.x = 0.0, .y = 0.0};
-  body->impulse = (vector_t){.x = 0.0, .y = 0.0};
-  body->velocity = (vector_t){.x = 0.0, .y = 0.0};
-  body->shape = shape;
-  body->color = color;
-  body->mass = mass;
-  body->removed = false;
-  body->info = NULL;
-  body->info_freer = NULL;
-  return body;
+  return body_init_with_info(shape, mass, color, NULL, NULL);
 }
 
 body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
                             void *info, free_func_t info_freer) {
-  body_t *body = malloc(sizeof(body_t));
-  assert(body != NULL);
+  body_t *body = mem_alloc(MEM_BODY, sizeof(body_t));
+  body->rotation = 0.0;
+  body->max_rotation = 360.0;
   body->force = (vector_t){.x = 0.0, .y = 0.0};
   body->impulse = (vector_t){.x = 0.0, .y = 0.0};
   body->velocity = (vector_t){.x = 0.0, .y = 0.0};
   body->max_velocity = __DBL_MAX__;
   body->ang_velocity = 0.0;
   body->shape = shape;
+  body->centroid = polygon_centroid(shape);
   body->color = color;
+  body->layers = LAYER_DEFAULT;
+  body->is_static = false;
+  body->mesh = NULL;
+  // Each body's versions start 2^32 apart, so they never overlap
+  body->version = atomic_fetch_add(&bodies_created, 1) << 32;
   body->removed = false;
   body->mass = mass;
   body->info = info;
@@ -56,19 +62,62 @@ body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
   return body;
 }
 
+/**
+ * A mesh with a reference count, so snapshots of a scene can keep using
+ * a body's mesh after the body has been reshaped or freed.
+ */
+typedef struct mesh_block {
+  body_mesh_t mesh;
+  // The number of holders: the body while it uses the mesh, plus snapshots
+  atomic_size_t references;
+} mesh_block_t;
+
+size_t mesh_memory_size(body_mesh_t *mesh) {
+  if (mesh == NULL) {
+    return 0;
+  }
+  return sizeof(mesh_block_t) + mesh->vertex_count * sizeof(vector_t) +
+         3 * mesh->triangle_count * sizeof(size_t);
+}
+
+void body_mesh_retain(const body_mesh_t *mesh) {
+  mesh_block_t *block = (mesh_block_t *)mesh;
+  atomic_fetch_add(&block->references, 1);
+}
+
+void body_mesh_release(const body_mesh_t *mesh) {
+  mesh_block_t *block = (mesh_block_t *)mesh;
+  if (atomic_fetch_sub(&block->references, 1) > 1) {
+    return;
+  }
+  mem_free(MEM_BODY, (vector_t *)mesh->vertices,
+           mesh->vertex_count * sizeof(vector_t));
+  mem_free(MEM_BODY, (size_t *)mesh->indices,
+           3 * mesh->triangle_count * sizeof(size_t));
+  mem_free(MEM_BODY, block, sizeof(mesh_block_t));
+}
+
+void free_mesh(body_t *body) {
+  if (body->mesh != NULL) {
+    body_mesh_release(body->mesh);
+    body->mesh = NULL;
+  }
+}
+
 void body_free(body_t *body) {
   if (body->info_freer != NULL) {
     body->info_freer(body->info);
   }
+  free_mesh(body);
   list_free(body->shape);
-  free(body);
+  mem_free(MEM_BODY, body, sizeof(body_t));
 }
 
 list_t *body_get_shape(body_t *body) {
-  list_t *poly = list_init(list_size(body->shape), (free_func_t)free);
+  list_t *poly = list_init(list_size(body->shape), mem_vertex_free);
   for (size_t i = 0; i < list_size(body->shape); i++) {
     vector_t *vec = list_get(body->shape, i);
-    vector_t *new_vec = malloc(sizeof(vector_t));
+    vector_t *new_vec = mem_alloc(MEM_VERTEX, sizeof(vector_t));
     new_vec->x = vec->x;
     new_vec->y = vec->y;
     list_add(poly, new_vec);
@@ -76,10 +125,100 @@ list_t *body_get_shape(body_t *body) {
   return poly;
 }
 
-vector_t body_get_centroid(body_t *body) {
-  return polygon_centroid(body->shape);
+const body_mesh_t *body_get_mesh(body_t *body) {
+  if (body->mesh != NULL) {
+    return body->mesh;
+  }
+  size_t count = list_size(body->shape);
+  vector_t *vertices = mem_alloc(MEM_BODY, count * sizeof(vector_t));
+  for (size_t i = 0; i < count; i++) {
+    vector_t *vertex = list_get(body->shape, i);
+    vertices[i] = vec_subtract(*vertex, body->centroid);
+  }
+  // Shapes with fewer than 3 vertices have no triangles to draw
+  size_t *indices = NULL;
+  size_t triangles = 0;
+  if (count >= 3) {
+    indices = mem_alloc(MEM_BODY, 3 * (count - 2) * sizeof(size_t));
+    // Meshes are built once per shape, so the scratch space is not kept
+    size_t *scratch = mem_alloc(MEM_BODY, count * sizeof(size_t));
+    triangles = polygon_triangulate(body->shape, indices, scratch);
+    mem_free(MEM_BODY, scratch, count * sizeof(size_t));
+  }
+
+  mesh_block_t *block = mem_alloc(MEM_BODY, sizeof(mesh_block_t));
+  block->mesh = (body_mesh_t){.vertex_count = count,
+                              .vertices = vertices,
+                              .rotation = body->rotation,
+                              .triangle_count = triangles,
+                              .indices = indices};
+  atomic_init(&block->references, 1);
+  body->mesh = &block->mesh;
+  return body->mesh;
+}
+
+size_t body_num_vertices(body_t *body) { return list_size(body->shape); }
+
+size_t body_memory_size(body_t *body) {
+  return sizeof(body_t) + list_memory_size(body->shape) +
+         mesh_memory_size(body->mesh);
 }
 
+body_state_t body_get_state(body_t *body) {
+  return (body_state_t){.velocity = body->velocity,
+                        .max_velocity = body->max_velocity,
+                        .ang_velocity = body->ang_velocity,
+                        .rotation = body->rotation,
+                        .max_rotation = body->max_rotation,
+                        .force = body->force,
+                        .impulse = body->impulse,
+                        .mass = body->mass,
+                        .color = body->color,
+                        .layers = body->layers,
+                        .removed = body->removed};
+}
+
+void body_set_state(body_t *body, body_state_t state) {
+  body->velocity = state.velocity;
+  body->max_velocity = state.max_velocity;
+  body->ang_velocity = state.ang_velocity;
+  // The mesh is built for the old rotation of the vertices
+  if (body->rotation != state.rotation) {
+    free_mesh(body);
+  }
+  body->rotation = state.rotation;
+  body->max_rotation = state.max_rotation;
+  body->force = state.force;
+  body->impulse = state.impulse;
+  body->mass = state.mass;
+  if (body->color.r != state.color.r || body->color.g != state.color.g ||
+      body->color.b != state.color.b) {
+    body->version++;
+  }
+  body->color = state.color;
+  body->layers = state.layers;
+  body->removed = state.removed;
+}
+
+void body_copy_vertices(body_t *body, vector_t *vertices) {
+  for (size_t i = 0; i < list_size(body->shape); i++) {
+    vertices[i] = *(vector_t *)list_get(body->shape, i);
+  }
+}
+
+void body_set_vertices(body_t *body, const vector_t *vertices) {
+  for (size_t i = 0; i < list_size(body->shape); i++) {
+    *(vector_t *)list_get(body->shape, i) = vertices[i];
+  }
+  body->centroid = polygon_centroid(body->shape);
+  body->version++;
+  free_mesh(body);
+}
+
+list_t *body_peek_shape(body_t *body) { return body->shape; }
+
+vector_t body_get_centroid(body_t *body) { return body->centroid; }
+
 vector_t body_get_velocity(body_t *body) { return body->velocity; }
 
 double body_get_angular_velocity(body_t *body) { return body->ang_velocity; }
@@ -99,26 +238,52 @@ void body_y_scale(body_t *body, double scalar) {
     vector_t *vec = list_get(vectors, i);
     vec->y = (scalar * (vec->y - centroid.y)) + centroid.y;
   }
+  body->version++;
+  free_mesh(body);
 }
 
 void body_set_centroid(body_t *body, vector_t x) {
-  polygon_translate(body->shape,
-                    vec_subtract(x, polygon_centroid(body->shape)));
+  if (x.x == body->centroid.x && x.y == body->centroid.y) {
+    return;
+  }
+  polygon_translate(body->shape, vec_subtract(x, body->centroid));
+  body->centroid = x;
+  body->version++;
 }
 
-void body_set_color(body_t *body, rgb_color_t color) { body->color = color; }
+void body_set_color(body_t *body, rgb_color_t color) {
+  body->color = color;
+  body->version++;
+}
 
 void body_set_velocity(body_t *body, vector_t v) { body->velocity = v; }
 
 void body_set_max_velocity(body_t *body, double m) { body->max_velocity = m; }
 
+layer_mask_t body_get_layers(body_t *body) { return body->layers; }
+
+void body_set_layers(body_t *body, layer_mask_t layers) {
+  body->layers = layers;
+}
+
+bool body_is_static(body_t *body) { return body->is_static; }
+
+void body_set_static(body_t *body, bool is_static) {
+  body->is_static = is_static;
+}
+
+uint64_t body_get_version(body_t *body) { return body->version; }
+
 void body_set_angular_velocity(body_t *body, double v) {
   body->ang_velocity = v;
 }
 
 void body_set_rotation(body_t *body, double angle) {
   if (fabs(body->rotation + angle) <= body->max_rotation) {
-    polygon_rotate(body->shape, angle, body_get_centroid(body));
+    if (angle != 0) {
+      polygon_rotate(body->shape, angle, body_get_centroid(body));
+      body->version++;
+    }
     body->rotation = body->rotation + angle;
   } else {
     body->ang_velocity = 0.0;
@@ -152,26 +317,37 @@ void body_set_impulse(body_t *body, vector_t impulse) {
   body->impulse = impulse;
 }
 
+vector_t body_get_impulse(body_t *body) { return body->impulse; }
+
+vector_t body_clamp_velocity(body_t *body, vector_t velocity) {
+  if (fabs(velocity.x) > body->max_velocity) {
+    velocity.x = body->max_velocity * (velocity.x / fabs(velocity.x));
+  }
+  if (fabs(velocity.y) > body->max_velocity) {
+    velocity.y = body->max_velocity * (velocity.y / fabs(velocity.y));
+  }
+  return velocity;
+}
+
+void body_end_tick(body_t *body, vector_t centroid, vector_t velocity,
+                   double dt) {
+  body_set_centroid(body, centroid);
+  body_set_rotation(body, (body->ang_velocity) * dt);
+  body_set_velocity(body, velocity);
+  body_set_force(body, (vector_t){0, 0});
+  body_set_impulse(body, (vector_t){0, 0});
+}
+
 void body_tick(body_t *body, double dt) {
   vector_t dv_f = vec_multiply(dt / body->mass, body->force);
   vector_t dv_i = vec_multiply(1.0 / body->mass, body->impulse);
-  vector_t final_velocity = vec_add(body->velocity, vec_add(dv_f, dv_i));
-  if (fabs(final_velocity.x) > body->max_velocity) {
-    final_velocity.x =
-        body->max_velocity * (final_velocity.x / fabs(final_velocity.x));
-  }
-  if (fabs(final_velocity.y) > body->max_velocity) {
-    final_velocity.y =
-        body->max_velocity * (final_velocity.y / fabs(final_velocity.y));
-  }
+  vector_t final_velocity =
+      body_clamp_velocity(body, vec_add(body->velocity, vec_add(dv_f, dv_i)));
   vector_t avg_velocity =
       vec_multiply(0.5, vec_add(body->velocity, final_velocity));
   vector_t displacement = vec_multiply(dt, avg_velocity);
-  body_set_centroid(body, vec_add(body_get_centroid(body), displacement));
-  body_set_rotation(body, (body->ang_velocity) * dt);
-  body_set_velocity(body, final_velocity);
-  body_set_force(body, (vector_t){0, 0});
-  body_set_impulse(body, (vector_t){0, 0});
+  body_end_tick(body, vec_add(body_get_centroid(body), displacement),
+                final_velocity, dt);
 }
 
 void body_remove(body_t *body) {
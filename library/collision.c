@@ -3,6 +3,14 @@
 #include "vector.h"
 #include <math.h>
 
+#ifdef SCENE_PROFILE
+#include <stdatomic.h>
+
+// Counted across all threads for collision_tests() and collision_hits()
+atomic_size_t tests_run = 0;
+atomic_size_t hits_found = 0;
+#endif
+
 typedef struct info {
   bool collided;
   double distance;
@@ -12,7 +20,21 @@ overlap_info_t check_overlap(vector_t proj1, vector_t proj2);
 list_t *get_axes(list_t *shape);
 vector_t projection(list_t *shape, vector_t axis);
 
-collision_info_t find_collision(list_t *shape1, list_t *shape2) {
+/**
+ * Flips an axis if needed so it points from the first shape's projection
+ * towards the second's.
+ */
+vector_t orient_axis(vector_t axis, vector_t proj1, vector_t proj2) {
+  if (proj2.x + proj2.y < proj1.x + proj1.y) {
+    return vec_negate(axis);
+  }
+  return axis;
+}
+
+/**
+ * Tests two shapes for collision with the separating axis theorem.
+ */
+collision_info_t separating_axis_test(list_t *shape1, list_t *shape2) {
 
   list_t *axes_shape1 = get_axes(shape1);
 
@@ -25,11 +47,11 @@ collision_info_t find_collision(list_t *shape1, list_t *shape2) {
     overlap_info_t overlap_check = check_overlap(proj1, proj2);
     if (!overlap_check.collided) {
       list_free(axes_shape1);
-      return (collision_info_t){false, (vector_t){0.0, 0.0}};
+      return (collision_info_t){false, (vector_t){0.0, 0.0}, 0.0};
     } else {
       if (overlap_check.distance < min_dist) {
         min_dist = overlap_check.distance;
-        min_axis = axis;
+        min_axis = orient_axis(axis, proj1, proj2);
       }
     }
   }
@@ -43,16 +65,43 @@ collision_info_t find_collision(list_t *shape1, list_t *shape2) {
     overlap_info_t overlap_check = check_overlap(proj1, proj2);
     if (!overlap_check.collided) {
       list_free(axes_shape2);
-      return (collision_info_t){false, (vector_t){0.0, 0.0}};
+      return (collision_info_t){false, (vector_t){0.0, 0.0}, 0.0};
     } else {
       if (overlap_check.distance < min_dist) {
         min_dist = overlap_check.distance;
-        min_axis = axis;
+        min_axis = orient_axis(axis, proj1, proj2);
       }
     }
   }
   list_free(axes_shape2);
-  return (collision_info_t){true, min_axis};
+  return (collision_info_t){true, min_axis, min_dist};
+}
+
+collision_info_t find_collision(list_t *shape1, list_t *shape2) {
+  collision_info_t info = separating_axis_test(shape1, shape2);
+#ifdef SCENE_PROFILE
+  atomic_fetch_add_explicit(&tests_run, 1, memory_order_relaxed);
+  if (info.collided) {
+    atomic_fetch_add_explicit(&hits_found, 1, memory_order_relaxed);
+  }
+#endif
+  return info;
+}
+
+size_t collision_tests(void) {
+#ifdef SCENE_PROFILE
+  return atomic_load_explicit(&tests_run, memory_order_relaxed);
+#else
+  return 0;
+#endif
+}
+
+size_t collision_hits(void) {
+#ifdef SCENE_PROFILE
+  return atomic_load_explicit(&hits_found, memory_order_relaxed);
+#else
+  return 0;
+#endif
 }
 
 overlap_info_t check_overlap(vector_t proj1, vector_t proj2) {
@@ -100,4 +149,28 @@ vector_t projection(list_t *shape, vector_t axis) {
     }
   }
   return min_max_proj;
-}
\ No newline at end of file
+}
+
+/**
+ * Finds a shape's bounding box, as its minimum and maximum corners.
+ */
+void bounding_box(list_t *shape, vector_t *min, vector_t *max) {
+  *min = *(vector_t *)list_get(shape, 0);
+  *max = *min;
+  for (size_t i = 1; i < list_size(shape); i++) {
+    vector_t vertex = *(vector_t *)list_get(shape, i);
+    min->x = fmin(min->x, vertex.x);
+    min->y = fmin(min->y, vertex.y);
+    max->x = fmax(max->x, vertex.x);
+    max->y = fmax(max->y, vertex.y);
+  }
+}
+
+bool bounding_boxes_overlap(list_t *shape1, list_t *shape2) {
+  vector_t min1, max1, min2, max2;
+  bounding_box(shape1, &min1, &max1);
+  bounding_box(shape2, &min2, &max2);
+  // Like check_overlap(), boxes that only touch still count as overlapping
+  return !(max1.x < min2.x || max2.x < min1.x || max1.y < min2.y ||
+           max2.y < min1.y);
+}
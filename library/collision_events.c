@@ -0,0 +1,196 @@
+#include "collision_events.h"
+#include "collision.h"
+#include "mem_stats.h"
+#include <assert.h>
+#include <stdbool.h>
+
+typedef struct collision_events {
+  collision_pair_t *pairs;
+  size_t pair_count;
+  size_t pair_capacity;
+  // The result of the last detection for each pair
+  collision_info_t *results;
+  size_t results_capacity;
+  collision_event_t *queue;
+  size_t queue_size;
+  size_t queue_capacity;
+  // Whether the queued events' handlers have been called
+  bool dispatched;
+} collision_events_t;
+
+collision_events_t *collision_events_init(void) {
+  collision_events_t *events = mem_alloc(MEM_FORCE, sizeof(collision_events_t));
+  events->pairs = NULL;
+  events->pair_count = 0;
+  events->pair_capacity = 0;
+  events->results = NULL;
+  events->results_capacity = 0;
+  events->queue = NULL;
+  events->queue_size = 0;
+  events->queue_capacity = 0;
+  events->dispatched = true;
+  return events;
+}
+
+void free_pair_aux(collision_pair_t *pair) {
+  if (pair->freer != NULL) {
+    pair->freer(pair->aux);
+  }
+}
+
+void collision_events_free(collision_events_t *events) {
+  for (size_t i = 0; i < events->pair_count; i++) {
+    free_pair_aux(&events->pairs[i]);
+  }
+  mem_free(MEM_FORCE, events->pairs,
+           events->pair_capacity * sizeof(collision_pair_t));
+  mem_free(MEM_FORCE, events->results,
+           events->results_capacity * sizeof(collision_info_t));
+  mem_free(MEM_FORCE, events->queue,
+           events->queue_capacity * sizeof(collision_event_t));
+  mem_free(MEM_FORCE, events, sizeof(collision_events_t));
+}
+
+void collision_events_add(collision_events_t *events, body_t *body1,
+                          body_t *body2, collision_handler_t handler, void *aux,
+                          size_t aux_size, free_func_t freer, size_t tag) {
+  assert(body1 != NULL && body2 != NULL);
+  if (events->pair_count == events->pair_capacity) {
+    size_t capacity = events->pair_capacity > 0 ? 2 * events->pair_capacity : 4;
+    events->pairs = mem_realloc(
+        MEM_FORCE, events->pairs,
+        events->pair_capacity * sizeof(collision_pair_t),
+        capacity * sizeof(collision_pair_t));
+    events->pair_capacity = capacity;
+  }
+  events->pairs[events->pair_count++] = (collision_pair_t){.body1 = body1,
+                                                           .body2 = body2,
+                                                           .handler = handler,
+                                                           .aux = aux,
+                                                           .aux_size = aux_size,
+                                                           .freer = freer,
+                                                           .tag = tag,
+                                                           .touching = false};
+}
+
+size_t collision_events_pairs(collision_events_t *events) {
+  return events->pair_count;
+}
+
+collision_pair_t *collision_events_get_pair(collision_events_t *events,
+                                            size_t index) {
+  assert(index < events->pair_count);
+  return &events->pairs[index];
+}
+
+void test_pair(void *aux, size_t index) {
+  collision_events_t *events = aux;
+  list_t *shape1 = body_peek_shape(events->pairs[index].body1);
+  list_t *shape2 = body_peek_shape(events->pairs[index].body2);
+  if (bounding_boxes_overlap(shape1, shape2)) {
+    events->results[index] = find_collision(shape1, shape2);
+  } else {
+    events->results[index] = (collision_info_t){.collided = false};
+  }
+}
+
+void push_event(collision_events_t *events, size_t index) {
+  if (events->queue_size == events->queue_capacity) {
+    size_t capacity =
+        events->queue_capacity > 0 ? 2 * events->queue_capacity : 4;
+    events->queue = mem_realloc(
+        MEM_FORCE, events->queue,
+        events->queue_capacity * sizeof(collision_event_t),
+        capacity * sizeof(collision_event_t));
+    events->queue_capacity = capacity;
+  }
+  collision_pair_t *pair = &events->pairs[index];
+  events->queue[events->queue_size++] =
+      (collision_event_t){.pair = index,
+                          .body1 = pair->body1,
+                          .body2 = pair->body2,
+                          .axis = events->results[index].axis,
+                          .depth = events->results[index].depth,
+                          .tag = pair->tag};
+}
+
+size_t collision_events_detect(collision_events_t *events, job_pool_t *pool) {
+  size_t count = events->pair_count;
+  if (count > events->results_capacity) {
+    mem_free(MEM_FORCE, events->results,
+             events->results_capacity * sizeof(collision_info_t));
+    events->results = mem_alloc(MEM_FORCE, count * sizeof(collision_info_t));
+    events->results_capacity = count;
+  }
+  if (pool == NULL) {
+    for (size_t i = 0; i < count; i++) {
+      test_pair(events, i);
+    }
+  } else {
+    job_pool_parallel_for(pool, count, test_pair, events);
+  }
+
+  // The events are queued in pair order, however the pairs were tested
+  events->queue_size = 0;
+  for (size_t i = 0; i < count; i++) {
+    bool collided = events->results[i].collided;
+    if (collided && !events->pairs[i].touching) {
+      push_event(events, i);
+    }
+    events->pairs[i].touching = collided;
+  }
+  events->dispatched = false;
+  return events->queue_size;
+}
+
+size_t collision_events_size(collision_events_t *events) {
+  return events->queue_size;
+}
+
+collision_event_t *collision_events_get(collision_events_t *events,
+                                        size_t index) {
+  assert(index < events->queue_size);
+  return &events->queue[index];
+}
+
+void collision_events_dispatch(collision_events_t *events) {
+  if (events->dispatched) {
+    return;
+  }
+  events->dispatched = true;
+  // Handlers may add pairs, which can move the pairs array,
+  // so each handler is looked up just before it is called
+  for (size_t i = 0; i < events->queue_size; i++) {
+    collision_event_t event = events->queue[i];
+    collision_pair_t *pair = &events->pairs[event.pair];
+    if (pair->handler != NULL) {
+      pair->handler(event.body1, event.body2, event.axis, pair->aux);
+    }
+  }
+}
+
+size_t collision_events_remove_dead(collision_events_t *events) {
+  size_t kept = 0;
+  for (size_t i = 0; i < events->pair_count; i++) {
+    collision_pair_t *pair = &events->pairs[i];
+    if (body_is_removed(pair->body1) || body_is_removed(pair->body2)) {
+      free_pair_aux(pair);
+      continue;
+    }
+    events->pairs[kept++] = *pair;
+  }
+  size_t removed = events->pair_count - kept;
+  events->pair_count = kept;
+  // The queued events may refer to the removed pairs
+  if (removed > 0) {
+    events->queue_size = 0;
+  }
+  return removed;
+}
+
+size_t collision_events_memory_size(collision_events_t *events) {
+  return sizeof(collision_events_t) +
+         events->pair_capacity * sizeof(collision_pair_t) +
+         events->results_capacity * sizeof(collision_info_t) +
+         events->queue_capacity * sizeof(collision_event_t);
+}
@@ -0,0 +1,233 @@
+#include "contact_solver.h"
+#include "collision.h"
+#include "mem_stats.h"
+#include <assert.h>
+#include <math.h>
+
+typedef struct contact {
+  body_t *body1;
+  body_t *body2;
+  // The index of the pair in the batch
+  size_t pair;
+  // The collision axis, pointing from body1 towards body2
+  vector_t normal;
+  // 1 / (1 / m1 + 1 / m2): the impulse that changes the
+  // relative normal velocity by 1
+  double normal_mass;
+  // The relative normal velocity the solve aims for
+  double target_velocity;
+  // The normal impulse accumulated so far; never negative
+  double impulse;
+} contact_t;
+
+typedef struct contact_solver {
+  size_t iterations;
+  bool warm_start;
+  // Runs the collision tests in parallel, or NULL to run them in order
+  job_pool_t *pool;
+  // Scratch space for each solve, with room for every pair in the batch:
+  // whether each pair's bounding boxes overlap (the broad phase),
+  // the pairs that do, their collisions (the narrow phase),
+  // and the contacts found
+  bool *overlapping;
+  size_t *candidates;
+  collision_info_t *collisions;
+  contact_t *contacts;
+  size_t capacity;
+} contact_solver_t;
+
+typedef struct phase_job {
+  contact_solver_t *solver;
+  force_batch_t *batch;
+} phase_job_t;
+
+contact_solver_t *contact_solver_init(size_t iterations) {
+  assert(iterations > 0);
+  contact_solver_t *solver = mem_alloc(MEM_SCENE, sizeof(contact_solver_t));
+  solver->iterations = iterations;
+  solver->warm_start = true;
+  solver->pool = NULL;
+  solver->overlapping = NULL;
+  solver->candidates = NULL;
+  solver->collisions = NULL;
+  solver->contacts = NULL;
+  solver->capacity = 0;
+  return solver;
+}
+
+void contact_solver_free(contact_solver_t *solver) {
+  mem_free(MEM_SCENE, solver->overlapping, solver->capacity * sizeof(bool));
+  mem_free(MEM_SCENE, solver->candidates, solver->capacity * sizeof(size_t));
+  mem_free(MEM_SCENE, solver->collisions,
+           solver->capacity * sizeof(collision_info_t));
+  mem_free(MEM_SCENE, solver->contacts, solver->capacity * sizeof(contact_t));
+  mem_free(MEM_SCENE, solver, sizeof(contact_solver_t));
+}
+
+void contact_solver_set_iterations(contact_solver_t *solver,
+                                   size_t iterations) {
+  assert(iterations > 0);
+  solver->iterations = iterations;
+}
+
+size_t contact_solver_get_iterations(contact_solver_t *solver) {
+  return solver->iterations;
+}
+
+void contact_solver_set_warm_start(contact_solver_t *solver, bool warm_start) {
+  solver->warm_start = warm_start;
+}
+
+void contact_solver_set_job_pool(contact_solver_t *solver, job_pool_t *pool) {
+  solver->pool = pool;
+}
+
+double inverse_mass(body_t *body) {
+  double mass = body_get_mass(body);
+  return mass == INFINITY ? 0 : 1 / mass;
+}
+
+/**
+ * Predicts a body's velocity at the end of the tick
+ * from the forces and impulses applied to it so far.
+ */
+vector_t predicted_velocity(body_t *body, double dt) {
+  vector_t change =
+      vec_add(vec_multiply(dt, body_get_force(body)), body_get_impulse(body));
+  return vec_add(body_get_velocity(body),
+                 vec_multiply(inverse_mass(body), change));
+}
+
+double normal_velocity(contact_t *contact, double dt) {
+  vector_t relative = vec_subtract(predicted_velocity(contact->body2, dt),
+                                   predicted_velocity(contact->body1, dt));
+  return vec_dot(relative, contact->normal);
+}
+
+void apply_impulse(contact_t *contact, double impulse) {
+  vector_t push = vec_multiply(impulse, contact->normal);
+  body_add_impulse(contact->body1, vec_negate(push));
+  body_add_impulse(contact->body2, push);
+}
+
+void reserve_pairs(contact_solver_t *solver, size_t pairs) {
+  if (pairs <= solver->capacity) {
+    return;
+  }
+  size_t capacity = solver->capacity;
+  solver->overlapping =
+      mem_realloc(MEM_SCENE, solver->overlapping, capacity * sizeof(bool),
+                  pairs * sizeof(bool));
+  solver->candidates =
+      mem_realloc(MEM_SCENE, solver->candidates, capacity * sizeof(size_t),
+                  pairs * sizeof(size_t));
+  solver->collisions = mem_realloc(MEM_SCENE, solver->collisions,
+                                   capacity * sizeof(collision_info_t),
+                                   pairs * sizeof(collision_info_t));
+  solver->contacts =
+      mem_realloc(MEM_SCENE, solver->contacts, capacity * sizeof(contact_t),
+                  pairs * sizeof(contact_t));
+  solver->capacity = pairs;
+}
+
+void run_phase(contact_solver_t *solver, size_t count, job_func_t func,
+               phase_job_t *job) {
+  if (solver->pool == NULL) {
+    for (size_t i = 0; i < count; i++) {
+      func(job, i);
+    }
+  } else {
+    job_pool_parallel_for(solver->pool, count, func, job);
+  }
+}
+
+void broad_phase(void *aux, size_t pair) {
+  phase_job_t *job = aux;
+  body_t *body1 = force_batch_get_body(job->batch, pair, 0);
+  body_t *body2 = force_batch_get_body(job->batch, pair, 1);
+  // Pairs of infinite masses can't push each other, so they are skipped
+  job->solver->overlapping[pair] =
+      inverse_mass(body1) + inverse_mass(body2) > 0 &&
+      bounding_boxes_overlap(body_peek_shape(body1), body_peek_shape(body2));
+}
+
+void narrow_phase(void *aux, size_t candidate) {
+  phase_job_t *job = aux;
+  size_t pair = job->solver->candidates[candidate];
+  list_t *shape1 = body_peek_shape(force_batch_get_body(job->batch, pair, 0));
+  list_t *shape2 = body_peek_shape(force_batch_get_body(job->batch, pair, 1));
+  job->solver->collisions[candidate] = find_collision(shape1, shape2);
+}
+
+/**
+ * Finds the touching pairs, testing the pairs in parallel.
+ * The contacts are listed in the order of their pairs in the batch,
+ * however many threads found them, so the solve is deterministic.
+ */
+size_t gather_contacts(contact_solver_t *solver, force_batch_t *batch,
+                       double dt) {
+  size_t pairs = force_batch_size(batch);
+  reserve_pairs(solver, pairs);
+  phase_job_t job = {solver, batch};
+  run_phase(solver, pairs, broad_phase, &job);
+  size_t candidate_count = 0;
+  for (size_t i = 0; i < pairs; i++) {
+    if (solver->overlapping[i]) {
+      solver->candidates[candidate_count++] = i;
+    } else {
+      force_batch_set_impulse(batch, i, 0);
+    }
+  }
+  run_phase(solver, candidate_count, narrow_phase, &job);
+
+  size_t count = 0;
+  for (size_t c = 0; c < candidate_count; c++) {
+    size_t i = solver->candidates[c];
+    collision_info_t info = solver->collisions[c];
+    if (!info.collided) {
+      force_batch_set_impulse(batch, i, 0);
+      continue;
+    }
+    body_t *body1 = force_batch_get_body(batch, i, 0);
+    body_t *body2 = force_batch_get_body(batch, i, 1);
+    contact_t *contact = &solver->contacts[count++];
+    contact->body1 = body1;
+    contact->body2 = body2;
+    contact->pair = i;
+    contact->normal = info.axis;
+    contact->normal_mass = 1 / (inverse_mass(body1) + inverse_mass(body2));
+    // Bodies approaching each other bounce apart, scaled by the elasticity
+    double approach = normal_velocity(contact, dt);
+    contact->target_velocity =
+        approach < 0 ? -force_batch_get_constant(batch, i) * approach : 0;
+    contact->impulse =
+        solver->warm_start ? force_batch_get_impulse(batch, i) : 0;
+  }
+  return count;
+}
+
+size_t contact_solver_solve(contact_solver_t *solver, force_batch_t *contacts,
+                            double dt) {
+  assert(force_batch_kind(contacts) == FORCE_PHYSICS_COLLISION);
+  // Every target velocity is measured before any warm starting impulse
+  size_t count = gather_contacts(solver, contacts, dt);
+  for (size_t i = 0; i < count; i++) {
+    apply_impulse(&solver->contacts[i], solver->contacts[i].impulse);
+  }
+
+  for (size_t iteration = 0; iteration < solver->iterations; iteration++) {
+    for (size_t i = 0; i < count; i++) {
+      contact_t *contact = &solver->contacts[i];
+      double error = contact->target_velocity - normal_velocity(contact, dt);
+      double impulse = fmax(contact->impulse + error * contact->normal_mass, 0);
+      apply_impulse(contact, impulse - contact->impulse);
+      contact->impulse = impulse;
+    }
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    force_batch_set_impulse(contacts, solver->contacts[i].pair,
+                            solver->contacts[i].impulse);
+  }
+  return count;
+}
@@ -17,6 +17,17 @@ typedef struct state {
 
 state_t *state;
 
+/**
+ * Frees the game's state. Prints the frame timings first if the
+ * PRINT_FRAME_TIMING environment variable is set, for profiling.
+ */
+void finish(state_t *state) {
+  if (getenv("PRINT_FRAME_TIMING") != NULL) {
+    sdl_print_timing();
+  }
+  emscripten_free(state);
+}
+
 void loop() {
   // If needed, generate a pointer to our initial state
   if (!state) {
@@ -25,7 +36,7 @@ void loop() {
 
   emscripten_main(state);
   if (sdl_is_done(state->scene_tup)) { // Once our demo exits...
-    emscripten_free(state); // Free any state variables we've been using
+    finish(state); // Free any state variables we've been using
 #ifdef __EMSCRIPTEN__ // Clean up emscripten environment (if we're using it)
     emscripten_cancel_main_loop();
     emscripten_force_exit(0);
@@ -36,13 +47,31 @@ void loop() {
   }
 }
 
+#ifndef __EMSCRIPTEN__
+/**
+ * Runs one of the game's frames on the simulation thread,
+ * after handling the input the main thread has polled.
+ */
+void simulate(void *aux) {
+  state_t *state = aux;
+  sdl_handle_input(state->scene_tup);
+  emscripten_main(state);
+}
+#endif
+
 int main() {
 #ifdef __EMSCRIPTEN__
   // Set loop as the function emscripten calls to request a new frame
   emscripten_set_main_loop_arg(loop, NULL, 0, 1);
 #else
-  while (1) {
-    loop();
+  // Native builds tick on their own thread, so drawing never slows ticks.
+  // SDL needs the window's events and drawing on this thread.
+  state = emscripten_init();
+  sdl_start_simulation_thread(simulate, state);
+  while (!sdl_is_done(NULL)) {
+    sdl_show_latest();
   }
+  sdl_stop_simulation_thread();
+  finish(state);
 #endif
 }
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include "flat_scene.h"
+#include "mem_stats.h"
+#include "ptr_map.h"
+#include <assert.h>
+#include <string.h>
+
+typedef struct flat_scene {
+  flat_body_t *bodies;
+  size_t body_count;
+  size_t body_capacity;
+  vector_t *vertices;
+  size_t vertex_count;
+  size_t vertex_capacity;
+  flat_force_t *forces;
+  size_t force_count;
+  size_t force_capacity;
+  size_t *force_bodies;
+  size_t force_body_count;
+  size_t force_body_capacity;
+  force_field_t *fields;
+  size_t field_count;
+  size_t field_capacity;
+
+  // Scratch map from body pointers to indices, used while capturing
+  ptr_map_t *body_indices;
+} flat_scene_t;
+
+flat_scene_t *flat_scene_init(void) {
+  flat_scene_t *flat = mem_alloc(MEM_FLAT, sizeof(flat_scene_t));
+  memset(flat, 0, sizeof(flat_scene_t));
+  flat->body_indices = ptr_map_init(MEM_FLAT, 0);
+  return flat;
+}
+
+void flat_scene_free(flat_scene_t *flat) {
+  mem_free(MEM_FLAT, flat->bodies, flat->body_capacity * sizeof(flat_body_t));
+  mem_free(MEM_FLAT, flat->vertices, flat->vertex_capacity * sizeof(vector_t));
+  mem_free(MEM_FLAT, flat->forces,
+           flat->force_capacity * sizeof(flat_force_t));
+  mem_free(MEM_FLAT, flat->force_bodies,
+           flat->force_body_capacity * sizeof(size_t));
+  mem_free(MEM_FLAT, flat->fields,
+           flat->field_capacity * sizeof(force_field_t));
+  ptr_map_free(flat->body_indices);
+  mem_free(MEM_FLAT, flat, sizeof(flat_scene_t));
+}
+
+/**
+ * Grows a buffer so it can hold at least the given number of elements.
+ * Buffers only grow, so captures of similar scenes do not allocate.
+ */
+void *buffer_reserve(void *buffer, size_t *capacity, size_t needed,
+                     size_t elem_size) {
+  if (needed <= *capacity) {
+    return buffer;
+  }
+  size_t new_capacity = *capacity > 0 ? *capacity : 1;
+  while (new_capacity < needed) {
+    new_capacity *= 2;
+  }
+  buffer = mem_realloc(MEM_FLAT, buffer, *capacity * elem_size,
+                       new_capacity * elem_size);
+  *capacity = new_capacity;
+  return buffer;
+}
+
+void flat_scene_capture(flat_scene_t *flat, scene_t *scene) {
+  size_t body_count = scene_bodies(scene);
+  size_t vertex_count = 0;
+  for (size_t i = 0; i < body_count; i++) {
+    vertex_count += body_num_vertices(scene_get_body(scene, i));
+  }
+  flat->bodies = buffer_reserve(flat->bodies, &flat->body_capacity, body_count,
+                                sizeof(flat_body_t));
+  flat->vertices = buffer_reserve(flat->vertices, &flat->vertex_capacity,
+                                  vertex_count, sizeof(vector_t));
+  flat->body_count = body_count;
+  flat->vertex_count = vertex_count;
+
+  size_t vertex_start = 0;
+  for (size_t i = 0; i < body_count; i++) {
+    body_t *body = scene_get_body(scene, i);
+    flat_body_t *record = &flat->bodies[i];
+    record->state = body_get_state(body);
+    record->info = body_get_info(body);
+    record->vertex_start = vertex_start;
+    record->vertex_count = body_num_vertices(body);
+    body_copy_vertices(body, &flat->vertices[vertex_start]);
+    vertex_start += record->vertex_count;
+  }
+
+  collision_events_t *events = scene_get_collision_events(scene);
+  size_t pair_count = collision_events_pairs(events);
+  size_t creator_count = scene_forces(scene);
+  size_t force_count = creator_count + pair_count;
+  size_t force_body_count = 2 * pair_count;
+  for (size_t i = 0; i < creator_count; i++) {
+    force_body_count += list_size(scene_get_force_bodies(scene, i));
+  }
+  for (force_kind_t kind = 0; kind < FORCE_KINDS; kind++) {
+    size_t batch_size = force_batch_size(scene_get_force_batch(scene, kind));
+    force_count += batch_size;
+    force_body_count += (kind == FORCE_DRAG ? 1 : 2) * batch_size;
+  }
+  flat->forces = buffer_reserve(flat->forces, &flat->force_capacity,
+                                force_count, sizeof(flat_force_t));
+  flat->force_bodies =
+      buffer_reserve(flat->force_bodies, &flat->force_body_capacity,
+                     force_body_count, sizeof(size_t));
+  flat->force_count = force_count;
+  flat->force_body_count = force_body_count;
+
+  ptr_map_clear(flat->body_indices, body_count);
+  for (size_t i = 0; i < body_count; i++) {
+    ptr_map_put(flat->body_indices, scene_get_body(scene, i), i);
+  }
+  size_t body_start = 0;
+  flat_force_t *record = flat->forces;
+  for (size_t i = 0; i < creator_count; i++, record++) {
+    list_t *bodies = scene_get_force_bodies(scene, i);
+    *record = (flat_force_t){.type = FLAT_FORCE_CREATOR,
+                             .forcer = scene_get_forcer(scene, i),
+                             .aux = scene_get_force_aux(scene, i),
+                             .kind = FORCE_KINDS};
+    record->body_start = body_start;
+    record->body_count = list_size(bodies);
+    for (size_t j = 0; j < record->body_count; j++) {
+      flat->force_bodies[body_start + j] =
+          ptr_map_get(flat->body_indices, list_get(bodies, j), FLAT_NO_BODY);
+    }
+    body_start += record->body_count;
+  }
+  for (force_kind_t kind = 0; kind < FORCE_KINDS; kind++) {
+    force_batch_t *batch = scene_get_force_batch(scene, kind);
+    for (size_t i = 0; i < force_batch_size(batch); i++, record++) {
+      *record = (flat_force_t){.type = FLAT_BATCHED_FORCE,
+                               .kind = kind,
+                               .constant = force_batch_get_constant(batch, i)};
+      record->body_start = body_start;
+      record->body_count = kind == FORCE_DRAG ? 1 : 2;
+      for (size_t j = 0; j < record->body_count; j++) {
+        body_t *body = force_batch_get_body(batch, i, j);
+        flat->force_bodies[body_start + j] =
+            ptr_map_get(flat->body_indices, body, FLAT_NO_BODY);
+      }
+      body_start += record->body_count;
+    }
+  }
+  for (size_t i = 0; i < pair_count; i++, record++) {
+    collision_pair_t *pair = collision_events_get_pair(events, i);
+    *record = (flat_force_t){.type = FLAT_COLLISION,
+                             .handler = pair->handler,
+                             .aux = pair->aux,
+                             .kind = FORCE_KINDS,
+                             .tag = pair->tag,
+                             .touching = pair->touching,
+                             .body_start = body_start,
+                             .body_count = 2};
+    flat->force_bodies[body_start] =
+        ptr_map_get(flat->body_indices, pair->body1, FLAT_NO_BODY);
+    flat->force_bodies[body_start + 1] =
+        ptr_map_get(flat->body_indices, pair->body2, FLAT_NO_BODY);
+    body_start += 2;
+  }
+
+  size_t field_count = scene_fields(scene);
+  flat->fields = buffer_reserve(flat->fields, &flat->field_capacity,
+                                field_count, sizeof(force_field_t));
+  flat->field_count = field_count;
+  for (size_t i = 0; i < field_count; i++) {
+    flat->fields[i] = scene_get_field(scene, i);
+  }
+}
+
+void flat_scene_copy(flat_scene_t *dst, flat_scene_t *src) {
+  dst->bodies = buffer_reserve(dst->bodies, &dst->body_capacity,
+                               src->body_count, sizeof(flat_body_t));
+  dst->vertices = buffer_reserve(dst->vertices, &dst->vertex_capacity,
+                                 src->vertex_count, sizeof(vector_t));
+  dst->forces = buffer_reserve(dst->forces, &dst->force_capacity,
+                               src->force_count, sizeof(flat_force_t));
+  dst->force_bodies =
+      buffer_reserve(dst->force_bodies, &dst->force_body_capacity,
+                     src->force_body_count, sizeof(size_t));
+  memcpy(dst->bodies, src->bodies, src->body_count * sizeof(flat_body_t));
+  memcpy(dst->vertices, src->vertices, src->vertex_count * sizeof(vector_t));
+  memcpy(dst->forces, src->forces, src->force_count * sizeof(flat_force_t));
+  dst->fields = buffer_reserve(dst->fields, &dst->field_capacity,
+                               src->field_count, sizeof(force_field_t));
+  memcpy(dst->force_bodies, src->force_bodies,
+         src->force_body_count * sizeof(size_t));
+  memcpy(dst->fields, src->fields, src->field_count * sizeof(force_field_t));
+  dst->body_count = src->body_count;
+  dst->vertex_count = src->vertex_count;
+  dst->force_count = src->force_count;
+  dst->force_body_count = src->force_body_count;
+  dst->field_count = src->field_count;
+}
+
+flat_scene_t *flat_scene_clone(flat_scene_t *src) {
+  flat_scene_t *dst = flat_scene_init();
+  flat_scene_copy(dst, src);
+  return dst;
+}
+
+void flat_scene_restore(flat_scene_t *flat, scene_t *scene) {
+  assert(scene_bodies(scene) == flat->body_count);
+  for (size_t i = 0; i < flat->body_count; i++) {
+    body_t *body = scene_get_body(scene, i);
+    flat_body_t *record = &flat->bodies[i];
+    assert(body_num_vertices(body) == record->vertex_count);
+    body_set_state(body, record->state);
+    body_set_vertices(body, &flat->vertices[record->vertex_start]);
+  }
+  collision_events_t *events = scene_get_collision_events(scene);
+  size_t pair = 0;
+  for (size_t i = 0; i < flat->force_count; i++) {
+    flat_force_t *record = &flat->forces[i];
+    if (record->type == FLAT_COLLISION) {
+      collision_events_get_pair(events, pair)->touching = record->touching;
+      pair++;
+    }
+  }
+  assert(pair == collision_events_pairs(events));
+}
+
+size_t flat_scene_bodies(flat_scene_t *flat) { return flat->body_count; }
+
+flat_body_t *flat_scene_get_body(flat_scene_t *flat, size_t index) {
+  assert(index < flat->body_count);
+  return &flat->bodies[index];
+}
+
+vector_t *flat_scene_get_vertices(flat_scene_t *flat, size_t index) {
+  return &flat->vertices[flat_scene_get_body(flat, index)->vertex_start];
+}
+
+size_t flat_scene_forces(flat_scene_t *flat) { return flat->force_count; }
+
+flat_force_t *flat_scene_get_force(flat_scene_t *flat, size_t index) {
+  assert(index < flat->force_count);
+  return &flat->forces[index];
+}
+
+size_t flat_scene_get_force_body(flat_scene_t *flat, size_t force,
+                                 size_t body) {
+  flat_force_t *record = flat_scene_get_force(flat, force);
+  assert(body < record->body_count);
+  return flat->force_bodies[record->body_start + body];
+}
+
+size_t flat_scene_fields(flat_scene_t *flat) { return flat->field_count; }
+
+force_field_t *flat_scene_get_field(flat_scene_t *flat, size_t index) {
+  assert(index < flat->field_count);
+  return &flat->fields[index];
+}
+
+size_t flat_scene_memory_size(flat_scene_t *flat) {
+  return sizeof(flat_scene_t) + flat->body_capacity * sizeof(flat_body_t) +
+         flat->vertex_capacity * sizeof(vector_t) +
+         flat->force_capacity * sizeof(flat_force_t) +
+         flat->force_body_capacity * sizeof(size_t) +
+         flat->field_capacity * sizeof(force_field_t) +
+         ptr_map_memory_size(flat->body_indices);
+}
@@ -0,0 +1,183 @@
+#include "force_batch.h"
+#include "mem_stats.h"
+#include <assert.h>
+#include <math.h>
+
+const double MIN_GRAVITY_DISTANCE = 100;
+
+typedef struct force_batch {
+  force_kind_t kind;
+  size_t size;
+  size_t capacity;
+  body_t **body1;
+  body_t **body2;
+  double *constant;
+  // The normal impulse the contact solver applied to each pair last tick,
+  // used to warm start the next solve (physics collisions only)
+  double *impulse;
+} force_batch_t;
+
+void force_batch_set_capacity(force_batch_t *batch, size_t capacity) {
+  batch->body1 =
+      mem_realloc(MEM_FORCE, batch->body1, batch->capacity * sizeof(body_t *),
+                  capacity * sizeof(body_t *));
+  batch->body2 =
+      mem_realloc(MEM_FORCE, batch->body2, batch->capacity * sizeof(body_t *),
+                  capacity * sizeof(body_t *));
+  batch->constant =
+      mem_realloc(MEM_FORCE, batch->constant, batch->capacity * sizeof(double),
+                  capacity * sizeof(double));
+  batch->impulse =
+      mem_realloc(MEM_FORCE, batch->impulse, batch->capacity * sizeof(double),
+                  capacity * sizeof(double));
+  batch->capacity = capacity;
+}
+
+force_batch_t *force_batch_init(force_kind_t kind, size_t initial_size) {
+  force_batch_t *batch = mem_alloc(MEM_FORCE, sizeof(force_batch_t));
+  batch->kind = kind;
+  batch->size = 0;
+  batch->capacity = 0;
+  batch->body1 = NULL;
+  batch->body2 = NULL;
+  batch->constant = NULL;
+  batch->impulse = NULL;
+  force_batch_set_capacity(batch, initial_size > 0 ? initial_size : 1);
+  return batch;
+}
+
+void force_batch_free(force_batch_t *batch) {
+  mem_free(MEM_FORCE, batch->body1, batch->capacity * sizeof(body_t *));
+  mem_free(MEM_FORCE, batch->body2, batch->capacity * sizeof(body_t *));
+  mem_free(MEM_FORCE, batch->constant, batch->capacity * sizeof(double));
+  mem_free(MEM_FORCE, batch->impulse, batch->capacity * sizeof(double));
+  mem_free(MEM_FORCE, batch, sizeof(force_batch_t));
+}
+
+force_kind_t force_batch_kind(force_batch_t *batch) { return batch->kind; }
+
+size_t force_batch_size(force_batch_t *batch) { return batch->size; }
+
+void force_batch_add(force_batch_t *batch, double constant, body_t *body1,
+                     body_t *body2) {
+  assert(body1 != NULL);
+  assert(body2 != NULL || batch->kind == FORCE_DRAG);
+  if (batch->size == batch->capacity) {
+    force_batch_set_capacity(batch, 2 * batch->capacity);
+  }
+  batch->body1[batch->size] = body1;
+  batch->body2[batch->size] = body2;
+  batch->constant[batch->size] = constant;
+  batch->impulse[batch->size] = 0;
+  batch->size++;
+}
+
+double force_batch_get_constant(force_batch_t *batch, size_t index) {
+  assert(index < batch->size);
+  return batch->constant[index];
+}
+
+double force_batch_get_impulse(force_batch_t *batch, size_t index) {
+  assert(index < batch->size);
+  return batch->impulse[index];
+}
+
+void force_batch_set_impulse(force_batch_t *batch, size_t index,
+                             double impulse) {
+  assert(index < batch->size);
+  batch->impulse[index] = impulse;
+}
+
+body_t *force_batch_get_body(force_batch_t *batch, size_t index,
+                             size_t which) {
+  assert(index < batch->size);
+  assert(which < 2);
+  return which == 0 ? batch->body1[index] : batch->body2[index];
+}
+
+void apply_drag(force_batch_t *batch) {
+  for (size_t i = 0; i < batch->size; i++) {
+    body_t *body = batch->body1[i];
+    vector_t velocity = body_get_velocity(body);
+    double gamma = batch->constant[i];
+    body_add_force(body, (vector_t){-gamma * velocity.x, -gamma * velocity.y});
+  }
+}
+
+void apply_springs(force_batch_t *batch) {
+  for (size_t i = 0; i < batch->size; i++) {
+    body_t *body1 = batch->body1[i];
+    body_t *body2 = batch->body2[i];
+    vector_t center_1 = body_get_centroid(body1);
+    vector_t center_2 = body_get_centroid(body2);
+    double k = batch->constant[i];
+    vector_t force = {k * (center_2.x - center_1.x),
+                      k * (center_2.y - center_1.y)};
+    body_add_force(body1, force);
+    body_add_force(body2, (vector_t){-force.x, -force.y});
+  }
+}
+
+void apply_gravity(force_batch_t *batch) {
+  for (size_t i = 0; i < batch->size; i++) {
+    body_t *body1 = batch->body1[i];
+    body_t *body2 = batch->body2[i];
+    vector_t center_1 = body_get_centroid(body1);
+    vector_t center_2 = body_get_centroid(body2);
+    double dx = center_2.x - center_1.x;
+    double dy = center_2.y - center_1.y;
+    double distance_sq = dx * dx + dy * dy;
+    if (distance_sq <= MIN_GRAVITY_DISTANCE * MIN_GRAVITY_DISTANCE) {
+      continue;
+    }
+    double distance = sqrt(distance_sq);
+    double scalar = -batch->constant[i] * body_get_mass(body1) *
+                    body_get_mass(body2) / (distance_sq * distance);
+    vector_t force = {scalar * dx, scalar * dy};
+    body_add_force(body2, force);
+    body_add_force(body1, (vector_t){-force.x, -force.y});
+  }
+}
+
+void force_batch_apply(force_batch_t *batch) {
+  switch (batch->kind) {
+  case FORCE_DRAG:
+    apply_drag(batch);
+    break;
+  case FORCE_SPRING:
+    apply_springs(batch);
+    break;
+  case FORCE_GRAVITY:
+    apply_gravity(batch);
+    break;
+  case FORCE_PHYSICS_COLLISION:
+    // Resolved by the contact solver instead
+    break;
+  default:
+    assert(false);
+  }
+}
+
+size_t force_batch_remove_dead(force_batch_t *batch) {
+  size_t kept = 0;
+  for (size_t i = 0; i < batch->size; i++) {
+    body_t *body1 = batch->body1[i];
+    body_t *body2 = batch->body2[i];
+    if (body_is_removed(body1) || (body2 != NULL && body_is_removed(body2))) {
+      continue;
+    }
+    batch->body1[kept] = body1;
+    batch->body2[kept] = body2;
+    batch->constant[kept] = batch->constant[i];
+    batch->impulse[kept] = batch->impulse[i];
+    kept++;
+  }
+  size_t removed = batch->size - kept;
+  batch->size = kept;
+  return removed;
+}
+
+size_t force_batch_memory_size(force_batch_t *batch) {
+  return sizeof(force_batch_t) +
+         batch->capacity * (2 * sizeof(body_t *) + 2 * sizeof(double));
+}
@@ -0,0 +1,78 @@
+#include "input.h"
+#include "mem_stats.h"
+#include <assert.h>
+
+typedef struct input_buffer {
+  input_event_t *events;
+  size_t capacity;
+  // events[head] through events[(head + size - 1) % capacity] are queued
+  size_t head;
+  size_t size;
+  size_t dropped;
+} input_buffer_t;
+
+input_buffer_t *input_buffer_init(size_t capacity) {
+  assert(capacity > 0);
+  input_buffer_t *buffer = mem_alloc(MEM_INPUT, sizeof(input_buffer_t));
+  buffer->events = mem_alloc(MEM_INPUT, capacity * sizeof(input_event_t));
+  buffer->capacity = capacity;
+  buffer->head = 0;
+  buffer->size = 0;
+  buffer->dropped = 0;
+  return buffer;
+}
+
+void input_buffer_free(input_buffer_t *buffer) {
+  mem_free(MEM_INPUT, buffer->events, buffer->capacity * sizeof(input_event_t));
+  mem_free(MEM_INPUT, buffer, sizeof(input_buffer_t));
+}
+
+/**
+ * Finds the queued event for the same axis and controller as an event.
+ * Returns NULL if there is none.
+ */
+input_event_t *find_axis(input_buffer_t *buffer, input_event_t event) {
+  for (size_t i = 0; i < buffer->size; i++) {
+    input_event_t *queued =
+        &buffer->events[(buffer->head + i) % buffer->capacity];
+    if (queued->kind == INPUT_AXIS && queued->key == event.key &&
+        queued->which == event.which) {
+      return queued;
+    }
+  }
+  return NULL;
+}
+
+bool input_buffer_push(input_buffer_t *buffer, input_event_t event) {
+  if (event.kind == INPUT_AXIS) {
+    input_event_t *queued = find_axis(buffer, event);
+    if (queued != NULL) {
+      *queued = event;
+      return true;
+    }
+  }
+  if (buffer->size == buffer->capacity) {
+    buffer->dropped++;
+    return false;
+  }
+  size_t tail = (buffer->head + buffer->size) % buffer->capacity;
+  buffer->events[tail] = event;
+  buffer->size++;
+  return true;
+}
+
+bool input_buffer_pop(input_buffer_t *buffer, input_event_t *event) {
+  if (buffer->size == 0) {
+    return false;
+  }
+  *event = buffer->events[buffer->head];
+  buffer->head = (buffer->head + 1) % buffer->capacity;
+  buffer->size--;
+  return true;
+}
+
+size_t input_buffer_size(input_buffer_t *buffer) { return buffer->size; }
+
+size_t input_buffer_dropped(input_buffer_t *buffer) {
+  return buffer->dropped;
+}
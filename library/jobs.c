@@ -0,0 +1,303 @@
+#include "jobs.h"
+#include "mem_stats.h"
+#include <assert.h>
+#include <stdbool.h>
+
+#ifndef __EMSCRIPTEN__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// The number of chunks per thread job_pool_parallel_for() splits a loop into
+const size_t CHUNKS_PER_THREAD = 4;
+const size_t INITIAL_DEQUE_CAPACITY = 64;
+
+typedef struct task {
+  job_task_t func;
+  void *aux;
+  job_join_t *join;
+  // The allocation counter of the thread that spawned the task
+  atomic_size_t *calls;
+} task_t;
+
+#ifndef __EMSCRIPTEN__
+/**
+ * A thread's tasks, in a ring buffer. The owner pushes and pops at the
+ * bottom; thieves take from the top. Each deque has its own lock,
+ * held only for a single push, pop or steal.
+ */
+typedef struct deque {
+  pthread_mutex_t lock;
+  task_t *tasks;
+  size_t capacity;
+  // tasks[top % capacity] through tasks[(bottom - 1) % capacity] are queued
+  size_t top;
+  size_t bottom;
+} deque_t;
+
+typedef struct worker {
+  job_pool_t *pool;
+  size_t index;
+  pthread_t thread;
+} worker_t;
+#endif
+
+typedef struct job_pool {
+  size_t thread_count;
+#ifndef __EMSCRIPTEN__
+  // Deque 0 belongs to the thread outside the pool that uses it
+  deque_t *deques;
+  worker_t *workers;
+  // The number of tasks queued in all the deques
+  atomic_size_t queued;
+  // Idle workers sleep on work_ready until a task is queued
+  pthread_mutex_t lock;
+  pthread_cond_t work_ready;
+  atomic_size_t sleeping;
+  bool stopping;
+#endif
+} job_pool_t;
+
+#ifndef __EMSCRIPTEN__
+// The worker running on this thread, or NULL outside every pool
+_Thread_local worker_t *current_worker = NULL;
+
+void deque_init(deque_t *deque) {
+  pthread_mutex_init(&deque->lock, NULL);
+  deque->capacity = INITIAL_DEQUE_CAPACITY;
+  deque->tasks = mem_alloc(MEM_SCENE, deque->capacity * sizeof(task_t));
+  deque->top = 0;
+  deque->bottom = 0;
+}
+
+void deque_free(deque_t *deque) {
+  mem_free(MEM_SCENE, deque->tasks, deque->capacity * sizeof(task_t));
+  pthread_mutex_destroy(&deque->lock);
+}
+
+void deque_push(deque_t *deque, task_t task) {
+  pthread_mutex_lock(&deque->lock);
+  if (deque->bottom - deque->top == deque->capacity) {
+    size_t capacity = 2 * deque->capacity;
+    task_t *tasks = mem_alloc(MEM_SCENE, capacity * sizeof(task_t));
+    for (size_t i = deque->top; i < deque->bottom; i++) {
+      tasks[i % capacity] = deque->tasks[i % deque->capacity];
+    }
+    mem_free(MEM_SCENE, deque->tasks, deque->capacity * sizeof(task_t));
+    deque->tasks = tasks;
+    deque->capacity = capacity;
+  }
+  deque->tasks[deque->bottom % deque->capacity] = task;
+  deque->bottom++;
+  pthread_mutex_unlock(&deque->lock);
+}
+
+bool deque_pop(deque_t *deque, task_t *task) {
+  pthread_mutex_lock(&deque->lock);
+  bool found = deque->bottom > deque->top;
+  if (found) {
+    deque->bottom--;
+    *task = deque->tasks[deque->bottom % deque->capacity];
+  }
+  pthread_mutex_unlock(&deque->lock);
+  return found;
+}
+
+bool deque_steal(deque_t *deque, task_t *task) {
+  pthread_mutex_lock(&deque->lock);
+  bool found = deque->bottom > deque->top;
+  if (found) {
+    *task = deque->tasks[deque->top % deque->capacity];
+    deque->top++;
+  }
+  pthread_mutex_unlock(&deque->lock);
+  return found;
+}
+
+size_t current_index(job_pool_t *pool) {
+  worker_t *worker = current_worker;
+  return worker != NULL && worker->pool == pool ? worker->index : 0;
+}
+
+/**
+ * Runs one queued task, preferring the thread's own newest task
+ * and otherwise stealing the oldest task of the next busy thread.
+ *
+ * @return whether a task was found
+ */
+bool run_one_task(job_pool_t *pool, size_t self) {
+  task_t task;
+  bool found = deque_pop(&pool->deques[self], &task);
+  for (size_t i = 1; !found && i < pool->thread_count; i++) {
+    found = deque_steal(&pool->deques[(self + i) % pool->thread_count], &task);
+  }
+  if (!found) {
+    return false;
+  }
+  atomic_fetch_sub(&pool->queued, 1);
+  atomic_size_t *calls = mem_count_calls(task.calls);
+  task.func(task.aux);
+  mem_count_calls(calls);
+  atomic_fetch_sub(&task.join->pending, 1);
+  return true;
+}
+
+void *worker_main(void *arg) {
+  worker_t *worker = arg;
+  job_pool_t *pool = worker->pool;
+  current_worker = worker;
+  while (true) {
+    if (run_one_task(pool, worker->index)) {
+      continue;
+    }
+    pthread_mutex_lock(&pool->lock);
+    atomic_fetch_add(&pool->sleeping, 1);
+    while (!pool->stopping && atomic_load(&pool->queued) == 0) {
+      pthread_cond_wait(&pool->work_ready, &pool->lock);
+    }
+    atomic_fetch_sub(&pool->sleeping, 1);
+    bool stopping = pool->stopping;
+    pthread_mutex_unlock(&pool->lock);
+    if (stopping) {
+      break;
+    }
+  }
+  return NULL;
+}
+#endif
+
+job_pool_t *job_pool_init(size_t threads) {
+  assert(threads > 0);
+  job_pool_t *pool = mem_alloc(MEM_SCENE, sizeof(job_pool_t));
+#ifdef __EMSCRIPTEN__
+  pool->thread_count = 1;
+#else
+  pool->thread_count = threads;
+  atomic_init(&pool->queued, 0);
+  atomic_init(&pool->sleeping, 0);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work_ready, NULL);
+  pool->stopping = false;
+  pool->deques = mem_alloc(MEM_SCENE, threads * sizeof(deque_t));
+  pool->workers = mem_alloc(MEM_SCENE, threads * sizeof(worker_t));
+  for (size_t i = 0; i < threads; i++) {
+    deque_init(&pool->deques[i]);
+    pool->workers[i].pool = pool;
+    pool->workers[i].index = i;
+  }
+  // Worker 0 stands for the thread outside the pool, so it gets no thread
+  for (size_t i = 1; i < threads; i++) {
+    worker_t *worker = &pool->workers[i];
+    int error = pthread_create(&worker->thread, NULL, worker_main, worker);
+    assert(error == 0);
+  }
+#endif
+  return pool;
+}
+
+void job_pool_free(job_pool_t *pool) {
+#ifndef __EMSCRIPTEN__
+  pthread_mutex_lock(&pool->lock);
+  pool->stopping = true;
+  pthread_cond_broadcast(&pool->work_ready);
+  pthread_mutex_unlock(&pool->lock);
+  for (size_t i = 1; i < pool->thread_count; i++) {
+    pthread_join(pool->workers[i].thread, NULL);
+  }
+  for (size_t i = 0; i < pool->thread_count; i++) {
+    deque_free(&pool->deques[i]);
+  }
+  mem_free(MEM_SCENE, pool->deques, pool->thread_count * sizeof(deque_t));
+  mem_free(MEM_SCENE, pool->workers, pool->thread_count * sizeof(worker_t));
+  pthread_cond_destroy(&pool->work_ready);
+  pthread_mutex_destroy(&pool->lock);
+#endif
+  mem_free(MEM_SCENE, pool, sizeof(job_pool_t));
+}
+
+size_t job_pool_threads(job_pool_t *pool) { return pool->thread_count; }
+
+void job_join_init(job_join_t *join) { atomic_init(&join->pending, 0); }
+
+void job_pool_spawn(job_pool_t *pool, job_join_t *join, job_task_t task,
+                    void *aux) {
+  if (pool->thread_count == 1) {
+    task(aux);
+    return;
+  }
+#ifndef __EMSCRIPTEN__
+  // Counted before it is pushed, so a thief never takes an uncounted task
+  atomic_fetch_add(&join->pending, 1);
+  atomic_fetch_add(&pool->queued, 1);
+  deque_push(&pool->deques[current_index(pool)],
+             (task_t){.func = task,
+                      .aux = aux,
+                      .join = join,
+                      .calls = mem_call_counter()});
+  // A worker that saw no queued tasks is either asleep or about to take
+  // the lock to sleep, so signalling under the lock cannot be missed
+  if (atomic_load(&pool->sleeping) > 0) {
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+  }
+#endif
+}
+
+void job_pool_join(job_pool_t *pool, job_join_t *join) {
+#ifndef __EMSCRIPTEN__
+  size_t self = current_index(pool);
+  while (atomic_load(&join->pending) > 0) {
+    if (!run_one_task(pool, self)) {
+      // The remaining tasks are running on other threads
+      sched_yield();
+    }
+  }
+#endif
+}
+
+typedef struct range {
+  job_pool_t *pool;
+  job_func_t func;
+  void *aux;
+  size_t start;
+  size_t end;
+  size_t grain;
+} range_t;
+
+void run_range(void *aux) {
+  range_t *range = aux;
+  if (range->end - range->start <= range->grain) {
+    for (size_t i = range->start; i < range->end; i++) {
+      range->func(range->aux, i);
+    }
+    return;
+  }
+  // Fork the upper half for another thread to steal, and run the lower half
+  size_t middle = range->start + (range->end - range->start) / 2;
+  range_t upper = *range;
+  upper.start = middle;
+  range_t lower = *range;
+  lower.end = middle;
+  job_join_t join;
+  job_join_init(&join);
+  job_pool_spawn(range->pool, &join, run_range, &upper);
+  run_range(&lower);
+  job_pool_join(range->pool, &join);
+}
+
+void job_pool_parallel_for(job_pool_t *pool, size_t count, job_func_t func,
+                           void *aux) {
+  size_t chunks = pool->thread_count * CHUNKS_PER_THREAD;
+  size_t grain = (count + chunks - 1) / chunks;
+  if (pool->thread_count == 1) {
+    grain = count;
+  }
+  range_t range = {.pool = pool,
+                   .func = func,
+                   .aux = aux,
+                   .start = 0,
+                   .end = count,
+                   .grain = grain > 0 ? grain : 1};
+  run_range(&range);
+}
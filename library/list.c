@@ -1,3 +1,4 @@
+#include "mem_stats.h"
 #include <assert.h>
 #include <list.h>
 
@@ -9,10 +10,8 @@ typedef struct list {
 } list_t;
 
 list_t *list_init(size_t initial_size, free_func_t freer) {
-  list_t *list = malloc(sizeof(list_t));
-  assert(list != NULL);
-  list->array = malloc(sizeof(list_t *) * initial_size);
-  assert(list->array != NULL);
+  list_t *list = mem_alloc(MEM_LIST, sizeof(list_t));
+  list->array = mem_alloc(MEM_LIST, sizeof(list_t *) * initial_size);
   list->size = 0;
   list->alloc = initial_size;
   list->freer = freer;
@@ -24,44 +23,46 @@ void list_free(list_t *list) {
     for (size_t i = 0; i < list_size(list); i++) {
       list->freer(list_get(list, i));
     }
-    free(list->array);
-    free(list);
-  } else {
-    free(list->array);
-    free(list);
   }
+  mem_free(MEM_LIST, list->array, list->alloc * sizeof(list_t *));
+  mem_free(MEM_LIST, list, sizeof(list_t));
 }
 
 size_t list_size(list_t *list) { return list->size; }
 
+size_t list_memory_size(list_t *list) {
+  return sizeof(list_t) + list->alloc * sizeof(list_t *);
+}
+
 void *list_get(list_t *list, size_t index) {
-  if (index > list->size || index < 0) {
+  if (index >= list->size) {
     abort();
   }
   return list->array[index];
 }
 
-void list_resize(list_t *list) {
-  if (list->alloc == 0) {
-    list->alloc += 1;
-  }
-  size_t new_alloc = 2 * list->alloc;
-  list->array = realloc(list->array, new_alloc * sizeof(list_t *));
-  assert(list->array != NULL);
+void list_set_alloc(list_t *list, size_t new_alloc) {
+  list->array = mem_realloc(MEM_LIST, list->array,
+                            list->alloc * sizeof(list_t *),
+                            new_alloc * sizeof(list_t *));
   list->alloc = new_alloc;
 }
 
+void list_resize(list_t *list) {
+  size_t new_alloc = list->alloc ? 2 * list->alloc : 2;
+  list_set_alloc(list, new_alloc);
+}
+
 void *list_remove(list_t *list, size_t index) {
-  if (list->size > 0) {
-    void *ret = list->array[index];
-    list->array[index] = NULL;
-    for (size_t i = index + 1; i < list->size; i++) {
-      list->array[i - 1] = list->array[i];
-    }
-    list->size -= 1;
-    return ret;
+  if (index >= list->size) {
+    abort();
   }
-  abort();
+  void *ret = list->array[index];
+  for (size_t i = index + 1; i < list->size; i++) {
+    list->array[i - 1] = list->array[i];
+  }
+  list->size -= 1;
+  return ret;
 }
 
 void list_add(list_t *list, void *value) {
@@ -74,4 +75,63 @@ void list_add(list_t *list, void *value) {
   } else {
     abort();
   }
-}
\ No newline at end of file
+}
+
+void list_reserve(list_t *list, size_t capacity) {
+  if (capacity > list->alloc) {
+    list_set_alloc(list, capacity);
+  }
+}
+
+void list_shrink_to_fit(list_t *list) {
+  size_t new_alloc = list->size > 0 ? list->size : 1;
+  if (new_alloc != list->alloc) {
+    list_set_alloc(list, new_alloc);
+  }
+}
+
+void list_extend(list_t *list, list_t *other) {
+  size_t count = other->size;
+  if (list->size + count > list->alloc) {
+    size_t new_alloc = list->alloc > 0 ? 2 * list->alloc : 1;
+    while (new_alloc < list->size + count) {
+      new_alloc *= 2;
+    }
+    list_set_alloc(list, new_alloc);
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (other->array[i] == NULL) {
+      abort();
+    }
+    list->array[list->size + i] = other->array[i];
+  }
+  list->size += count;
+}
+
+void *list_swap_remove(list_t *list, size_t index) {
+  if (index >= list->size) {
+    abort();
+  }
+  void *ret = list->array[index];
+  list->size -= 1;
+  list->array[index] = list->array[list->size];
+  return ret;
+}
+
+size_t list_erase_if(list_t *list, list_pred_t pred, void *aux) {
+  size_t kept = 0;
+  for (size_t i = 0; i < list->size; i++) {
+    void *value = list->array[i];
+    if (pred(value, aux)) {
+      if (list->freer != NULL) {
+        list->freer(value);
+      }
+    } else {
+      list->array[kept] = value;
+      kept++;
+    }
+  }
+  size_t removed = list->size - kept;
+  list->size = kept;
+  return removed;
+}
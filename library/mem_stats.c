@@ -0,0 +1,76 @@
+#include "mem_stats.h"
+#include "vector.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+// The counters are atomic since force creators may run on worker threads
+typedef struct mem_counter {
+  atomic_size_t live_bytes;
+  atomic_size_t live_count;
+} mem_counter_t;
+
+mem_counter_t mem_counters[MEM_KINDS];
+atomic_size_t alloc_calls = 0;
+// The counter this thread's allocator calls are also charged to, or NULL
+_Thread_local atomic_size_t *call_counter = NULL;
+
+void count_call(void) {
+  alloc_calls++;
+  if (call_counter != NULL) {
+    (*call_counter)++;
+  }
+}
+
+void *mem_alloc(mem_kind_t kind, size_t size) {
+  void *ptr = malloc(size);
+  assert(ptr != NULL || size == 0);
+  count_call();
+  mem_counters[kind].live_bytes += size;
+  mem_counters[kind].live_count++;
+  return ptr;
+}
+
+void *mem_realloc(mem_kind_t kind, void *ptr, size_t old_size,
+                  size_t new_size) {
+  // realloc() may or may not free the memory for a size of 0
+  if (new_size == 0) {
+    mem_free(kind, ptr, old_size);
+    return NULL;
+  }
+  void *new_ptr = realloc(ptr, new_size);
+  assert(new_ptr != NULL);
+  count_call();
+  mem_counters[kind].live_bytes += new_size - old_size;
+  if (ptr == NULL) {
+    mem_counters[kind].live_count++;
+  }
+  return new_ptr;
+}
+
+void mem_free(mem_kind_t kind, void *ptr, size_t size) {
+  if (ptr == NULL) {
+    return;
+  }
+  free(ptr);
+  mem_counters[kind].live_bytes -= size;
+  mem_counters[kind].live_count--;
+}
+
+void mem_vertex_free(void *vertex) {
+  mem_free(MEM_VERTEX, vertex, sizeof(vector_t));
+}
+
+size_t mem_alloc_calls(void) { return alloc_calls; }
+
+atomic_size_t *mem_count_calls(atomic_size_t *counter) {
+  atomic_size_t *previous = call_counter;
+  call_counter = counter;
+  return previous;
+}
+
+atomic_size_t *mem_call_counter(void) { return call_counter; }
+
+size_t mem_live_bytes(mem_kind_t kind) { return mem_counters[kind].live_bytes; }
+
+size_t mem_live_count(mem_kind_t kind) { return mem_counters[kind].live_count; }
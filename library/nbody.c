@@ -0,0 +1,284 @@
+#include "nbody.h"
+#include "force_batch.h"
+#include "mem_stats.h"
+#include <assert.h>
+#include <math.h>
+
+// Bodies at the same position can't be separated by subdividing,
+// so leaves this deep hold a list of bodies instead of splitting
+#define MAX_DEPTH 48
+#define NO_BODY ((size_t)-1)
+
+typedef struct node {
+  vector_t center;
+  double half_size;
+  double mass;
+  // The mass-weighted sum of positions while building,
+  // then the center of mass
+  vector_t center_of_mass;
+  // The index of the first of the node's 4 children, or 0 for a leaf
+  size_t children;
+  // The first body in a leaf, linked through nbody->next
+  size_t first;
+} node_t;
+
+typedef struct nbody {
+  double G;
+  double theta;
+
+  // The bodies with finite mass gathered from the scene this tick
+  size_t body_count;
+  size_t body_capacity;
+  body_t **bodies;
+  vector_t *positions;
+  double *masses;
+  size_t *next;
+
+  node_t *nodes;
+  size_t node_count;
+  size_t node_capacity;
+} nbody_t;
+
+nbody_t *nbody_init(double G, double theta) {
+  assert(theta >= 0);
+  nbody_t *nbody = mem_alloc(MEM_FORCE, sizeof(nbody_t));
+  nbody->G = G;
+  nbody->theta = theta;
+  nbody->body_count = 0;
+  nbody->body_capacity = 0;
+  nbody->bodies = NULL;
+  nbody->positions = NULL;
+  nbody->masses = NULL;
+  nbody->next = NULL;
+  nbody->nodes = NULL;
+  nbody->node_count = 0;
+  nbody->node_capacity = 0;
+  return nbody;
+}
+
+void nbody_free(nbody_t *nbody) {
+  size_t capacity = nbody->body_capacity;
+  mem_free(MEM_FORCE, nbody->bodies, capacity * sizeof(body_t *));
+  mem_free(MEM_FORCE, nbody->positions, capacity * sizeof(vector_t));
+  mem_free(MEM_FORCE, nbody->masses, capacity * sizeof(double));
+  mem_free(MEM_FORCE, nbody->next, capacity * sizeof(size_t));
+  mem_free(MEM_FORCE, nbody->nodes, nbody->node_capacity * sizeof(node_t));
+  mem_free(MEM_FORCE, nbody, sizeof(nbody_t));
+}
+
+double nbody_get_theta(nbody_t *nbody) { return nbody->theta; }
+
+size_t nbody_tree_size(nbody_t *nbody) { return nbody->node_count; }
+
+void gather_bodies(nbody_t *nbody, scene_t *scene) {
+  size_t count = scene_bodies(scene);
+  if (count > nbody->body_capacity) {
+    size_t old = nbody->body_capacity;
+    nbody->bodies = mem_realloc(MEM_FORCE, nbody->bodies,
+                                old * sizeof(body_t *), count * sizeof(body_t *));
+    nbody->positions =
+        mem_realloc(MEM_FORCE, nbody->positions, old * sizeof(vector_t),
+                    count * sizeof(vector_t));
+    nbody->masses = mem_realloc(MEM_FORCE, nbody->masses, old * sizeof(double),
+                                count * sizeof(double));
+    nbody->next = mem_realloc(MEM_FORCE, nbody->next, old * sizeof(size_t),
+                              count * sizeof(size_t));
+    nbody->body_capacity = count;
+  }
+  nbody->body_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    body_t *body = scene_get_body(scene, i);
+    double mass = body_get_mass(body);
+    if (mass == INFINITY || mass == 0) {
+      continue;
+    }
+    nbody->bodies[nbody->body_count] = body;
+    nbody->positions[nbody->body_count] = body_get_centroid(body);
+    nbody->masses[nbody->body_count] = mass;
+    nbody->body_count++;
+  }
+}
+
+/**
+ * Adds a node to the tree, growing the node buffer if needed.
+ * Any node pointers held across this call are invalidated.
+ */
+size_t add_node(nbody_t *nbody, vector_t center, double half_size) {
+  if (nbody->node_count == nbody->node_capacity) {
+    size_t capacity = nbody->node_capacity > 0 ? 2 * nbody->node_capacity : 16;
+    nbody->nodes =
+        mem_realloc(MEM_FORCE, nbody->nodes,
+                    nbody->node_capacity * sizeof(node_t),
+                    capacity * sizeof(node_t));
+    nbody->node_capacity = capacity;
+  }
+  node_t *node = &nbody->nodes[nbody->node_count];
+  node->center = center;
+  node->half_size = half_size;
+  node->mass = 0;
+  node->center_of_mass = VEC_ZERO;
+  node->children = 0;
+  node->first = NO_BODY;
+  return nbody->node_count++;
+}
+
+size_t child_for(node_t *node, vector_t position) {
+  return node->children + (position.x >= node->center.x ? 1 : 0) +
+         (position.y >= node->center.y ? 2 : 0);
+}
+
+void split_node(nbody_t *nbody, size_t index) {
+  node_t node = nbody->nodes[index];
+  double quarter = node.half_size / 2;
+  size_t children = nbody->node_count;
+  for (size_t i = 0; i < 4; i++) {
+    vector_t offset = {i & 1 ? quarter : -quarter, i & 2 ? quarter : -quarter};
+    add_node(nbody, vec_add(node.center, offset), quarter);
+  }
+  node_t *parent = &nbody->nodes[index];
+  parent->children = children;
+  parent->first = NO_BODY;
+
+  // A leaf that is not at MAX_DEPTH holds exactly one body
+  size_t body = node.first;
+  node_t *child = &nbody->nodes[child_for(parent, nbody->positions[body])];
+  child->first = body;
+  child->mass = nbody->masses[body];
+  child->center_of_mass = vec_multiply(child->mass, nbody->positions[body]);
+}
+
+void insert_body(nbody_t *nbody, size_t body) {
+  vector_t position = nbody->positions[body];
+  double mass = nbody->masses[body];
+  size_t index = 0;
+  for (size_t depth = 0;; depth++) {
+    node_t *node = &nbody->nodes[index];
+    node->mass += mass;
+    node->center_of_mass =
+        vec_add(node->center_of_mass, vec_multiply(mass, position));
+    if (node->children == 0) {
+      if (node->first == NO_BODY || depth == MAX_DEPTH) {
+        nbody->next[body] = node->first;
+        node->first = body;
+        return;
+      }
+      split_node(nbody, index);
+      node = &nbody->nodes[index];
+    }
+    index = child_for(node, position);
+  }
+}
+
+void build_tree(nbody_t *nbody) {
+  nbody->node_count = 0;
+  vector_t min = nbody->positions[0];
+  vector_t max = nbody->positions[0];
+  for (size_t i = 1; i < nbody->body_count; i++) {
+    vector_t position = nbody->positions[i];
+    min = (vector_t){fmin(min.x, position.x), fmin(min.y, position.y)};
+    max = (vector_t){fmax(max.x, position.x), fmax(max.y, position.y)};
+  }
+  // Pad the root so bodies on its upper edges fall inside it
+  double half_size = fmax(max.x - min.x, max.y - min.y) / 2 + 1;
+  add_node(nbody, vec_multiply(0.5, vec_add(min, max)), half_size);
+  for (size_t i = 0; i < nbody->body_count; i++) {
+    insert_body(nbody, i);
+  }
+  for (size_t i = 0; i < nbody->node_count; i++) {
+    node_t *node = &nbody->nodes[i];
+    if (node->mass > 0) {
+      node->center_of_mass = vec_multiply(1 / node->mass, node->center_of_mass);
+    }
+  }
+}
+
+/**
+ * Computes the acceleration per unit G at one position
+ * due to a point mass at another.
+ */
+vector_t attraction(vector_t position, vector_t source, double mass) {
+  double dx = source.x - position.x;
+  double dy = source.y - position.y;
+  double distance_sq = dx * dx + dy * dy;
+  if (distance_sq <= MIN_GRAVITY_DISTANCE * MIN_GRAVITY_DISTANCE) {
+    return VEC_ZERO;
+  }
+  double scalar = mass / (distance_sq * sqrt(distance_sq));
+  return (vector_t){scalar * dx, scalar * dy};
+}
+
+bool node_contains(node_t *node, vector_t position) {
+  return fabs(position.x - node->center.x) <= node->half_size &&
+         fabs(position.y - node->center.y) <= node->half_size;
+}
+
+vector_t tree_attraction(nbody_t *nbody, size_t body) {
+  vector_t position = nbody->positions[body];
+  double theta_sq = nbody->theta * nbody->theta;
+  vector_t total = VEC_ZERO;
+  // Opening a node replaces it with its 4 children,
+  // so at most 3 siblings per level are ever waiting on the stack
+  size_t stack[4 * MAX_DEPTH + 4];
+  size_t stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size > 0) {
+    node_t *node = &nbody->nodes[stack[--stack_size]];
+    if (node->mass == 0) {
+      continue;
+    }
+    if (node->children == 0) {
+      for (size_t other = node->first; other != NO_BODY;
+           other = nbody->next[other]) {
+        if (other != body) {
+          total = vec_add(total, attraction(position, nbody->positions[other],
+                                            nbody->masses[other]));
+        }
+      }
+      continue;
+    }
+    vector_t offset = vec_subtract(node->center_of_mass, position);
+    double distance_sq = vec_dot(offset, offset);
+    double size = 2 * node->half_size;
+    if (size * size < theta_sq * distance_sq &&
+        distance_sq > MIN_GRAVITY_DISTANCE * MIN_GRAVITY_DISTANCE &&
+        !node_contains(node, position)) {
+      total = vec_add(total, attraction(position, node->center_of_mass,
+                                        node->mass));
+      continue;
+    }
+    for (size_t i = 0; i < 4; i++) {
+      stack[stack_size++] = node->children + i;
+    }
+  }
+  return total;
+}
+
+void nbody_apply(nbody_t *nbody, scene_t *scene) {
+  gather_bodies(nbody, scene);
+  if (nbody->body_count == 0) {
+    nbody->node_count = 0;
+    return;
+  }
+  build_tree(nbody);
+  for (size_t i = 0; i < nbody->body_count; i++) {
+    double scale = nbody->G * nbody->masses[i];
+    body_add_force(nbody->bodies[i],
+                   vec_multiply(scale, tree_attraction(nbody, i)));
+  }
+}
+
+void nbody_apply_brute_force(nbody_t *nbody, scene_t *scene) {
+  gather_bodies(nbody, scene);
+  for (size_t i = 0; i < nbody->body_count; i++) {
+    vector_t total = VEC_ZERO;
+    for (size_t j = 0; j < nbody->body_count; j++) {
+      if (j != i) {
+        total = vec_add(total, attraction(nbody->positions[i],
+                                          nbody->positions[j],
+                                          nbody->masses[j]));
+      }
+    }
+    double scale = nbody->G * nbody->masses[i];
+    body_add_force(nbody->bodies[i], vec_multiply(scale, total));
+  }
+}
@@ -1,4 +1,5 @@
 #include "list.h"
+#include "mem_stats.h"
 #include "star.h"
 #include <assert.h>
 #include <stdio.h>
@@ -8,6 +9,7 @@ typedef struct poly_list {
   void **array;
   size_t size;
   size_t alloc;
+  free_func_t freer;
 } poly_list_t;
 
 poly_list_t *poly_list_init(size_t initial_size) {
@@ -17,8 +19,8 @@ poly_list_t *poly_list_init(size_t initial_size) {
 void poly_list_free(poly_list_t *list) { list_free((list_t *)list); }
 
 void poly_list_array_free(poly_list_t *list) {
-  free(list->array);
-  free(list);
+  mem_free(MEM_LIST, list->array, list->alloc * sizeof(void *));
+  mem_free(MEM_LIST, list, sizeof(*list));
 }
 
 size_t poly_list_size(poly_list_t *list) { return list_size((list_t *)list); }
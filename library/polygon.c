@@ -1,6 +1,7 @@
 #include "polygon.h"
 #include <assert.h>
 #include <math.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -63,4 +64,123 @@ void polygon_rotate(list_t *polygon, double angle, vector_t point) {
     current_vec->x = final_vec.x;
     current_vec->y = final_vec.y;
   }
-}
\ No newline at end of file
+}
+
+/**
+ * Computes which side of the line from a to b a point is on:
+ * positive to the left, negative to the right and 0 on the line.
+ */
+double line_side(vector_t a, vector_t b, vector_t point) {
+  return vec_cross(vec_subtract(b, a), vec_subtract(point, a));
+}
+
+/**
+ * Checks whether a point lies inside or on the edge of a triangle
+ * listed in the direction given by the sign of orientation.
+ */
+bool triangle_contains(vector_t a, vector_t b, vector_t c, vector_t point,
+                       double orientation) {
+  return orientation * line_side(a, b, point) >= 0 &&
+         orientation * line_side(b, c, point) >= 0 &&
+         orientation * line_side(c, a, point) >= 0;
+}
+
+/**
+ * Checks whether the vertex at remaining[i] is an ear: a convex vertex
+ * whose triangle with its neighbors contains no other remaining vertex.
+ */
+bool is_ear(list_t *polygon, size_t *remaining, size_t count, size_t i,
+            double orientation) {
+  size_t prev_index = remaining[(i + count - 1) % count];
+  size_t next_index = remaining[(i + 1) % count];
+  vector_t prev = *(vector_t *)list_get(polygon, prev_index);
+  vector_t vertex = *(vector_t *)list_get(polygon, remaining[i]);
+  vector_t next = *(vector_t *)list_get(polygon, next_index);
+  if (orientation * line_side(prev, vertex, next) <= 0) {
+    return false;
+  }
+  for (size_t j = 0; j < count; j++) {
+    if (j == i || j == (i + 1) % count || j == (i + count - 1) % count) {
+      continue;
+    }
+    vector_t point = *(vector_t *)list_get(polygon, remaining[j]);
+    if (triangle_contains(prev, vertex, next, point, orientation)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Checks whether every vertex of a polygon turns strictly in the direction
+ * given by the sign of orientation, so a fan from any vertex covers it.
+ */
+bool is_convex(list_t *polygon, size_t size, double orientation) {
+  for (size_t i = 0; i < size; i++) {
+    vector_t prev = *(vector_t *)list_get(polygon, (i + size - 1) % size);
+    vector_t vertex = *(vector_t *)list_get(polygon, i);
+    vector_t next = *(vector_t *)list_get(polygon, (i + 1) % size);
+    if (orientation * line_side(prev, vertex, next) <= 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t polygon_triangulate(list_t *polygon, size_t *indices,
+                           size_t *remaining) {
+  size_t size = vec_list_size((vec_list_t *)polygon);
+  assert(size >= 3);
+  double double_area = 0;
+  for (size_t i = 0; i < size; i++) {
+    double_area += vec_cross(*(vector_t *)list_get(polygon, i),
+                             *(vector_t *)list_get(polygon, (i + 1) % size));
+  }
+  double orientation = double_area < 0 ? -1 : 1;
+
+  // Most shapes are convex, and a fan takes linear time
+  if (is_convex(polygon, size, orientation)) {
+    for (size_t i = 0; i + 2 < size; i++) {
+      indices[3 * i] = 0;
+      indices[3 * i + 1] = i + 1;
+      indices[3 * i + 2] = i + 2;
+    }
+    return size - 2;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    remaining[i] = i;
+  }
+  size_t count = size;
+  size_t triangles = 0;
+  size_t start = 0;
+  while (count > 3) {
+    size_t ear = start;
+    size_t tried = 0;
+    while (tried < count &&
+           !is_ear(polygon, remaining, count, ear, orientation)) {
+      ear = (ear + 1) % count;
+      tried++;
+    }
+    // A degenerate polygon (e.g. with collinear vertices) may have no ear
+    // left; clipping any vertex still covers it
+    if (tried == count) {
+      ear = start;
+    }
+    indices[3 * triangles] = remaining[(ear + count - 1) % count];
+    indices[3 * triangles + 1] = remaining[ear];
+    indices[3 * triangles + 2] = remaining[(ear + 1) % count];
+    triangles++;
+    for (size_t i = ear; i + 1 < count; i++) {
+      remaining[i] = remaining[i + 1];
+    }
+    count--;
+    // Ears tend to appear next to the one just clipped
+    start = ear < count ? ear : 0;
+  }
+  indices[3 * triangles] = remaining[0];
+  indices[3 * triangles + 1] = remaining[1];
+  indices[3 * triangles + 2] = remaining[2];
+  triangles++;
+  return triangles;
+}
@@ -0,0 +1,99 @@
+#include "ptr_map.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef struct ptr_map {
+  mem_kind_t kind;
+  const void **keys;
+  size_t *values;
+  // Always a power of 2, at least twice the number of keys
+  size_t capacity;
+  size_t size;
+} ptr_map_t;
+
+void ptr_map_set_capacity(ptr_map_t *map, size_t needed) {
+  size_t capacity = 1;
+  while (capacity < 2 * needed) {
+    capacity *= 2;
+  }
+  if (capacity <= map->capacity) {
+    return;
+  }
+  const void **keys = map->keys;
+  size_t *values = map->values;
+  size_t old_capacity = map->capacity;
+  map->keys = mem_alloc(map->kind, capacity * sizeof(void *));
+  map->values = mem_alloc(map->kind, capacity * sizeof(size_t));
+  memset(map->keys, 0, capacity * sizeof(void *));
+  map->capacity = capacity;
+  map->size = 0;
+  for (size_t i = 0; i < old_capacity; i++) {
+    if (keys[i] != NULL) {
+      ptr_map_put(map, keys[i], values[i]);
+    }
+  }
+  mem_free(map->kind, keys, old_capacity * sizeof(void *));
+  mem_free(map->kind, values, old_capacity * sizeof(size_t));
+}
+
+ptr_map_t *ptr_map_init(mem_kind_t kind, size_t initial_size) {
+  ptr_map_t *map = mem_alloc(kind, sizeof(ptr_map_t));
+  map->kind = kind;
+  map->keys = NULL;
+  map->values = NULL;
+  map->capacity = 0;
+  map->size = 0;
+  ptr_map_set_capacity(map, initial_size > 0 ? initial_size : 1);
+  return map;
+}
+
+void ptr_map_free(ptr_map_t *map) {
+  mem_free(map->kind, map->keys, map->capacity * sizeof(void *));
+  mem_free(map->kind, map->values, map->capacity * sizeof(size_t));
+  mem_free(map->kind, map, sizeof(ptr_map_t));
+}
+
+void ptr_map_clear(ptr_map_t *map, size_t expected_size) {
+  memset(map->keys, 0, map->capacity * sizeof(void *));
+  map->size = 0;
+  ptr_map_set_capacity(map, expected_size);
+}
+
+size_t ptr_map_slot(ptr_map_t *map, const void *key) {
+  // Fibonacci hashing; the low bits of pointers are mostly alignment
+  uint64_t hash = ((uint64_t)(uintptr_t)key >> 4) * 0x9E3779B97F4A7C15ULL;
+  size_t slot = (size_t)(hash >> 32) & (map->capacity - 1);
+  while (map->keys[slot] != NULL && map->keys[slot] != key) {
+    slot = (slot + 1) & (map->capacity - 1);
+  }
+  return slot;
+}
+
+void ptr_map_put(ptr_map_t *map, const void *key, size_t value) {
+  assert(key != NULL);
+  size_t slot = ptr_map_slot(map, key);
+  if (map->keys[slot] == NULL) {
+    if (2 * (map->size + 1) > map->capacity) {
+      ptr_map_set_capacity(map, map->size + 1);
+      slot = ptr_map_slot(map, key);
+    }
+    map->keys[slot] = key;
+    map->size++;
+  }
+  map->values[slot] = value;
+}
+
+size_t ptr_map_get(ptr_map_t *map, const void *key, size_t missing) {
+  if (key == NULL) {
+    return missing;
+  }
+  size_t slot = ptr_map_slot(map, key);
+  return map->keys[slot] == key ? map->values[slot] : missing;
+}
+
+size_t ptr_map_size(ptr_map_t *map) { return map->size; }
+
+size_t ptr_map_memory_size(ptr_map_t *map) {
+  return sizeof(ptr_map_t) + map->capacity * (sizeof(void *) + sizeof(size_t));
+}
@@ -0,0 +1,224 @@
+#include "raster.h"
+#include "polygon.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+const size_t BYTES_PER_PIXEL = 4;
+const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+const uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+typedef struct raster {
+  size_t width;
+  size_t height;
+  uint8_t *pixels;
+  // The scene point drawn at the center of the image
+  vector_t center;
+  // Pixels per scene unit
+  double scale;
+  // Holds the pixel positions and triangles of the polygon being drawn,
+  // followed by the scratch space polygon_triangulate() needs
+  vector_t *points;
+  size_t point_capacity;
+  size_t *indices;
+  size_t index_capacity;
+} raster_t;
+
+raster_t *raster_init(vector_t min, vector_t max, size_t width, size_t height) {
+  assert(min.x < max.x);
+  assert(min.y < max.y);
+  assert(width > 0 && height > 0);
+  raster_t *raster = malloc(sizeof(raster_t));
+  assert(raster != NULL);
+  raster->width = width;
+  raster->height = height;
+  raster->pixels = malloc(width * height * BYTES_PER_PIXEL);
+  assert(raster->pixels != NULL);
+  // Fit the scene in the image, keeping its aspect ratio
+  raster->center = vec_multiply(0.5, vec_add(min, max));
+  double x_scale = width / (max.x - min.x);
+  double y_scale = height / (max.y - min.y);
+  raster->scale = x_scale < y_scale ? x_scale : y_scale;
+  raster->points = NULL;
+  raster->point_capacity = 0;
+  raster->indices = NULL;
+  raster->index_capacity = 0;
+  raster_clear(raster);
+  return raster;
+}
+
+void raster_free(raster_t *raster) {
+  free(raster->pixels);
+  free(raster->points);
+  free(raster->indices);
+  free(raster);
+}
+
+size_t raster_width(raster_t *raster) { return raster->width; }
+
+size_t raster_height(raster_t *raster) { return raster->height; }
+
+const uint8_t *raster_pixels(raster_t *raster) { return raster->pixels; }
+
+void raster_clear(raster_t *raster) {
+  memset(raster->pixels, 255, raster->width * raster->height * BYTES_PER_PIXEL);
+}
+
+void reserve_scratch(raster_t *raster, size_t points, size_t indices) {
+  if (points > raster->point_capacity) {
+    free(raster->points);
+    raster->points = malloc(points * sizeof(vector_t));
+    assert(raster->points != NULL);
+    raster->point_capacity = points;
+  }
+  if (indices > raster->index_capacity) {
+    free(raster->indices);
+    raster->indices = malloc(indices * sizeof(size_t));
+    assert(raster->indices != NULL);
+    raster->index_capacity = indices;
+  }
+}
+
+/** Maps a scene coordinate to a pixel coordinate, like sdl_wrapper.c */
+vector_t get_pixel(raster_t *raster, vector_t scene_pos) {
+  vector_t offset = vec_subtract(scene_pos, raster->center);
+  return (vector_t){.x = 0.5 * raster->width + raster->scale * offset.x,
+                    // Flip y axis since positive y is down in the image
+                    .y = 0.5 * raster->height - raster->scale * offset.y};
+}
+
+/**
+ * Checks whether a pixel center on the inner side of an edge, or exactly
+ * on it, is covered. Of the two triangles sharing an edge, which run
+ * along it in opposite directions, exactly one covers the points on it.
+ */
+bool edge_covers(vector_t from, vector_t to, vector_t point) {
+  vector_t edge = vec_subtract(to, from);
+  double side = vec_cross(edge, vec_subtract(point, from));
+  if (side != 0) {
+    return side > 0;
+  }
+  return edge.y > 0 || (edge.y == 0 && edge.x < 0);
+}
+
+/**
+ * Computes the range of pixel indices whose centers lie between two
+ * coordinates, clamped to [0, size). Returns false if it is empty.
+ */
+bool pixel_range(double min, double max, size_t size, size_t *first,
+                 size_t *last) {
+  double low = ceil(min - 0.5);
+  double high = floor(max - 0.5);
+  if (low < 0) {
+    low = 0;
+  }
+  if (high > (double)size - 1) {
+    high = (double)size - 1;
+  }
+  if (low > high) {
+    return false;
+  }
+  *first = low;
+  *last = high;
+  return true;
+}
+
+void fill_triangle(raster_t *raster, vector_t a, vector_t b, vector_t c,
+                   const uint8_t *rgba) {
+  double area = vec_cross(vec_subtract(b, a), vec_subtract(c, a));
+  if (area == 0) {
+    return;
+  }
+  // Put the interior on the positive side of each edge
+  if (area < 0) {
+    vector_t swap = b;
+    b = c;
+    c = swap;
+  }
+  size_t first_x, last_x, first_y, last_y;
+  if (!pixel_range(fmin(a.x, fmin(b.x, c.x)), fmax(a.x, fmax(b.x, c.x)),
+                   raster->width, &first_x, &last_x) ||
+      !pixel_range(fmin(a.y, fmin(b.y, c.y)), fmax(a.y, fmax(b.y, c.y)),
+                   raster->height, &first_y, &last_y)) {
+    return;
+  }
+  for (size_t y = first_y; y <= last_y; y++) {
+    uint8_t *row = &raster->pixels[y * raster->width * BYTES_PER_PIXEL];
+    for (size_t x = first_x; x <= last_x; x++) {
+      vector_t center = {.x = x + 0.5, .y = y + 0.5};
+      if (edge_covers(a, b, center) && edge_covers(b, c, center) &&
+          edge_covers(c, a, center)) {
+        memcpy(&row[x * BYTES_PER_PIXEL], rgba, BYTES_PER_PIXEL);
+      }
+    }
+  }
+}
+
+/** Fills the triangles listed in raster->indices between raster->points */
+void fill_triangles(raster_t *raster, size_t triangles, rgb_color_t color) {
+  assert(0 <= color.r && color.r <= 1);
+  assert(0 <= color.g && color.g <= 1);
+  assert(0 <= color.b && color.b <= 1);
+  uint8_t rgba[] = {color.r * 255, color.g * 255, color.b * 255, 255};
+  for (size_t i = 0; i < triangles; i++) {
+    size_t *triangle = &raster->indices[3 * i];
+    fill_triangle(raster, raster->points[triangle[0]],
+                  raster->points[triangle[1]], raster->points[triangle[2]],
+                  rgba);
+  }
+}
+
+void raster_draw_polygon(raster_t *raster, list_t *points, rgb_color_t color) {
+  size_t n = list_size(points);
+  assert(n >= 3);
+  reserve_scratch(raster, n, 3 * (n - 2) + n);
+  size_t triangles = polygon_triangulate(points, raster->indices,
+                                         &raster->indices[3 * (n - 2)]);
+  for (size_t i = 0; i < n; i++) {
+    raster->points[i] = get_pixel(raster, *(vector_t *)list_get(points, i));
+  }
+  fill_triangles(raster, triangles, color);
+}
+
+void raster_render_scene(raster_t *raster, scene_t *scene) {
+  raster_clear(raster);
+  size_t body_count = scene_bodies(scene);
+  for (size_t i = 0; i < body_count; i++) {
+    body_t *body = scene_get_body(scene, i);
+    const body_mesh_t *mesh = body_get_mesh(body);
+    if (mesh->triangle_count == 0) {
+      continue;
+    }
+    reserve_scratch(raster, mesh->vertex_count, 3 * mesh->triangle_count);
+    memcpy(raster->indices, mesh->indices,
+           3 * mesh->triangle_count * sizeof(size_t));
+
+    // Move the mesh to the body's position, as sdl_wrapper.c does
+    vector_t position = body_get_centroid(body);
+    double angle = body_get_rotation(body) - mesh->rotation;
+    double cos_angle = cos(angle), sin_angle = sin(angle);
+    for (size_t j = 0; j < mesh->vertex_count; j++) {
+      vector_t v = mesh->vertices[j];
+      vector_t rotated = {.x = cos_angle * v.x - sin_angle * v.y,
+                          .y = sin_angle * v.x + cos_angle * v.y};
+      raster->points[j] = get_pixel(raster, vec_add(position, rotated));
+    }
+    fill_triangles(raster, mesh->triangle_count, body_get_color(body));
+  }
+}
+
+uint64_t raster_hash(raster_t *raster) {
+  uint64_t hash = FNV_OFFSET_BASIS;
+  size_t header[] = {raster->width, raster->height};
+  const uint8_t *bytes = (const uint8_t *)header;
+  for (size_t i = 0; i < sizeof(header); i++) {
+    hash = (hash ^ bytes[i]) * FNV_PRIME;
+  }
+  size_t size = raster->width * raster->height * BYTES_PER_PIXEL;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ raster->pixels[i]) * FNV_PRIME;
+  }
+  return hash;
+}
@@ -1,56 +1,198 @@
 #include "scene.h"
+#include "contact_solver.h"
 #include "forces.h"
+#include "jobs.h"
+#include "mem_stats.h"
+#include "ptr_map.h"
 #include <assert.h>
+#include <math.h>
 #include <stdlib.h>
 
+#ifdef SCENE_PROFILE
+#include "collision.h"
+#include "timing.h"
+
+// The number of recent ticks scene_get_stats() averages over
+#define STATS_WINDOW 60
+#endif
+
 const size_t init_body_num = 100;
+const size_t default_contact_iterations = 8;
 
 typedef struct force {
   force_creator_t force;
   void *aux;
+  // The number of bytes allocated for aux, or 0 if it is unknown
+  size_t aux_size;
   free_func_t freer;
   list_t *bodies;
+  // Set when one of the bodies has been removed, before the force is freed
+  bool removed;
 } force_t;
 
 typedef struct scene {
   list_t *body_array;
   list_t *forces;
+  force_batch_t *batches[FORCE_KINDS];
   size_t size;
   size_t capacity;
+  size_t tick_allocs;
+  size_t total_tick_allocs;
+  size_t ticks;
+  integrator_t integrator;
+  contact_solver_t *contact_solver;
+  collision_events_t *collision_events;
+  // Force fields, as parallel arrays so the loop over them vectorizes.
+  // Field i gives each body in field_layers[i] an acceleration of
+  // (field_ax[i], field_ay[i]) and a drag of -field_drag[i] * v.
+  double *field_ax;
+  double *field_ay;
+  double *field_drag;
+  layer_mask_t *field_layers;
+  size_t field_count;
+  size_t field_capacity;
+  // Per-body scratch space for integrators with several stages
+  vector_t *stages;
+  size_t stages_capacity;
+
+  // Runs each stage of the tick in parallel, or NULL to run it in order
+  job_pool_t *pool;
+  // The force creators grouped into levels that share no bodies.
+  // Level i is the forces schedule[level_starts[i]..level_starts[i + 1]).
+  bool schedule_dirty;
+  size_t *schedule;
+  size_t *force_levels;
+  size_t schedule_capacity;
+  size_t *level_starts;
+  size_t level_capacity;
+  size_t level_count;
+  // Maps each body to 1 + the level of the last force that uses it
+  ptr_map_t *body_levels;
+
+#ifdef SCENE_PROFILE
+  // The totals of the tick in progress, and of the last STATS_WINDOW
+  // ticks in a ring buffer, next to be overwritten at recent_next
+  scene_tick_stats_t tick_stats;
+  scene_tick_stats_t recent_stats[STATS_WINDOW];
+  size_t recent_count;
+  size_t recent_next;
+#endif
 } scene_t;
 
+typedef struct level_job {
+  scene_t *scene;
+  size_t *forces;
+} level_job_t;
+
+typedef struct tick_job {
+  scene_t *scene;
+  double dt;
+  // The RK4 stage being evaluated
+  size_t stage;
+} tick_job_t;
+
+void force_free(force_t *force) {
+  free_func_t aux_free = force->freer;
+  if (aux_free != NULL) {
+    aux_free(force->aux);
+  }
+  list_free(force->bodies);
+  mem_free(MEM_FORCE, force, sizeof(force_t));
+}
+
 scene_t *scene_init(void) {
-  scene_t *scene = malloc(sizeof(scene_t));
-  assert(scene != NULL);
+  scene_t *scene = mem_alloc(MEM_SCENE, sizeof(scene_t));
 
   scene->body_array = list_init(init_body_num, (free_func_t)body_free);
   assert(scene->body_array != NULL);
 
-  scene->forces = list_init(2, NULL);
+  scene->forces = list_init(2, (free_func_t)force_free);
   assert(scene->forces != NULL);
 
+  for (force_kind_t kind = 0; kind < FORCE_KINDS; kind++) {
+    scene->batches[kind] = force_batch_init(kind, 2);
+  }
+
   scene->size = 0;
   scene->capacity = init_body_num;
+  scene->tick_allocs = 0;
+  scene->total_tick_allocs = 0;
+  scene->ticks = 0;
+  scene->integrator = INTEGRATOR_DEFAULT;
+  scene->contact_solver = contact_solver_init(default_contact_iterations);
+  scene->collision_events = collision_events_init();
+  scene->field_ax = NULL;
+  scene->field_ay = NULL;
+  scene->field_drag = NULL;
+  scene->field_layers = NULL;
+  scene->field_count = 0;
+  scene->field_capacity = 0;
+  scene->stages = NULL;
+  scene->stages_capacity = 0;
+  scene->pool = NULL;
+  scene->schedule_dirty = true;
+  scene->schedule = NULL;
+  scene->force_levels = NULL;
+  scene->schedule_capacity = 0;
+  scene->level_starts = NULL;
+  scene->level_capacity = 0;
+  scene->level_count = 0;
+  scene->body_levels = ptr_map_init(MEM_SCENE, 0);
+#ifdef SCENE_PROFILE
+  scene->tick_stats = (scene_tick_stats_t){0};
+  scene->recent_count = 0;
+  scene->recent_next = 0;
+#endif
   return scene;
 }
 
-void scene_forces_free(scene_t *scene) {
-  for (size_t i = 0; i < list_size(scene->forces); i++) {
-    force_t *force = list_get(scene->forces, i);
-    free_func_t aux_free = force->freer;
-    if (aux_free != NULL) {
-      aux_free(force->aux);
-    }
-    list_free(force->bodies);
-    free(force);
-  }
+/**
+ * Reads the clock at the start of a profiled stage of the tick.
+ * Without SCENE_PROFILE, does nothing.
+ */
+double profile_start(void) {
+#ifdef SCENE_PROFILE
+  return timing_now();
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Adds the time since profile_start() to a stage of the current tick.
+ * Without SCENE_PROFILE, does nothing.
+ */
+void profile_stage(scene_t *scene, tick_stage_t stage, double start) {
+#ifdef SCENE_PROFILE
+  scene->tick_stats.stage_seconds[stage] += timing_now() - start;
+#endif
 }
 
 void scene_free(scene_t *scene) {
-  scene_forces_free(scene);
   list_free(scene->forces);
+  for (force_kind_t kind = 0; kind < FORCE_KINDS; kind++) {
+    force_batch_free(scene->batches[kind]);
+  }
   list_free(scene->body_array);
-  free(scene);
+  size_t fields = scene->field_capacity;
+  mem_free(MEM_SCENE, scene->field_ax, fields * sizeof(double));
+  mem_free(MEM_SCENE, scene->field_ay, fields * sizeof(double));
+  mem_free(MEM_SCENE, scene->field_drag, fields * sizeof(double));
+  mem_free(MEM_SCENE, scene->field_layers, fields * sizeof(layer_mask_t));
+  mem_free(MEM_SCENE, scene->stages, scene->stages_capacity * sizeof(vector_t));
+  contact_solver_free(scene->contact_solver);
+  collision_events_free(scene->collision_events);
+  if (scene->pool != NULL) {
+    job_pool_free(scene->pool);
+  }
+  mem_free(MEM_SCENE, scene->schedule,
+           scene->schedule_capacity * sizeof(size_t));
+  mem_free(MEM_SCENE, scene->force_levels,
+           scene->schedule_capacity * sizeof(size_t));
+  mem_free(MEM_SCENE, scene->level_starts,
+           scene->level_capacity * sizeof(size_t));
+  ptr_map_free(scene->body_levels);
+  mem_free(MEM_SCENE, scene, sizeof(scene_t));
 }
 
 size_t scene_bodies(scene_t *scene) { return list_size(scene->body_array); }
@@ -76,63 +218,666 @@ void scene_add_force_creator(scene_t *scene, force_creator_t forcer, void *aux,
 void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
                                     void *aux, list_t *bodies,
                                     free_func_t freer) {
-  force_t *force = malloc(sizeof(force_t));
+  scene_add_sized_force_creator(scene, forcer, aux, 0, bodies, freer);
+}
+
+void scene_add_sized_force_creator(scene_t *scene, force_creator_t forcer,
+                                   void *aux, size_t aux_size, list_t *bodies,
+                                   free_func_t freer) {
+  force_t *force = mem_alloc(MEM_FORCE, sizeof(force_t));
   force->bodies = bodies;
   force->aux = aux;
+  force->aux_size = aux_size;
   force->force = forcer;
   force->freer = freer;
+  force->removed = false;
   list_add(scene->forces, force);
+  scene->schedule_dirty = true;
+}
+
+void scene_add_batched_force(scene_t *scene, force_kind_t kind,
+                             double constant, body_t *body1, body_t *body2) {
+  force_batch_add(scene->batches[kind], constant, body1, body2);
+}
+
+force_batch_t *scene_get_force_batch(scene_t *scene, force_kind_t kind) {
+  return scene->batches[kind];
+}
+
+void add_field(scene_t *scene, vector_t acceleration, double drag,
+               layer_mask_t layers) {
+  if (scene->field_count == scene->field_capacity) {
+    size_t old = scene->field_capacity;
+    size_t capacity = old > 0 ? 2 * old : 4;
+    scene->field_ax = mem_realloc(MEM_SCENE, scene->field_ax,
+                                  old * sizeof(double),
+                                  capacity * sizeof(double));
+    scene->field_ay = mem_realloc(MEM_SCENE, scene->field_ay,
+                                  old * sizeof(double),
+                                  capacity * sizeof(double));
+    scene->field_drag = mem_realloc(MEM_SCENE, scene->field_drag,
+                                    old * sizeof(double),
+                                    capacity * sizeof(double));
+    scene->field_layers =
+        mem_realloc(MEM_SCENE, scene->field_layers, old * sizeof(layer_mask_t),
+                    capacity * sizeof(layer_mask_t));
+    scene->field_capacity = capacity;
+  }
+  size_t i = scene->field_count++;
+  scene->field_ax[i] = acceleration.x;
+  scene->field_ay[i] = acceleration.y;
+  scene->field_drag[i] = drag;
+  scene->field_layers[i] = layers;
+}
+
+void scene_add_uniform_field(scene_t *scene, vector_t acceleration,
+                             layer_mask_t layers) {
+  add_field(scene, acceleration, 0, layers);
+}
+
+void scene_add_global_drag(scene_t *scene, double gamma, layer_mask_t layers) {
+  add_field(scene, VEC_ZERO, gamma, layers);
+}
+
+size_t scene_fields(scene_t *scene) { return scene->field_count; }
+
+force_field_t scene_get_field(scene_t *scene, size_t index) {
+  assert(index < scene->field_count);
+  return (force_field_t){
+      .acceleration = {scene->field_ax[index], scene->field_ay[index]},
+      .drag = scene->field_drag[index],
+      .layers = scene->field_layers[index]};
+}
+
+size_t scene_forces(scene_t *scene) { return list_size(scene->forces); }
+
+force_creator_t scene_get_forcer(scene_t *scene, size_t index) {
+  force_t *force = list_get(scene->forces, index);
+  return force->force;
+}
+
+void *scene_get_force_aux(scene_t *scene, size_t index) {
+  force_t *force = list_get(scene->forces, index);
+  return force->aux;
+}
+
+list_t *scene_get_force_bodies(scene_t *scene, size_t index) {
+  force_t *force = list_get(scene->forces, index);
+  return force->bodies;
+}
+
+void scene_set_integrator(scene_t *scene, integrator_t integrator) {
+  assert(integrator < INTEGRATOR_KINDS);
+  scene->integrator = integrator;
+}
+
+integrator_t scene_get_integrator(scene_t *scene) { return scene->integrator; }
+
+collision_events_t *scene_get_collision_events(scene_t *scene) {
+  return scene->collision_events;
+}
+
+contact_solver_t *scene_get_contact_solver(scene_t *scene) {
+  return scene->contact_solver;
 }
 
-void apply_forces(scene_t *scene, double dt) {
-  for (size_t i = 0; i < list_size(scene->forces); i++) {
-    force_t *f = list_get(scene->forces, i);
-    force_creator_t forcer = f->force;
-    forcer(f->aux);
+void scene_set_threads(scene_t *scene, size_t threads) {
+  assert(threads > 0);
+  if (scene->pool != NULL) {
+    job_pool_free(scene->pool);
+    scene->pool = NULL;
   }
+  if (threads > 1) {
+    scene->pool = job_pool_init(threads);
+  }
+  contact_solver_set_job_pool(scene->contact_solver, scene->pool);
+}
 
-  for (size_t i = 0; i < scene_bodies(scene); i++) {
-    body_tick(scene_get_body(scene, i), dt);
+size_t scene_get_threads(scene_t *scene) {
+  return scene->pool == NULL ? 1 : job_pool_threads(scene->pool);
+}
+
+/**
+ * Grows a scratch array of indices owned by the scene to hold at least
+ * the given number of elements, discarding its contents.
+ */
+size_t *reserve_indices(size_t *array, size_t capacity, size_t needed) {
+  if (needed <= capacity) {
+    return array;
   }
+  mem_free(MEM_SCENE, array, capacity * sizeof(size_t));
+  return mem_alloc(MEM_SCENE, needed * sizeof(size_t));
 }
 
-void remove_forces(scene_t *scene) {
-  size_t count = 0;
-  while (count < list_size(scene->forces)) {
-    force_t *f = list_get(scene->forces, count);
-    list_t *body_col = f->bodies;
-    bool remove = false;
-    for (size_t i = 0; i < list_size(body_col); i++) {
-      remove = body_is_removed(list_get(body_col, i));
-      if (remove) {
-        free_func_t aux_free = f->freer;
-        if (aux_free != NULL) {
-          aux_free(f->aux);
-        }
-        list_free(f->bodies);
-        free(f);
-        list_remove(scene->forces, count);
-        break;
-      }
+/**
+ * Assigns each force creator to the earliest level after every earlier
+ * force creator that shares one of its bodies, so each body still sees its
+ * force creators in the order they were added.
+ * A force creator with no bodies may touch any body, so it gets a level
+ * to itself, after all earlier force creators and before all later ones.
+ */
+void build_schedule(scene_t *scene) {
+  size_t force_count = list_size(scene->forces);
+  if (force_count > scene->schedule_capacity) {
+    scene->schedule = reserve_indices(scene->schedule,
+                                      scene->schedule_capacity, force_count);
+    scene->force_levels = reserve_indices(
+        scene->force_levels, scene->schedule_capacity, force_count);
+    scene->schedule_capacity = force_count;
+  }
+
+  ptr_map_clear(scene->body_levels, scene_bodies(scene));
+  size_t level_count = 0;
+  size_t min_level = 0;
+  for (size_t i = 0; i < force_count; i++) {
+    list_t *bodies = ((force_t *)list_get(scene->forces, i))->bodies;
+    size_t level = min_level;
+    if (list_size(bodies) == 0) {
+      level = level_count;
+      min_level = level + 1;
+    }
+    for (size_t j = 0; j < list_size(bodies); j++) {
+      size_t after = ptr_map_get(scene->body_levels, list_get(bodies, j), 0);
+      level = after > level ? after : level;
+    }
+    for (size_t j = 0; j < list_size(bodies); j++) {
+      ptr_map_put(scene->body_levels, list_get(bodies, j), level + 1);
+    }
+    scene->force_levels[i] = level;
+    level_count = level + 1 > level_count ? level + 1 : level_count;
+  }
+
+  // Counting sort by level, keeping the forces in order within each level
+  if (level_count + 1 > scene->level_capacity) {
+    scene->level_starts = reserve_indices(
+        scene->level_starts, scene->level_capacity, level_count + 1);
+    scene->level_capacity = level_count + 1;
+  }
+  for (size_t i = 0; i <= level_count; i++) {
+    scene->level_starts[i] = 0;
+  }
+  for (size_t i = 0; i < force_count; i++) {
+    scene->level_starts[scene->force_levels[i] + 1]++;
+  }
+  for (size_t i = 0; i < level_count; i++) {
+    scene->level_starts[i + 1] += scene->level_starts[i];
+  }
+  for (size_t i = 0; i < force_count; i++) {
+    size_t *next = &scene->level_starts[scene->force_levels[i]];
+    scene->schedule[(*next)++] = i;
+  }
+  // Each start was advanced to the next level's start; shift them back
+  for (size_t i = level_count; i > 0; i--) {
+    scene->level_starts[i] = scene->level_starts[i - 1];
+  }
+  scene->level_starts[0] = 0;
+  scene->level_count = level_count;
+  scene->schedule_dirty = false;
+}
+
+/**
+ * Calls a function for each index up to count, on the scene's threads.
+ */
+void run_parallel(scene_t *scene, size_t count, job_func_t func, void *aux) {
+  if (scene->pool == NULL) {
+    for (size_t i = 0; i < count; i++) {
+      func(aux, i);
     }
-    if (!remove) {
-      count++;
+  } else {
+    job_pool_parallel_for(scene->pool, count, func, aux);
+  }
+}
+
+void run_scheduled_force(void *aux, size_t index) {
+  level_job_t *job = aux;
+  force_t *force = list_get(job->scene->forces, job->forces[index]);
+  force->force(force->aux);
+}
+
+/**
+ * Applies every force field to one body. The fields are summed with
+ * branch-free masking, so the loop over them vectorizes.
+ */
+void apply_fields(void *aux, size_t index) {
+  scene_t *scene = aux;
+  body_t *body = scene_get_body(scene, index);
+  layer_mask_t layers = body_get_layers(body);
+  double ax = 0;
+  double ay = 0;
+  double drag = 0;
+  for (size_t i = 0; i < scene->field_count; i++) {
+    double in_field = (scene->field_layers[i] & layers) != 0;
+    ax += in_field * scene->field_ax[i];
+    ay += in_field * scene->field_ay[i];
+    drag += in_field * scene->field_drag[i];
+  }
+  double mass = body_get_mass(body);
+  vector_t velocity = body_get_velocity(body);
+  vector_t force = {-drag * velocity.x, -drag * velocity.y};
+  if (mass != INFINITY) {
+    force.x += mass * ax;
+    force.y += mass * ay;
+  }
+  body_add_force(body, force);
+}
+
+void run_forces(scene_t *scene) {
+  if (scene->field_count > 0) {
+    run_parallel(scene, scene_bodies(scene), apply_fields, scene);
+  }
+  for (force_kind_t kind = 0; kind < FORCE_KINDS; kind++) {
+    force_batch_apply(scene->batches[kind]);
+  }
+
+  if (scene->pool == NULL) {
+    for (size_t i = 0; i < list_size(scene->forces); i++) {
+      force_t *f = list_get(scene->forces, i);
+      force_creator_t forcer = f->force;
+      forcer(f->aux);
     }
+    return;
   }
 
-  size_t cnt = 0;
-  while (cnt < scene_bodies(scene)) {
-    body_t *body = scene_get_body(scene, cnt);
-    if (body_is_removed(body)) {
-      body_free(body);
-      list_remove(scene->body_array, cnt);
+  if (scene->schedule_dirty) {
+    build_schedule(scene);
+  }
+  for (size_t level = 0; level < scene->level_count; level++) {
+    size_t start = scene->level_starts[level];
+    level_job_t job = {scene, &scene->schedule[start]};
+    run_parallel(scene, scene->level_starts[level + 1] - start,
+                 run_scheduled_force, &job);
+  }
+}
+
+void apply_forces(scene_t *scene) {
+  double start = profile_start();
+  run_forces(scene);
+  profile_stage(scene, TICK_FORCES, start);
+#ifdef SCENE_PROFILE
+  scene->tick_stats.force_creators += list_size(scene->forces);
+#endif
+}
+
+size_t scene_force_levels(scene_t *scene) {
+  if (scene->schedule_dirty) {
+    build_schedule(scene);
+  }
+  return scene->level_count;
+}
+
+/**
+ * Applies the forces, then resolves the physics collisions
+ * against the velocities those forces lead to.
+ * Contacts are solved and collision events are detected once per tick,
+ * even by integrators that evaluate the forces several times.
+ */
+void apply_forces_and_contacts(scene_t *scene, double dt) {
+  double start = profile_start();
+  collision_events_detect(scene->collision_events, scene->pool);
+  profile_stage(scene, TICK_DETECT, start);
+  apply_forces(scene);
+  start = profile_start();
+  contact_solver_solve(scene->contact_solver,
+                       scene->batches[FORCE_PHYSICS_COLLISION], dt);
+  profile_stage(scene, TICK_CONTACTS, start);
+}
+
+/**
+ * Gets the acceleration from the forces on a body
+ * and resets them for the next force evaluation.
+ * Impulses are kept until the end of the tick.
+ */
+vector_t take_acceleration(body_t *body) {
+  vector_t acceleration =
+      vec_multiply(1.0 / body_get_mass(body), body_get_force(body));
+  body_set_force(body, VEC_ZERO);
+  return acceleration;
+}
+
+/**
+ * Gets a body's final velocity after adding its accumulated impulses.
+ */
+vector_t final_velocity(body_t *body, vector_t velocity) {
+  vector_t dv_i = vec_multiply(1.0 / body_get_mass(body), body_get_impulse(body));
+  return body_clamp_velocity(body, vec_add(velocity, dv_i));
+}
+
+void default_step(void *aux, size_t i) {
+  tick_job_t *job = aux;
+  body_tick(scene_get_body(job->scene, i), job->dt);
+}
+
+void integrate_default(scene_t *scene, double dt) {
+  tick_job_t job = {.scene = scene, .dt = dt};
+  apply_forces_and_contacts(scene, dt);
+  run_parallel(scene, scene_bodies(scene), default_step, &job);
+}
+
+void symplectic_euler_step(void *aux, size_t i) {
+  tick_job_t *job = aux;
+  body_t *body = scene_get_body(job->scene, i);
+  vector_t dv = vec_multiply(job->dt, take_acceleration(body));
+  vector_t velocity =
+      final_velocity(body, vec_add(body_get_velocity(body), dv));
+  vector_t centroid =
+      vec_add(body_get_centroid(body), vec_multiply(job->dt, velocity));
+  body_end_tick(body, centroid, velocity, job->dt);
+}
+
+void integrate_symplectic_euler(scene_t *scene, double dt) {
+  tick_job_t job = {.scene = scene, .dt = dt};
+  apply_forces_and_contacts(scene, dt);
+  run_parallel(scene, scene_bodies(scene), symplectic_euler_step, &job);
+}
+
+void verlet_kick_drift(void *aux, size_t i) {
+  tick_job_t *job = aux;
+  body_t *body = scene_get_body(job->scene, i);
+  vector_t half_dv = vec_multiply(job->dt / 2, take_acceleration(body));
+  vector_t velocity = vec_add(body_get_velocity(body), half_dv);
+  body_set_velocity(body, velocity);
+  body_set_centroid(body, vec_add(body_get_centroid(body),
+                                  vec_multiply(job->dt, velocity)));
+}
+
+void verlet_kick(void *aux, size_t i) {
+  tick_job_t *job = aux;
+  body_t *body = scene_get_body(job->scene, i);
+  vector_t half_dv = vec_multiply(job->dt / 2, take_acceleration(body));
+  vector_t velocity =
+      final_velocity(body, vec_add(body_get_velocity(body), half_dv));
+  body_end_tick(body, body_get_centroid(body), velocity, job->dt);
+}
+
+void integrate_velocity_verlet(scene_t *scene, double dt) {
+  size_t count = scene_bodies(scene);
+  tick_job_t job = {.scene = scene, .dt = dt};
+  apply_forces_and_contacts(scene, dt);
+  run_parallel(scene, count, verlet_kick_drift, &job);
+  apply_forces(scene);
+  run_parallel(scene, count, verlet_kick, &job);
+}
+
+// Each body stores its initial centroid and velocity,
+// followed by the weighted sums of the stages' derivatives
+const size_t RK4_STAGE_VECTORS = 4;
+
+void rk4_begin(void *aux, size_t i) {
+  tick_job_t *job = aux;
+  body_t *body = scene_get_body(job->scene, i);
+  vector_t *stage = &job->scene->stages[RK4_STAGE_VECTORS * i];
+  stage[0] = body_get_centroid(body);
+  stage[1] = body_get_velocity(body);
+  stage[2] = VEC_ZERO;
+  stage[3] = VEC_ZERO;
+}
+
+void rk4_stage(void *aux, size_t i) {
+  // Stage k evaluates the derivatives at the initial state
+  // plus offsets[k] * dt times the previous stage's derivatives
+  const double offsets[] = {0.5, 0.5, 1.0};
+  const double weights[] = {1.0, 2.0, 2.0, 1.0};
+  tick_job_t *job = aux;
+  size_t k = job->stage;
+  body_t *body = scene_get_body(job->scene, i);
+  vector_t *stage = &job->scene->stages[RK4_STAGE_VECTORS * i];
+  vector_t velocity = body_get_velocity(body);
+  vector_t acceleration = take_acceleration(body);
+  stage[2] = vec_add(stage[2], vec_multiply(weights[k], velocity));
+  stage[3] = vec_add(stage[3], vec_multiply(weights[k], acceleration));
+  if (k < 3) {
+    double step = offsets[k] * job->dt;
+    body_set_centroid(body, vec_add(stage[0], vec_multiply(step, velocity)));
+    body_set_velocity(body,
+                      vec_add(stage[1], vec_multiply(step, acceleration)));
+  }
+}
+
+void rk4_finish(void *aux, size_t i) {
+  tick_job_t *job = aux;
+  body_t *body = scene_get_body(job->scene, i);
+  vector_t *stage = &job->scene->stages[RK4_STAGE_VECTORS * i];
+  vector_t centroid = vec_add(stage[0], vec_multiply(job->dt / 6, stage[2]));
+  vector_t velocity = final_velocity(
+      body, vec_add(stage[1], vec_multiply(job->dt / 6, stage[3])));
+  body_end_tick(body, centroid, velocity, job->dt);
+}
+
+void integrate_rk4(scene_t *scene, double dt) {
+  size_t count = scene_bodies(scene);
+  size_t needed = RK4_STAGE_VECTORS * count;
+  if (needed > scene->stages_capacity) {
+    scene->stages = mem_realloc(MEM_SCENE, scene->stages,
+                                scene->stages_capacity * sizeof(vector_t),
+                                needed * sizeof(vector_t));
+    scene->stages_capacity = needed;
+  }
+  tick_job_t job = {.scene = scene, .dt = dt};
+  run_parallel(scene, count, rk4_begin, &job);
+  for (job.stage = 0; job.stage < 4; job.stage++) {
+    if (job.stage == 0) {
+      apply_forces_and_contacts(scene, dt);
     } else {
-      cnt++;
+      apply_forces(scene);
     }
+    run_parallel(scene, count, rk4_stage, &job);
   }
+  run_parallel(scene, count, rk4_finish, &job);
 }
 
+void mark_removed_force(void *aux, size_t index) {
+  scene_t *scene = aux;
+  force_t *force = list_get(scene->forces, index);
+  list_t *body_col = force->bodies;
+  for (size_t i = 0; i < list_size(body_col); i++) {
+    if (body_is_removed(list_get(body_col, i))) {
+      force->removed = true;
+      return;
+    }
+  }
+}
+
+bool force_is_removed(force_t *force, void *aux) { return force->removed; }
+
+bool body_should_free(body_t *body, void *aux) {
+  return body_is_removed(body);
+}
+
+typedef struct batch_job {
+  scene_t *scene;
+  force_kind_t kind;
+} batch_job_t;
+
+void remove_dead_batched(void *aux) {
+  batch_job_t *job = aux;
+  force_batch_remove_dead(job->scene->batches[job->kind]);
+}
+
+void remove_forces(scene_t *scene) {
+  // The batches are compacted in parallel with each other
+  // and with finding the removed force creators
+  batch_job_t batch_jobs[FORCE_KINDS];
+  job_join_t join;
+  if (scene->pool != NULL) {
+    job_join_init(&join);
+    for (force_kind_t kind = 0; kind < FORCE_KINDS; kind++) {
+      batch_jobs[kind] = (batch_job_t){scene, kind};
+      job_pool_spawn(scene->pool, &join, remove_dead_batched,
+                     &batch_jobs[kind]);
+    }
+  } else {
+    for (force_kind_t kind = 0; kind < FORCE_KINDS; kind++) {
+      force_batch_remove_dead(scene->batches[kind]);
+    }
+  }
+  run_parallel(scene, list_size(scene->forces), mark_removed_force, scene);
+  if (scene->pool != NULL) {
+    job_pool_join(scene->pool, &join);
+  }
+
+  // Freeing runs in order, since freers may touch any state.
+  // Forces go first, since they still need to read their (removed) bodies.
+  if (list_erase_if(scene->forces, (list_pred_t)force_is_removed, NULL) > 0) {
+    scene->schedule_dirty = true;
+  }
+  collision_events_remove_dead(scene->collision_events);
+  list_erase_if(scene->body_array, (list_pred_t)body_should_free, NULL);
+}
+
+#ifdef SCENE_PROFILE
+/**
+ * Finishes the current tick's stats and adds them to the recent ticks.
+ */
+void record_tick_stats(scene_t *scene, double tick_seconds,
+                       double integrate_seconds, size_t tests,
+                       size_t collisions, size_t bodies, size_t removed) {
+  scene_tick_stats_t *stats = &scene->tick_stats;
+  stats->ticks = 1;
+  stats->tick_seconds = tick_seconds;
+  // Integrators evaluate forces between their steps, so that time
+  // is taken out of the integration stage
+  stats->stage_seconds[TICK_INTEGRATE] =
+      integrate_seconds - stats->stage_seconds[TICK_DETECT] -
+      stats->stage_seconds[TICK_FORCES] - stats->stage_seconds[TICK_CONTACTS];
+  stats->collision_tests = collision_tests() - tests;
+  stats->collisions = collision_hits() - collisions;
+  stats->bodies_integrated = bodies;
+  stats->bodies_removed = removed;
+  scene->recent_stats[scene->recent_next] = *stats;
+  scene->recent_next = (scene->recent_next + 1) % STATS_WINDOW;
+  if (scene->recent_count < STATS_WINDOW) {
+    scene->recent_count++;
+  }
+  *stats = (scene_tick_stats_t){0};
+}
+#endif
+
 void scene_tick(scene_t *scene, double dt) {
-  apply_forces(scene, dt);
+  // Only counts this scene's allocations, including those on its workers
+  atomic_size_t allocs;
+  atomic_init(&allocs, 0);
+  atomic_size_t *outer_allocs = mem_count_calls(&allocs);
+#ifdef SCENE_PROFILE
+  double tick_start = timing_now();
+  size_t tests = collision_tests();
+  size_t collisions = collision_hits();
+  size_t bodies = scene_bodies(scene);
+#endif
+  switch (scene->integrator) {
+  case INTEGRATOR_DEFAULT:
+    integrate_default(scene, dt);
+    break;
+  case INTEGRATOR_SYMPLECTIC_EULER:
+    integrate_symplectic_euler(scene, dt);
+    break;
+  case INTEGRATOR_VELOCITY_VERLET:
+    integrate_velocity_verlet(scene, dt);
+    break;
+  case INTEGRATOR_RK4:
+    integrate_rk4(scene, dt);
+    break;
+  default:
+    assert(false);
+  }
+#ifdef SCENE_PROFILE
+  double integrate_seconds = timing_now() - tick_start;
+#endif
+  // Game logic runs once the bodies have moved, before removed bodies
+  // are freed, so handlers can still remove bodies this tick
+  double start = profile_start();
+  collision_events_dispatch(scene->collision_events);
+  profile_stage(scene, TICK_HANDLERS, start);
+#ifdef SCENE_PROFILE
+  size_t before_removal = scene_bodies(scene);
+#endif
+  start = profile_start();
   remove_forces(scene);
-}
\ No newline at end of file
+  profile_stage(scene, TICK_REMOVE, start);
+#ifdef SCENE_PROFILE
+  record_tick_stats(scene, timing_now() - tick_start, integrate_seconds,
+                    tests, collisions, bodies,
+                    before_removal - scene_bodies(scene));
+#endif
+  mem_count_calls(outer_allocs);
+  scene->tick_allocs = atomic_load(&allocs);
+  scene->total_tick_allocs += scene->tick_allocs;
+  scene->ticks++;
+}
+
+scene_memory_stats_t scene_memory_stats(scene_t *scene) {
+  scene_memory_stats_t stats = {0};
+  stats.body_count = scene_bodies(scene);
+  stats.body_bytes = list_memory_size(scene->body_array);
+  for (size_t i = 0; i < stats.body_count; i++) {
+    body_t *body = scene_get_body(scene, i);
+    stats.body_bytes += body_memory_size(body);
+    stats.vertex_count += body_num_vertices(body);
+  }
+  stats.vertex_bytes = stats.vertex_count * sizeof(vector_t);
+
+  stats.force_count = list_size(scene->forces);
+  stats.force_bytes = list_memory_size(scene->forces);
+  for (size_t i = 0; i < stats.force_count; i++) {
+    force_t *force = list_get(scene->forces, i);
+    stats.force_bytes += sizeof(force_t) + list_memory_size(force->bodies);
+    if (force->aux != NULL) {
+      stats.aux_count++;
+      stats.aux_bytes += force->aux_size;
+    }
+  }
+  for (force_kind_t kind = 0; kind < FORCE_KINDS; kind++) {
+    stats.force_count += force_batch_size(scene->batches[kind]);
+    stats.force_bytes += force_batch_memory_size(scene->batches[kind]);
+  }
+  stats.force_count += scene->field_count;
+  collision_events_t *events = scene->collision_events;
+  for (size_t i = 0; i < collision_events_pairs(events); i++) {
+    collision_pair_t *pair = collision_events_get_pair(events, i);
+    if (pair->aux != NULL) {
+      stats.aux_count++;
+      stats.aux_bytes += pair->aux_size;
+    }
+  }
+  stats.force_count += collision_events_pairs(scene->collision_events);
+  stats.force_bytes += collision_events_memory_size(scene->collision_events);
+  stats.force_bytes +=
+      scene->field_capacity * (3 * sizeof(double) + sizeof(layer_mask_t));
+
+  stats.tick_allocs = scene->tick_allocs;
+  stats.total_tick_allocs = scene->total_tick_allocs;
+  stats.ticks = scene->ticks;
+  return stats;
+}
+
+scene_tick_stats_t scene_get_stats(scene_t *scene) {
+  scene_tick_stats_t average = {0};
+#ifdef SCENE_PROFILE
+  size_t count = scene->recent_count;
+  if (count == 0) {
+    return average;
+  }
+  for (size_t i = 0; i < count; i++) {
+    scene_tick_stats_t *stats = &scene->recent_stats[i];
+    for (tick_stage_t stage = 0; stage < TICK_STAGES; stage++) {
+      average.stage_seconds[stage] += stats->stage_seconds[stage];
+    }
+    average.tick_seconds += stats->tick_seconds;
+    average.force_creators += stats->force_creators;
+    average.collision_tests += stats->collision_tests;
+    average.collisions += stats->collisions;
+    average.bodies_integrated += stats->bodies_integrated;
+    average.bodies_removed += stats->bodies_removed;
+  }
+  for (tick_stage_t stage = 0; stage < TICK_STAGES; stage++) {
+    average.stage_seconds[stage] /= count;
+  }
+  average.tick_seconds /= count;
+  average.force_creators /= count;
+  average.collision_tests /= count;
+  average.collisions /= count;
+  average.bodies_integrated /= count;
+  average.bodies_removed /= count;
+  average.ticks = count;
+#endif
+  return average;
+}
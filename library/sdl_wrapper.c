@@ -1,6 +1,10 @@
 #include "sdl_wrapper.h"
+#include "assets.h"
+#include "input.h"
+#include "polygon.h"
+#include "snapshot.h"
+#include "voice_pool.h"
 #include <SDL2/SDL.h>
-#include <SDL2/SDL2_gfxPrimitives.h>
 #include <SDL2/SDL_gamecontroller.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_joystick.h>
@@ -9,8 +13,9 @@
 #include <assert.h>
 #include <math.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdlib.h>
-#include <time.h>
+#include <string.h>
 
 const char WINDOW_TITLE[] = "CS 3";
 const int WINDOW_WIDTH = 1000;
@@ -20,10 +25,30 @@ const double MS_PER_S = 1e3;
 // TTF Setup constants
 SDL_Texture *text_Texture;
 SDL_Rect text_rect;
-SDL_Surface *text_surface;
-TTF_Font *FONT;
 const SDL_Color TEXT_COLOR = {255, 0, 0, 255};
 
+/**
+ * A string rendered with the font, uploaded once and kept for reuse.
+ */
+typedef struct text_entry {
+  // A copy of the string, or NULL if the entry is unused
+  char *text;
+  SDL_Texture *texture;
+  int width;
+  int height;
+  // The value of text_clock when the entry was last drawn
+  size_t last_used;
+} text_entry_t;
+
+/**
+ * The textures of the most recently drawn strings, so text that stays
+ * the same between frames (like the score) is only rasterized once.
+ * When every entry is in use, the least recently drawn one is replaced.
+ */
+const size_t TEXT_CACHE_SIZE = 16;
+text_entry_t *text_cache = NULL;
+size_t text_clock = 0;
+
 // Gamecontroller setup constants
 int controller_count = 0;
 
@@ -63,33 +88,139 @@ uint32_t key_start_timestamp;
 uint32_t button_start_timestamp;
 
 /**
- * The value of clock() when time_since_last_tick() was last called.
- * Initially 0.
+ * The input events polled in a frame, before they are handled.
+ * Created by sdl_init().
+ */
+const size_t INPUT_CAPACITY = 256;
+input_buffer_t *input_events = NULL;
+
+/**
+ * The value of timing_now() when time_since_last_tick() was last called,
+ * or a negative number if it has not been called.
+ */
+double last_tick_time = -1;
+
+/**
+ * The durations of each frame_stage_t in the most recent frames.
+ * Created by sdl_init().
+ */
+const size_t TIMING_WINDOW = 600;
+timing_histogram_t *stage_times[FRAME_STAGES];
+const char *STAGE_NAMES[] = {"frame", "update", "render"};
+
+/**
+ * Loads the background image, font and sounds on a thread of its own,
+ * so the first frame does not wait for them. Created by sdl_init().
+ */
+asset_manager_t *assets = NULL;
+/**
+ * The assets that are drawn, read by whichever thread draws.
+ * NULL until requested.
+ */
+asset_t *_Atomic background_asset = NULL;
+asset_t *_Atomic font_asset = NULL;
+
+// The game's sound effects
+typedef enum { PADDLE_SOUND, POWERUP_SOUND, WALL_SOUND, SOUNDS } sound_t;
+
+// Sound handles, NULL until init_audio() requests them
+asset_t *sound_assets[SOUNDS] = {NULL};
+asset_t *bg_music = NULL;
+
+/**
+ * The sound effects requested this frame, and the mixer channels
+ * ("voices") they play on. The play_*_audio() functions only queue
+ * their sounds; flush_sounds() starts them once per frame.
+ */
+const size_t VOICES = 8;
+const size_t VOICES_PER_SOUND = 2;
+voice_pool_t *voices = NULL;
+// Whether play_bg() has been called, and whether the music has started
+bool music_requested = false;
+bool music_playing = false;
+
+/**
+ * The triangles of the polygons drawn since the last flush.
+ * sdl_draw_polygon() only appends to these buffers; flush_polygons()
+ * submits them all to the renderer in a single SDL_RenderGeometry() call.
+ */
+SDL_Vertex *batch_vertices = NULL;
+size_t batch_vertex_count = 0;
+size_t batch_vertex_capacity = 0;
+int *batch_indices = NULL;
+size_t batch_index_count = 0;
+size_t batch_index_capacity = 0;
+// Holds the triangles of the polygon being drawn,
+// and the scratch space polygon_triangulate() needs to find them
+size_t *triangle_indices = NULL;
+size_t triangle_capacity = 0;
+size_t *triangle_scratch = NULL;
+size_t scratch_capacity = 0;
+
+/**
+ * The background image and static bodies (see body_set_static()),
+ * drawn once into a texture that each frame copies instead of redrawing
+ * them. static_bodies records the bodies and versions that were drawn,
+ * so the layer is redrawn only when one of them changes or goes away.
+ */
+typedef struct static_body {
+  const body_t *body;
+  uint64_t version;
+} static_body_t;
+
+SDL_Texture *static_layer = NULL;
+int static_layer_width = 0;
+int static_layer_height = 0;
+// The background image drawn in static_layer
+SDL_Surface *static_layer_img = NULL;
+static_body_t *static_bodies = NULL;
+size_t static_body_count = 0;
+size_t static_body_capacity = 0;
+
+/**
+ * The scenes passed to sdl_render_scene(), as snapshots that can be drawn
+ * without touching the scene. Created on first use.
  */
-clock_t last_clock = 0;
+snapshot_buffer_t *snapshots = NULL;
 
-// Game music constants
-Mix_Music *bg_music = NULL;
-Mix_Chunk *powerup_hit = NULL;
-Mix_Chunk *paddle_hit = NULL;
-Mix_Chunk *wall_hit = NULL;
+#ifndef __EMSCRIPTEN__
+/**
+ * The thread that runs the game's frames, if sdl_start_simulation_thread()
+ * has been called. It owns the scene and publishes the snapshots the
+ * main thread draws; the main thread keeps the window and renderer.
+ */
+pthread_t simulation_thread;
+atomic_bool simulation_running = false;
+atomic_bool simulation_stopping = false;
+sdl_step_t simulation_step = NULL;
+void *simulation_aux = NULL;
+// The shortest time between the starts of two steps of the simulation,
+// which has no vsync to wait for
+const double MIN_STEP_TIME = 1.0 / 240;
+// Guards input_events, which both threads use while the simulation runs
+pthread_mutex_t input_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/**
+ * The sequence number of the last snapshot sdl_show_latest() drew,
+ * if has_shown is set.
+ */
+size_t shown_sequence = 0;
+bool has_shown = false;
 
 // Game image constants
-SDL_Surface *bg_img = NULL;
 SDL_Texture *tex = NULL;
+// The background image that tex was made from
+SDL_Surface *tex_img = NULL;
 SDL_Rect pic_rec;
 const int IMG_W = 1000;
 const int IMG_H = 500;
 
 /** Computes the center of the window in pixel coordinates */
 vector_t get_window_center(void) {
-  int *width = malloc(sizeof(*width)), *height = malloc(sizeof(*height));
-  assert(width != NULL);
-  assert(height != NULL);
-  SDL_GetWindowSize(window, width, height);
-  vector_t dimensions = {.x = *width, .y = *height};
-  free(width);
-  free(height);
+  int width, height;
+  SDL_GetWindowSize(window, &width, &height);
+  vector_t dimensions = {.x = width, .y = height};
   return vec_multiply(0.5, dimensions);
 }
 
@@ -229,7 +360,36 @@ void sdl_init(vector_t min, vector_t max) {
   window = SDL_CreateWindow(WINDOW_TITLE, SDL_WINDOWPOS_CENTERED,
                             SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH, WINDOW_HEIGHT,
                             SDL_WINDOW_RESIZABLE);
-  renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC);
+  renderer = SDL_CreateRenderer(
+      window, -1, SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE);
+  for (frame_stage_t stage = 0; stage < FRAME_STAGES; stage++) {
+    stage_times[stage] = timing_histogram_init(TIMING_WINDOW);
+  }
+  assets = asset_manager_init(true);
+  input_events = input_buffer_init(INPUT_CAPACITY);
+}
+
+/**
+ * Checks whether the game's frames run on the simulation thread.
+ */
+bool simulation_is_running(void) {
+#ifdef __EMSCRIPTEN__
+  return false;
+#else
+  return atomic_load(&simulation_running);
+#endif
+}
+
+void lock_input(void) {
+#ifndef __EMSCRIPTEN__
+  pthread_mutex_lock(&input_lock);
+#endif
+}
+
+void unlock_input(void) {
+#ifndef __EMSCRIPTEN__
+  pthread_mutex_unlock(&input_lock);
+#endif
 }
 
 void add_controller(int device_id) {
@@ -240,17 +400,164 @@ void add_controller(int device_id) {
   }
 }
 
+/**
+ * Translates an SDL key, button or axis event into an input event.
+ * Returns false if it is not one, or its key is not recognized.
+ */
+bool translate_event(const SDL_Event *event, input_event_t *input) {
+  switch (event->type) {
+  case SDL_KEYDOWN:
+  case SDL_KEYUP: {
+    char key = get_keycode(event->key.keysym.sym);
+    if (key == '\0') {
+      return false;
+    }
+    uint32_t timestamp = event->key.timestamp;
+    if (!event->key.repeat) {
+      key_start_timestamp = timestamp;
+    }
+    *input = (input_event_t){
+        .kind = INPUT_KEY,
+        .timestamp = timestamp,
+        .key = key,
+        .which = 0,
+        .pressed = event->type == SDL_KEYDOWN,
+        .value = 0,
+        .held_time = (timestamp - key_start_timestamp) / MS_PER_S};
+    return true;
+  }
+  case SDL_CONTROLLERBUTTONDOWN:
+  case SDL_CONTROLLERBUTTONUP: {
+    char button_key = get_controllerkey(event->cbutton.button);
+    if (button_key == '\0') {
+      return false;
+    }
+    uint32_t timestamp = event->cbutton.timestamp;
+    if (event->cbutton.state) {
+      button_start_timestamp = timestamp;
+    }
+    *input = (input_event_t){
+        .kind = INPUT_BUTTON,
+        .timestamp = timestamp,
+        .key = button_key,
+        .which = event->cbutton.which,
+        .pressed = event->type == SDL_CONTROLLERBUTTONDOWN,
+        .value = 0,
+        .held_time = (timestamp - button_start_timestamp) / MS_PER_S};
+    return true;
+  }
+  case SDL_CONTROLLERAXISMOTION: {
+    char axis_key = get_axiskey(event->caxis.axis);
+    if (axis_key == '\0') {
+      return false;
+    }
+    uint32_t timestamp = event->caxis.timestamp;
+    *input = (input_event_t){.kind = INPUT_AXIS,
+                             .timestamp = timestamp,
+                             .key = axis_key,
+                             .which = event->caxis.which,
+                             .pressed = event->caxis.value != 0,
+                             .value = event->caxis.value,
+                             .held_time = timestamp / MS_PER_S};
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+/**
+ * Passes an input event to the handler registered for its kind, if any.
+ */
+void dispatch_input(const input_event_t *event, void *scene_tup) {
+  switch (event->kind) {
+  case INPUT_KEY:
+    if (key_handler != NULL) {
+      key_handler(event->key, event->pressed ? KEY_PRESSED : KEY_RELEASED,
+                  event->held_time, scene_tup);
+    }
+    break;
+  case INPUT_BUTTON:
+    if (controller_handler != NULL) {
+      controller_handler(event->key,
+                         event->pressed ? BUTTON_PRESSED : BUTTON_RELEASED,
+                         event->held_time, event->which, scene_tup);
+    }
+    break;
+  case INPUT_AXIS:
+    if (axis_handler != NULL) {
+      axis_handler(event->key, event->pressed ? AXIS_PRESSED : AXIS_RELEASED,
+                   event->value, event->which, event->held_time, scene_tup);
+    }
+    break;
+  }
+}
+
+/**
+ * Does any loading work due on the main thread and starts the music
+ * once it has loaded, if it was requested.
+ */
+void update_assets(void) {
+  asset_manager_poll(assets);
+  if (music_requested && !music_playing && bg_music != NULL) {
+    Mix_Music *music = asset_get(bg_music);
+    if (music != NULL) {
+      Mix_PlayMusic(music, -1);
+      music_playing = true;
+    }
+  }
+}
+
+/**
+ * Handles the renderer losing the contents of its target textures,
+ * or all of its textures when the device is reset, so they are redrawn
+ * or recreated when next needed.
+ */
+void reset_textures(bool device_lost) {
+  SDL_DestroyTexture(static_layer);
+  static_layer = NULL;
+  if (!device_lost) {
+    return;
+  }
+  SDL_DestroyTexture(tex);
+  tex = NULL;
+  tex_img = NULL;
+  if (text_cache != NULL) {
+    for (size_t i = 0; i < TEXT_CACHE_SIZE; i++) {
+      SDL_DestroyTexture(text_cache[i].texture);
+      free(text_cache[i].text);
+      text_cache[i] = (text_entry_t){0};
+    }
+  }
+  text_Texture = NULL;
+}
+
+void sdl_handle_input(void *scene_tup) {
+  // Handle the frame's input in one pass, after coalescing axis motion.
+  // The lock is not held by handlers, so polling never waits for them.
+  while (true) {
+    input_event_t input;
+    lock_input();
+    bool found = input_buffer_pop(input_events, &input);
+    unlock_input();
+    if (!found) {
+      break;
+    }
+    dispatch_input(&input, scene_tup);
+  }
+}
+
 bool sdl_is_done(void *scene_tup) {
-  SDL_Event *event = malloc(sizeof(*event));
-  assert(event != NULL);
-  while (SDL_PollEvent(event)) {
-    switch (event->type) {
+  update_assets();
+  SDL_Event event;
+  while (SDL_PollEvent(&event)) {
+    input_event_t input;
+    switch (event.type) {
     case SDL_QUIT:
-      free(event);
       return true;
     case SDL_CONTROLLERDEVICEADDED:
       controller_count++;
-      int index = event->cdevice.which;
+      int index = event.cdevice.which;
       add_controller(index);
       break;
     case SDL_CONTROLLERDEVICEREMOVED:
@@ -258,101 +565,167 @@ bool sdl_is_done(void *scene_tup) {
         controller_count--;
       }
       SDL_GameControllerClose(
-          SDL_GameControllerFromInstanceID(event->cdevice.which));
+          SDL_GameControllerFromInstanceID(event.cdevice.which));
       printf("DEVICE REMOVED\n");
       break;
-    case SDL_CONTROLLERAXISMOTION: {
-      char axis_key = get_axiskey(event->caxis.axis);
-      if (axis_key == '\0') {
-        break;
-      }
-      double held_time = SDL_GetTicks() / MS_PER_S;
-      int value = event->caxis.value;
-      axis_event_type_t type = event->caxis.type;
-      int which = event->caxis.which;
-      axis_handler(axis_key, type, value, which, held_time, scene_tup);
+    case SDL_RENDER_TARGETS_RESET:
+      reset_textures(false);
       break;
-    }
-    case SDL_KEYDOWN:
-    case SDL_KEYUP: {
-      // Skip the keypress if no handler is configured
-      // or an unrecognized key was pressed
-      if (key_handler == NULL)
-        break;
-      char key = get_keycode(event->key.keysym.sym);
-      if (key == '\0')
-        break;
-
-      uint32_t timestamp = event->key.timestamp;
-      if (!event->key.repeat) {
-        key_start_timestamp = timestamp;
-      }
-      key_event_type_t type =
-          event->type == SDL_KEYDOWN ? KEY_PRESSED : KEY_RELEASED;
-      double held_time = (timestamp - key_start_timestamp) / MS_PER_S;
-      key_handler(key, type, held_time, scene_tup);
+    case SDL_RENDER_DEVICE_RESET:
+      reset_textures(true);
       break;
-    }
-    case SDL_CONTROLLERBUTTONDOWN:
-    case SDL_CONTROLLERBUTTONUP:
-      if (controller_handler == NULL)
-        break;
-      char button_key = get_controllerkey(event->cbutton.button);
-      if (button_key == '\0') {
-        break;
+    default:
+      if (translate_event(&event, &input)) {
+        lock_input();
+        input_buffer_push(input_events, input);
+        unlock_input();
       }
-      uint32_t timestamp = event->cbutton.timestamp;
-      if (event->cbutton.state) {
-        button_start_timestamp = timestamp;
-      }
-      double held_time = (timestamp - button_start_timestamp) / MS_PER_S;
-      button_event_type_t type = event->type == SDL_CONTROLLERBUTTONDOWN
-                                     ? BUTTON_PRESSED
-                                     : BUTTON_RELEASED;
-      controller_handler(button_key, type, held_time, event->cbutton.which,
-                         scene_tup);
       break;
     }
   }
-  free(event);
+  // The simulation thread handles its own input, since it owns the scene
+  if (!simulation_is_running()) {
+    sdl_handle_input(scene_tup);
+  }
   return false;
 }
 
-void sdl_clear(void) {
+/**
+ * Grows a batch buffer so it can hold the given number of elements.
+ * The capacity doubles so appending stays amortized constant time.
+ */
+void *reserve_batch(void *buffer, size_t *capacity, size_t needed,
+                    size_t element_size) {
+  if (needed <= *capacity) {
+    return buffer;
+  }
+  size_t new_capacity = *capacity > 0 ? *capacity : 64;
+  while (new_capacity < needed) {
+    new_capacity *= 2;
+  }
+  buffer = realloc(buffer, new_capacity * element_size);
+  assert(buffer != NULL);
+  *capacity = new_capacity;
+  return buffer;
+}
+
+/**
+ * Draws the batched polygons, so anything drawn afterwards goes on top.
+ */
+void flush_polygons(void) {
+  if (batch_index_count > 0) {
+    SDL_RenderGeometry(renderer, NULL, batch_vertices, batch_vertex_count,
+                       batch_indices, batch_index_count);
+  }
+  batch_vertex_count = 0;
+  batch_index_count = 0;
+}
+
+/**
+ * Clears the current render target to the background color.
+ */
+void clear_target(void) {
+  // Polygons drawn before clearing would be erased anyway
+  batch_vertex_count = 0;
+  batch_index_count = 0;
   SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
   SDL_RenderClear(renderer);
 }
 
+void sdl_clear(void) {
+  // The simulation thread must not touch the renderer, and
+  // sdl_show_latest() clears each frame itself
+  if (simulation_is_running()) {
+    return;
+  }
+  clear_target();
+}
+
+/**
+ * Makes room in the batch for a polygon's vertices and triangles.
+ */
+void reserve_geometry(size_t vertices, size_t triangles) {
+  batch_vertices =
+      reserve_batch(batch_vertices, &batch_vertex_capacity,
+                    batch_vertex_count + vertices, sizeof(SDL_Vertex));
+  batch_indices = reserve_batch(batch_indices, &batch_index_capacity,
+                                batch_index_count + 3 * triangles, sizeof(int));
+}
+
+SDL_Color get_vertex_color(rgb_color_t color) {
+  assert(0 <= color.r && color.r <= 1);
+  assert(0 <= color.g && color.g <= 1);
+  assert(0 <= color.b && color.b <= 1);
+  return (SDL_Color){
+      .r = color.r * 255, .g = color.g * 255, .b = color.b * 255, .a = 255};
+}
+
 void sdl_draw_polygon(list_t *points, rgb_color_t color) {
   // Check parameters
   size_t n = list_size(points);
   assert(n >= 3);
-  assert(0 <= color.r && color.r <= 1);
-  assert(0 <= color.g && color.g <= 1);
-  assert(0 <= color.b && color.b <= 1);
+  SDL_Color vertex_color = get_vertex_color(color);
 
-  vector_t window_center = get_window_center();
+  triangle_indices = reserve_batch(triangle_indices, &triangle_capacity,
+                                   3 * (n - 2), sizeof(size_t));
+  triangle_scratch = reserve_batch(triangle_scratch, &scratch_capacity, n,
+                                   sizeof(size_t));
+  size_t triangles =
+      polygon_triangulate(points, triangle_indices, triangle_scratch);
+  reserve_geometry(n, triangles);
 
   // Convert each vertex to a point on screen
-  int16_t *x_points = malloc(sizeof(*x_points) * n),
-          *y_points = malloc(sizeof(*y_points) * n);
-  assert(x_points != NULL);
-  assert(y_points != NULL);
+  vector_t window_center = get_window_center();
+  size_t first = batch_vertex_count;
   for (size_t i = 0; i < n; i++) {
     vector_t *vertex = list_get(points, i);
     vector_t pixel = get_window_position(*vertex, window_center);
-    x_points[i] = pixel.x;
-    y_points[i] = pixel.y;
+    batch_vertices[batch_vertex_count++] =
+        (SDL_Vertex){.position = {.x = pixel.x, .y = pixel.y},
+                     .color = vertex_color,
+                     .tex_coord = {.x = 0, .y = 0}};
+  }
+  for (size_t i = 0; i < 3 * triangles; i++) {
+    batch_indices[batch_index_count++] = first + triangle_indices[i];
   }
+}
+
+/**
+ * Draws a triangle mesh moved to a position and rotated by an angle.
+ * The mesh's triangles are reused, so only the vertices are transformed.
+ */
+void draw_mesh(const body_mesh_t *mesh, vector_t position, double angle,
+               rgb_color_t color) {
+  SDL_Color vertex_color = get_vertex_color(color);
+  reserve_geometry(mesh->vertex_count, mesh->triangle_count);
 
-  // Draw polygon with the given color
-  filledPolygonRGBA(renderer, x_points, y_points, n, color.r * 255,
-                    color.g * 255, color.b * 255, 255);
-  free(x_points);
-  free(y_points);
+  // Combine the rotation, translation and scene-to-window mapping
+  vector_t window_center = get_window_center();
+  double scale = get_scene_scale(window_center);
+  vector_t offset = vec_subtract(position, center);
+  double cos_angle = cos(angle), sin_angle = sin(angle);
+  size_t first = batch_vertex_count;
+  for (size_t i = 0; i < mesh->vertex_count; i++) {
+    vector_t v = mesh->vertices[i];
+    double x = offset.x + cos_angle * v.x - sin_angle * v.y;
+    double y = offset.y + sin_angle * v.x + cos_angle * v.y;
+    batch_vertices[batch_vertex_count++] = (SDL_Vertex){
+        .position = {.x = window_center.x + scale * x,
+                     // Flip y axis since positive y is down on the screen
+                     .y = window_center.y - scale * y},
+        .color = vertex_color,
+        .tex_coord = {.x = 0, .y = 0}};
+  }
+  for (size_t i = 0; i < 3 * mesh->triangle_count; i++) {
+    batch_indices[batch_index_count++] = first + mesh->indices[i];
+  }
 }
 
-void sdl_show(void) {
+/**
+ * Finishes drawing a frame, without presenting it.
+ */
+void finish_frame(void) {
+  flush_polygons();
   // Draw boundary lines
   vector_t window_center = get_window_center();
   vector_t max = vec_add(center, max_diff),
@@ -367,26 +740,75 @@ void sdl_show(void) {
   SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
   SDL_RenderDrawRect(renderer, boundary);
   free(boundary);
+}
+
+void sdl_show(void) {
+  finish_frame();
   SDL_RenderPresent(renderer);
 }
 
+void *load_image(const char *path, void *aux) {
+  SDL_Surface *image = IMG_Load(path);
+  if (image == NULL) {
+    printf("Image Null \n");
+  }
+  return image;
+}
+
+void free_image(void *image) { SDL_FreeSurface(image); }
+
+void *load_font(const char *path, void *aux) {
+  TTF_Font *font = TTF_OpenFont(path, (intptr_t)aux);
+  if (font == NULL) {
+    printf("FONT NOT SET \n");
+  }
+  return font;
+}
+
+void free_font(void *font) { TTF_CloseFont(font); }
+
+void *load_sound(const char *path, void *aux) { return Mix_LoadWAV(path); }
+
+void free_sound(void *sound) { Mix_FreeChunk(sound); }
+
+/**
+ * Opens music to be streamed from its file as it plays,
+ * rather than decoding all of it before it starts.
+ */
+void *load_music(const char *path, void *aux) { return Mix_LoadMUS(path); }
+
+void free_music(void *music) { Mix_FreeMusic(music); }
+
+/**
+ * Gets the background image, or NULL if it has not loaded.
+ */
+SDL_Surface *get_background(void) {
+  asset_t *background = atomic_load(&background_asset);
+  return background != NULL ? asset_get(background) : NULL;
+}
+
+/**
+ * Gets the font, or NULL if it has not loaded.
+ */
+TTF_Font *get_font(void) {
+  asset_t *font = atomic_load(&font_asset);
+  return font != NULL ? asset_get(font) : NULL;
+}
+
 void init_img(char *path) {
   IMG_Init(2);
-  bg_img = IMG_Load(path);
   pic_rec.x = (WINDOW_WIDTH - IMG_W) * 0.5;
   pic_rec.y = (WINDOW_HEIGHT - IMG_H) * 0.5;
   pic_rec.w = IMG_W;
   pic_rec.h = IMG_H;
-  tex = SDL_CreateTextureFromSurface(renderer, bg_img);
-  if (tex == NULL) {
-    printf("Texture Null \n");
-  }
+  // The texture is created by render_img(), on the thread that draws
+  atomic_store(&background_asset,
+               asset_load(assets, path, load_image, free_image, NULL));
 }
 
 void free_img(void) {
-  SDL_FreeSurface(bg_img);
-  bg_img = NULL;
-  tex = NULL;
+  // render_img() drops the texture once the image is gone
+  asset_release(atomic_exchange(&background_asset, NULL));
 }
 
 void init_audio(char *hit, char *powerup, char *wall, char *bg) {
@@ -394,83 +816,331 @@ void init_audio(char *hit, char *powerup, char *wall, char *bg) {
     printf("SOUND NOT SET");
     return;
   }
-  paddle_hit = Mix_LoadWAV(hit);
-  powerup_hit = Mix_LoadWAV(powerup);
-  wall_hit = Mix_LoadWAV(wall);
-  bg_music = Mix_LoadMUS(bg);
+  Mix_AllocateChannels(VOICES);
+  voices = voice_pool_init(SOUNDS, VOICES, VOICES_PER_SOUND);
+  sound_assets[PADDLE_SOUND] =
+      asset_load(assets, hit, load_sound, free_sound, NULL);
+  sound_assets[POWERUP_SOUND] =
+      asset_load(assets, powerup, load_sound, free_sound, NULL);
+  sound_assets[WALL_SOUND] =
+      asset_load(assets, wall, load_sound, free_sound, NULL);
+  bg_music = asset_load(assets, bg, load_music, free_music, NULL);
 }
 
 void free_audio(void) {
-  Mix_FreeChunk(paddle_hit);
-  Mix_FreeChunk(wall_hit);
-  Mix_FreeChunk(powerup_hit);
-  Mix_FreeMusic(bg_music);
-
-  paddle_hit = NULL;
-  wall_hit = NULL;
-  powerup_hit = NULL;
+  if (voices != NULL) {
+    Mix_HaltChannel(-1);
+    voice_pool_free(voices);
+    voices = NULL;
+  }
+  for (sound_t sound = 0; sound < SOUNDS; sound++) {
+    asset_release(sound_assets[sound]);
+    sound_assets[sound] = NULL;
+  }
+  asset_release(bg_music);
   bg_music = NULL;
+  music_requested = false;
+  music_playing = false;
 }
 
 void init_text(char *path, int font_size) {
   TTF_Init();
-  FONT = TTF_OpenFont(path, font_size);
-  if (!FONT) {
-    printf("FONT NOT SET \n");
-  }
+  text_cache = calloc(TEXT_CACHE_SIZE, sizeof(text_entry_t));
+  assert(text_cache != NULL);
+  atomic_store(&font_asset, asset_load(assets, path, load_font, free_font,
+                                       (void *)(intptr_t)font_size));
 }
 
 void free_text(void) {
-  TTF_CloseFont(FONT);
-  FONT = NULL;
-  text_surface = NULL;
+  if (text_cache != NULL) {
+    for (size_t i = 0; i < TEXT_CACHE_SIZE; i++) {
+      SDL_DestroyTexture(text_cache[i].texture);
+      free(text_cache[i].text);
+    }
+    free(text_cache);
+    text_cache = NULL;
+  }
+  asset_release(atomic_exchange(&font_asset, NULL));
+  TTF_Quit();
   text_Texture = NULL;
 }
 
-void play_audio(void) { Mix_PlayChannel(-1, paddle_hit, 0); }
+double sdl_loading_progress(void) { return asset_manager_progress(assets); }
+
+/**
+ * Queues a sound effect to play at the end of the frame,
+ * if it has loaded.
+ */
+void play_sound(sound_t sound) {
+  asset_t *asset = sound_assets[sound];
+  if (voices != NULL && asset != NULL && asset_get(asset) != NULL) {
+    voice_pool_queue(voices, sound);
+  }
+}
+
+void play_audio(void) { play_sound(PADDLE_SOUND); }
+
+void play_wall_audio(void) { play_sound(WALL_SOUND); }
+
+void play_powerup_audio(void) { play_sound(POWERUP_SOUND); }
+
+void play_voice(size_t sound, size_t voice, void *aux) {
+  // Playing on a busy channel stops what it was playing
+  Mix_PlayChannel(voice, asset_get(sound_assets[sound]), 0);
+}
+
+/**
+ * Starts the sound effects queued this frame.
+ */
+void flush_sounds(void) {
+  if (voices == NULL) {
+    return;
+  }
+  for (size_t voice = 0; voice < VOICES; voice++) {
+    if (!Mix_Playing(voice)) {
+      voice_pool_finished(voices, voice);
+    }
+  }
+  voice_pool_flush(voices, play_voice, NULL);
+}
 
-void play_wall_audio(void) { Mix_PlayChannel(-1, wall_hit, 0); }
+void play_bg(void) {
+  // Starts as soon as the music has loaded; see update_assets()
+  music_requested = true;
+  update_assets();
+}
 
-void play_powerup_audio(void) { Mix_PlayChannel(-1, powerup_hit, 0); }
+/**
+ * Finds the cache entry holding a string's texture,
+ * rendering the string into the least recently used entry if needed.
+ */
+text_entry_t *get_text_entry(const char *text) {
+  // Unused entries have last_used 0, so they are filled first
+  text_entry_t *oldest = &text_cache[0];
+  for (size_t i = 0; i < TEXT_CACHE_SIZE; i++) {
+    text_entry_t *entry = &text_cache[i];
+    if (entry->text != NULL && strcmp(entry->text, text) == 0) {
+      return entry;
+    }
+    if (entry->last_used < oldest->last_used) {
+      oldest = entry;
+    }
+  }
 
-void play_bg(void) { Mix_PlayMusic(bg_music, -1); }
+  SDL_DestroyTexture(oldest->texture);
+  free(oldest->text);
+  oldest->text = strdup(text);
+  assert(oldest->text != NULL);
+  oldest->texture = NULL;
+  oldest->width = 0;
+  oldest->height = 0;
+  SDL_Surface *surface = TTF_RenderText_Solid(get_font(), text, TEXT_COLOR);
+  // Rendering fails for an empty string, which just draws nothing
+  if (surface != NULL) {
+    oldest->texture = SDL_CreateTextureFromSurface(renderer, surface);
+    oldest->width = surface->w;
+    oldest->height = surface->h;
+    SDL_FreeSurface(surface);
+  }
+  return oldest;
+}
 
-void create_text(char *text) {
-  if (FONT != NULL) {
-    TTF_Init();
-    text_surface = TTF_RenderText_Solid(FONT, text, TEXT_COLOR);
-    text_Texture = SDL_CreateTextureFromSurface(renderer, text_surface);
-    text_rect.x = (WINDOW_WIDTH - text_surface->w) * 0.5;
-    text_rect.y = (WINDOW_HEIGHT - text_surface->h) * 0.5;
-    text_rect.w = text_surface->w;
-    text_rect.h = text_surface->h;
-    SDL_FreeSurface(text_surface);
-    TTF_Quit();
+void create_text(const char *text) {
+  if (get_font() != NULL) {
+    text_entry_t *entry = get_text_entry(text);
+    entry->last_used = ++text_clock;
+    text_Texture = entry->texture;
+    text_rect.x = (WINDOW_WIDTH - entry->width) * 0.5;
+    text_rect.y = (WINDOW_HEIGHT - entry->height) * 0.5;
+    text_rect.w = entry->width;
+    text_rect.h = entry->height;
   }
 }
 
 void render_text(void) {
+  flush_polygons();
   if (text_Texture != NULL) {
     SDL_RenderCopy(renderer, text_Texture, NULL, &text_rect);
   }
 }
 
-void render_img(void) { SDL_RenderCopy(renderer, tex, NULL, &pic_rec); }
+void render_img(void) {
+  flush_polygons();
+  SDL_Surface *background = get_background();
+  if (background != tex_img) {
+    SDL_DestroyTexture(tex);
+    tex = background != NULL
+              ? SDL_CreateTextureFromSurface(renderer, background)
+              : NULL;
+    tex_img = background;
+  }
+  if (tex != NULL) {
+    SDL_RenderCopy(renderer, tex, NULL, &pic_rec);
+  }
+}
 
-void sdl_render_scene(scene_t *scene, char *message) {
-  SDL_DestroyTexture(text_Texture);
-  sdl_clear();
+/**
+ * Checks whether the static layer still shows the snapshot's static bodies
+ * and the background image, at the current window size.
+ */
+bool static_layer_is_current(const snapshot_t *snapshot, int width,
+                             int height) {
+  if (static_layer == NULL || width != static_layer_width ||
+      height != static_layer_height || get_background() != static_layer_img) {
+    return false;
+  }
+  size_t drawn = 0;
+  size_t body_count = snapshot_bodies(snapshot);
+  for (size_t i = 0; i < body_count; i++) {
+    const snapshot_body_t *body = snapshot_get_body(snapshot, i);
+    if (!body->is_static) {
+      continue;
+    }
+    if (drawn == static_body_count || static_bodies[drawn].body != body->body ||
+        static_bodies[drawn].version != body->version) {
+      return false;
+    }
+    drawn++;
+  }
+  return drawn == static_body_count;
+}
+
+/**
+ * Redraws the background image and static bodies into the static layer.
+ */
+void draw_static_layer(const snapshot_t *snapshot, int width, int height) {
+  if (static_layer == NULL || width != static_layer_width ||
+      height != static_layer_height) {
+    SDL_DestroyTexture(static_layer);
+    static_layer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                                     SDL_TEXTUREACCESS_TARGET, width, height);
+    assert(static_layer != NULL);
+    static_layer_width = width;
+    static_layer_height = height;
+  }
+  SDL_SetRenderTarget(renderer, static_layer);
+  clear_target();
+  static_layer_img = get_background();
   render_img();
-  create_text(message);
-  render_text();
-  size_t body_count = scene_bodies(scene);
+  static_body_count = 0;
+  size_t body_count = snapshot_bodies(snapshot);
+  for (size_t i = 0; i < body_count; i++) {
+    const snapshot_body_t *body = snapshot_get_body(snapshot, i);
+    if (!body->is_static) {
+      continue;
+    }
+    draw_mesh(body->mesh, body->position, body->angle, body->color);
+    static_bodies = reserve_batch(static_bodies, &static_body_capacity,
+                                  static_body_count + 1, sizeof(static_body_t));
+    static_bodies[static_body_count++] = (static_body_t){
+        .body = body->body, .version = body->version};
+  }
+  flush_polygons();
+  SDL_SetRenderTarget(renderer, NULL);
+}
+
+/**
+ * Draws and shows a frame from a snapshot of a scene.
+ */
+void draw_snapshot(const snapshot_t *snapshot) {
+  double start = timing_now();
+  int width, height;
+  SDL_GetWindowSize(window, &width, &height);
+  if (!static_layer_is_current(snapshot, width, height)) {
+    draw_static_layer(snapshot, width, height);
+  }
+  clear_target();
+  SDL_RenderCopy(renderer, static_layer, NULL, NULL);
+  if (snapshot_message(snapshot) != NULL) {
+    create_text(snapshot_message(snapshot));
+    render_text();
+  }
+  size_t body_count = snapshot_bodies(snapshot);
   for (size_t i = 0; i < body_count; i++) {
-    body_t *body = scene_get_body(scene, i);
-    list_t *shape = body_get_shape(body);
-    sdl_draw_polygon(shape, body_get_color(body));
-    list_free(shape);
+    const snapshot_body_t *body = snapshot_get_body(snapshot, i);
+    if (!body->is_static) {
+      draw_mesh(body->mesh, body->position, body->angle, body->color);
+    }
+  }
+  finish_frame();
+  // Presenting waits for vsync, which would hide the cost of drawing
+  timing_histogram_add(stage_times[RENDER_TIME], timing_now() - start);
+  SDL_RenderPresent(renderer);
+}
+
+void sdl_render_scene(scene_t *scene, char *message) {
+  if (last_tick_time >= 0) {
+    timing_histogram_add(stage_times[UPDATE_TIME],
+                         timing_now() - last_tick_time);
+  }
+  // Collision handlers queued their sounds during the tick
+  flush_sounds();
+  if (snapshots == NULL) {
+    snapshots = snapshot_buffer_init();
+  }
+  snapshot_buffer_publish(snapshots, scene, message);
+  if (simulation_is_running()) {
+    return;
+  }
+  draw_snapshot(snapshot_buffer_acquire(snapshots));
+}
+
+#ifndef __EMSCRIPTEN__
+void *simulation_main(void *aux) {
+  while (!atomic_load(&simulation_stopping)) {
+    double start = timing_now();
+    simulation_step(simulation_aux);
+    double elapsed = timing_now() - start;
+    if (elapsed < MIN_STEP_TIME) {
+      SDL_Delay((MIN_STEP_TIME - elapsed) * MS_PER_S);
+    }
+  }
+  return NULL;
+}
+#endif
+
+void sdl_start_simulation_thread(sdl_step_t step, void *aux) {
+#ifndef __EMSCRIPTEN__
+  assert(!atomic_load(&simulation_running));
+  // Created here so the main thread never races the step to create it
+  if (snapshots == NULL) {
+    snapshots = snapshot_buffer_init();
+  }
+  simulation_step = step;
+  simulation_aux = aux;
+  atomic_store(&simulation_stopping, false);
+  atomic_store(&simulation_running, true);
+  int error = pthread_create(&simulation_thread, NULL, simulation_main, NULL);
+  assert(error == 0);
+#endif
+}
+
+void sdl_stop_simulation_thread(void) {
+#ifndef __EMSCRIPTEN__
+  if (!atomic_load(&simulation_running)) {
+    return;
+  }
+  atomic_store(&simulation_stopping, true);
+  pthread_join(simulation_thread, NULL);
+  atomic_store(&simulation_running, false);
+  snapshot_buffer_free(snapshots);
+  snapshots = NULL;
+  has_shown = false;
+#endif
+}
+
+void sdl_show_latest(void) {
+  const snapshot_t *snapshot =
+      snapshots != NULL ? snapshot_buffer_acquire(snapshots) : NULL;
+  if (snapshot == NULL ||
+      (has_shown && snapshot_sequence(snapshot) == shown_sequence)) {
+    // Nothing new to draw yet
+    SDL_Delay(1);
+    return;
   }
-  sdl_show();
+  draw_snapshot(snapshot);
+  shown_sequence = snapshot_sequence(snapshot);
+  has_shown = true;
 }
 
 void sdl_on_key(key_handler_t handler) { key_handler = handler; }
@@ -480,10 +1150,28 @@ void sdl_on_button(controller_handler_t handler) {
 }
 
 double time_since_last_tick(void) {
-  clock_t now = clock();
-  double difference = last_clock
-                          ? (double)(now - last_clock) / CLOCKS_PER_SEC
-                          : 0.0; // return 0 the first time this is called
-  last_clock = now;
+  double now = timing_now();
+  // Return 0 the first time this is called
+  double difference = last_tick_time >= 0 ? now - last_tick_time : 0.0;
+  if (last_tick_time >= 0) {
+    timing_histogram_add(stage_times[FRAME_TIME], difference);
+  }
+  last_tick_time = now;
   return difference;
+}
+
+timing_summary_t sdl_get_timing(frame_stage_t stage) {
+  assert(stage < FRAME_STAGES);
+  return timing_histogram_summary(stage_times[stage]);
+}
+
+void sdl_print_timing(void) {
+  for (frame_stage_t stage = 0; stage < FRAME_STAGES; stage++) {
+    timing_summary_t summary = sdl_get_timing(stage);
+    printf("%s time (ms) over %zu frames: p50 %.2f, p95 %.2f, p99 %.2f, "
+           "max %.2f\n",
+           STAGE_NAMES[stage], summary.samples, summary.p50 * MS_PER_S,
+           summary.p95 * MS_PER_S, summary.p99 * MS_PER_S,
+           summary.max * MS_PER_S);
+  }
 }
\ No newline at end of file
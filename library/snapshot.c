@@ -0,0 +1,151 @@
+#include "snapshot.h"
+#include "mem_stats.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <string.h>
+
+// The number of snapshots in a buffer
+#define SNAPSHOT_COUNT 3
+// Set in the shared slot once the writer has published into it
+const unsigned FRESH = 4;
+const unsigned SLOT_MASK = 3;
+
+typedef struct snapshot {
+  size_t sequence;
+  snapshot_body_t *bodies;
+  size_t body_count;
+  size_t body_capacity;
+  // NULL if the snapshot has no message
+  char *message;
+  size_t message_capacity;
+} snapshot_t;
+
+typedef struct snapshot_buffer {
+  snapshot_t snapshots[SNAPSHOT_COUNT];
+  // The snapshot the writer fills; only the writer uses it
+  unsigned write_slot;
+  // The snapshot the reader holds; only the reader uses it
+  unsigned read_slot;
+  // The latest published snapshot, or the reader's last one if it
+  // has been taken; with FRESH set if the reader has not seen it
+  atomic_uint shared;
+  size_t published;
+  bool has_read;
+} snapshot_buffer_t;
+
+snapshot_buffer_t *snapshot_buffer_init(void) {
+  snapshot_buffer_t *buffer = mem_alloc(MEM_SCENE, sizeof(snapshot_buffer_t));
+  for (size_t i = 0; i < SNAPSHOT_COUNT; i++) {
+    buffer->snapshots[i] = (snapshot_t){.sequence = 0,
+                                        .bodies = NULL,
+                                        .body_count = 0,
+                                        .body_capacity = 0,
+                                        .message = NULL,
+                                        .message_capacity = 0};
+  }
+  buffer->write_slot = 0;
+  buffer->read_slot = 1;
+  atomic_init(&buffer->shared, 2);
+  buffer->published = 0;
+  buffer->has_read = false;
+  return buffer;
+}
+
+void release_bodies(snapshot_t *snapshot) {
+  for (size_t i = 0; i < snapshot->body_count; i++) {
+    body_mesh_release(snapshot->bodies[i].mesh);
+  }
+  snapshot->body_count = 0;
+}
+
+void snapshot_buffer_free(snapshot_buffer_t *buffer) {
+  for (size_t i = 0; i < SNAPSHOT_COUNT; i++) {
+    snapshot_t *snapshot = &buffer->snapshots[i];
+    release_bodies(snapshot);
+    mem_free(MEM_SCENE, snapshot->bodies,
+             snapshot->body_capacity * sizeof(snapshot_body_t));
+    mem_free(MEM_SCENE, snapshot->message, snapshot->message_capacity);
+  }
+  mem_free(MEM_SCENE, buffer, sizeof(snapshot_buffer_t));
+}
+
+void copy_message(snapshot_t *snapshot, const char *message) {
+  if (message == NULL) {
+    mem_free(MEM_SCENE, snapshot->message, snapshot->message_capacity);
+    snapshot->message = NULL;
+    snapshot->message_capacity = 0;
+    return;
+  }
+  size_t size = strlen(message) + 1;
+  if (size > snapshot->message_capacity) {
+    mem_free(MEM_SCENE, snapshot->message, snapshot->message_capacity);
+    snapshot->message = mem_alloc(MEM_SCENE, size);
+    snapshot->message_capacity = size;
+  }
+  memcpy(snapshot->message, message, size);
+}
+
+void snapshot_buffer_publish(snapshot_buffer_t *buffer, scene_t *scene,
+                             const char *message) {
+  snapshot_t *snapshot = &buffer->snapshots[buffer->write_slot];
+  // The reader is done with this snapshot, so its meshes can be let go
+  release_bodies(snapshot);
+  size_t body_count = scene_bodies(scene);
+  if (body_count > snapshot->body_capacity) {
+    mem_free(MEM_SCENE, snapshot->bodies,
+             snapshot->body_capacity * sizeof(snapshot_body_t));
+    snapshot->bodies =
+        mem_alloc(MEM_SCENE, body_count * sizeof(snapshot_body_t));
+    snapshot->body_capacity = body_count;
+  }
+  for (size_t i = 0; i < body_count; i++) {
+    body_t *body = scene_get_body(scene, i);
+    const body_mesh_t *mesh = body_get_mesh(body);
+    body_mesh_retain(mesh);
+    snapshot->bodies[i] = (snapshot_body_t){
+        .body = body,
+        .version = body_get_version(body),
+        .mesh = mesh,
+        .position = body_get_centroid(body),
+        .angle = body_get_rotation(body) - mesh->rotation,
+        .color = body_get_color(body),
+        .is_static = body_is_static(body)};
+  }
+  snapshot->body_count = body_count;
+  copy_message(snapshot, message);
+  snapshot->sequence = buffer->published++;
+
+  // Release ordering makes the snapshot's contents visible to the reader
+  // before the slot is; the writer takes whichever slot was shared
+  unsigned previous = atomic_exchange_explicit(
+      &buffer->shared, buffer->write_slot | FRESH, memory_order_acq_rel);
+  buffer->write_slot = previous & SLOT_MASK;
+}
+
+const snapshot_t *snapshot_buffer_acquire(snapshot_buffer_t *buffer) {
+  if (atomic_load_explicit(&buffer->shared, memory_order_acquire) & FRESH) {
+    unsigned previous = atomic_exchange_explicit(
+        &buffer->shared, buffer->read_slot, memory_order_acq_rel);
+    buffer->read_slot = previous & SLOT_MASK;
+    buffer->has_read = true;
+  }
+  return buffer->has_read ? &buffer->snapshots[buffer->read_slot] : NULL;
+}
+
+size_t snapshot_sequence(const snapshot_t *snapshot) {
+  return snapshot->sequence;
+}
+
+size_t snapshot_bodies(const snapshot_t *snapshot) {
+  return snapshot->body_count;
+}
+
+const snapshot_body_t *snapshot_get_body(const snapshot_t *snapshot,
+                                         size_t index) {
+  assert(index < snapshot->body_count);
+  return &snapshot->bodies[index];
+}
+
+const char *snapshot_message(const snapshot_t *snapshot) {
+  return snapshot->message;
+}
@@ -0,0 +1,221 @@
+#include "spring_network.h"
+#include "mem_stats.h"
+#include <assert.h>
+#include <math.h>
+
+typedef struct spring_network {
+  size_t body_count;
+  size_t body_capacity;
+  body_t **bodies;
+  // Each body's centroid, gathered once per call to spring_network_apply()
+  vector_t *positions;
+
+  size_t spring_count;
+  size_t spring_capacity;
+  // The indices of each spring's bodies, in pairs
+  size_t *ends;
+  double *k;
+  double *rest_length;
+
+  // The springs of body i are entries [offsets[i], offsets[i + 1])
+  // of neighbors (the other body) and edges (the spring)
+  bool adjacency_dirty;
+  size_t *offsets;
+  size_t offsets_capacity;
+  size_t *neighbors;
+  size_t *edges;
+  size_t adjacency_capacity;
+} spring_network_t;
+
+void set_body_capacity(spring_network_t *network, size_t capacity) {
+  size_t old = network->body_capacity;
+  network->bodies = mem_realloc(MEM_FORCE, network->bodies,
+                                old * sizeof(body_t *),
+                                capacity * sizeof(body_t *));
+  network->positions = mem_realloc(MEM_FORCE, network->positions,
+                                   old * sizeof(vector_t),
+                                   capacity * sizeof(vector_t));
+  network->body_capacity = capacity;
+}
+
+void set_spring_capacity(spring_network_t *network, size_t capacity) {
+  size_t old = network->spring_capacity;
+  network->ends = mem_realloc(MEM_FORCE, network->ends, 2 * old * sizeof(size_t),
+                              2 * capacity * sizeof(size_t));
+  network->k = mem_realloc(MEM_FORCE, network->k, old * sizeof(double),
+                           capacity * sizeof(double));
+  network->rest_length =
+      mem_realloc(MEM_FORCE, network->rest_length, old * sizeof(double),
+                  capacity * sizeof(double));
+  network->spring_capacity = capacity;
+}
+
+spring_network_t *spring_network_init(size_t initial_bodies,
+                                      size_t initial_springs) {
+  spring_network_t *network = mem_alloc(MEM_FORCE, sizeof(spring_network_t));
+  network->body_count = 0;
+  network->body_capacity = 0;
+  network->bodies = NULL;
+  network->positions = NULL;
+  network->spring_count = 0;
+  network->spring_capacity = 0;
+  network->ends = NULL;
+  network->k = NULL;
+  network->rest_length = NULL;
+  network->adjacency_dirty = true;
+  network->offsets = NULL;
+  network->offsets_capacity = 0;
+  network->neighbors = NULL;
+  network->edges = NULL;
+  network->adjacency_capacity = 0;
+  set_body_capacity(network, initial_bodies > 0 ? initial_bodies : 1);
+  set_spring_capacity(network, initial_springs > 0 ? initial_springs : 1);
+  return network;
+}
+
+void spring_network_free(spring_network_t *network) {
+  mem_free(MEM_FORCE, network->bodies,
+           network->body_capacity * sizeof(body_t *));
+  mem_free(MEM_FORCE, network->positions,
+           network->body_capacity * sizeof(vector_t));
+  mem_free(MEM_FORCE, network->ends,
+           2 * network->spring_capacity * sizeof(size_t));
+  mem_free(MEM_FORCE, network->k, network->spring_capacity * sizeof(double));
+  mem_free(MEM_FORCE, network->rest_length,
+           network->spring_capacity * sizeof(double));
+  mem_free(MEM_FORCE, network->offsets,
+           network->offsets_capacity * sizeof(size_t));
+  mem_free(MEM_FORCE, network->neighbors,
+           network->adjacency_capacity * sizeof(size_t));
+  mem_free(MEM_FORCE, network->edges,
+           network->adjacency_capacity * sizeof(size_t));
+  mem_free(MEM_FORCE, network, sizeof(spring_network_t));
+}
+
+size_t spring_network_add_body(spring_network_t *network, body_t *body) {
+  assert(body != NULL);
+  if (network->body_count == network->body_capacity) {
+    set_body_capacity(network, 2 * network->body_capacity);
+  }
+  network->bodies[network->body_count] = body;
+  network->adjacency_dirty = true;
+  return network->body_count++;
+}
+
+void spring_network_add_spring(spring_network_t *network, size_t body1,
+                               size_t body2, double k, double rest_length) {
+  assert(body1 < network->body_count);
+  assert(body2 < network->body_count);
+  assert(body1 != body2);
+  if (network->spring_count == network->spring_capacity) {
+    set_spring_capacity(network, 2 * network->spring_capacity);
+  }
+  size_t spring = network->spring_count++;
+  network->ends[2 * spring] = body1;
+  network->ends[2 * spring + 1] = body2;
+  network->k[spring] = k;
+  network->rest_length[spring] = rest_length;
+  network->adjacency_dirty = true;
+}
+
+size_t spring_network_bodies(spring_network_t *network) {
+  return network->body_count;
+}
+
+body_t *spring_network_get_body(spring_network_t *network, size_t index) {
+  assert(index < network->body_count);
+  return network->bodies[index];
+}
+
+size_t spring_network_springs(spring_network_t *network) {
+  return network->spring_count;
+}
+
+void build_adjacency(spring_network_t *network) {
+  size_t offsets_needed = network->body_count + 1;
+  if (offsets_needed > network->offsets_capacity) {
+    network->offsets = mem_realloc(
+        MEM_FORCE, network->offsets,
+        network->offsets_capacity * sizeof(size_t),
+        offsets_needed * sizeof(size_t));
+    network->offsets_capacity = offsets_needed;
+  }
+  size_t entries = 2 * network->spring_count;
+  if (entries > network->adjacency_capacity) {
+    network->neighbors = mem_realloc(
+        MEM_FORCE, network->neighbors,
+        network->adjacency_capacity * sizeof(size_t), entries * sizeof(size_t));
+    network->edges = mem_realloc(MEM_FORCE, network->edges,
+                                 network->adjacency_capacity * sizeof(size_t),
+                                 entries * sizeof(size_t));
+    network->adjacency_capacity = entries;
+  }
+
+  // Count each body's springs, then turn the counts into start offsets
+  size_t *offsets = network->offsets;
+  for (size_t i = 0; i <= network->body_count; i++) {
+    offsets[i] = 0;
+  }
+  for (size_t i = 0; i < entries; i++) {
+    offsets[network->ends[i] + 1]++;
+  }
+  for (size_t i = 0; i < network->body_count; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+  // Fill each body's range, using offsets[i] as its cursor.
+  // Afterwards offsets[i] holds the end of body i, i.e. the start of i + 1.
+  for (size_t spring = 0; spring < network->spring_count; spring++) {
+    size_t body1 = network->ends[2 * spring];
+    size_t body2 = network->ends[2 * spring + 1];
+    network->neighbors[offsets[body1]] = body2;
+    network->edges[offsets[body1]++] = spring;
+    network->neighbors[offsets[body2]] = body1;
+    network->edges[offsets[body2]++] = spring;
+  }
+  for (size_t i = network->body_count; i > 0; i--) {
+    offsets[i] = offsets[i - 1];
+  }
+  offsets[0] = 0;
+  network->adjacency_dirty = false;
+}
+
+void spring_network_apply(spring_network_t *network) {
+  if (network->adjacency_dirty) {
+    build_adjacency(network);
+  }
+  for (size_t i = 0; i < network->body_count; i++) {
+    network->positions[i] = body_get_centroid(network->bodies[i]);
+  }
+  for (size_t i = 0; i < network->body_count; i++) {
+    vector_t position = network->positions[i];
+    double force_x = 0;
+    double force_y = 0;
+    for (size_t entry = network->offsets[i]; entry < network->offsets[i + 1];
+         entry++) {
+      vector_t other = network->positions[network->neighbors[entry]];
+      size_t spring = network->edges[entry];
+      double dx = other.x - position.x;
+      double dy = other.y - position.y;
+      double scalar = network->k[spring];
+      double rest_length = network->rest_length[spring];
+      if (rest_length != 0) {
+        double length = sqrt(dx * dx + dy * dy);
+        // Coincident bodies have no direction to push apart along
+        scalar = length > 0 ? scalar * (length - rest_length) / length : 0;
+      }
+      force_x += scalar * dx;
+      force_y += scalar * dy;
+    }
+    if (network->offsets[i] < network->offsets[i + 1]) {
+      body_add_force(network->bodies[i], (vector_t){force_x, force_y});
+    }
+  }
+}
+
+size_t spring_network_memory_size(spring_network_t *network) {
+  return sizeof(spring_network_t) +
+         network->body_capacity * (sizeof(body_t *) + sizeof(vector_t)) +
+         network->spring_capacity * (2 * sizeof(size_t) + 2 * sizeof(double)) +
+         network->offsets_capacity * sizeof(size_t) +
+         network->adjacency_capacity * 2 * sizeof(size_t);
+}
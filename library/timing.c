@@ -0,0 +1,106 @@
+#include "timing.h"
+#include "mem_stats.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef __EMSCRIPTEN__
+#include <pthread.h>
+#endif
+
+typedef struct timing_histogram {
+#ifndef __EMSCRIPTEN__
+  pthread_mutex_t lock;
+#endif
+  // A ring buffer of the most recent samples
+  double *samples;
+  size_t window;
+  size_t count;
+  // The index the next sample is written to
+  size_t next;
+  // Holds the sorted samples while summarizing them
+  double *sorted;
+} timing_histogram_t;
+
+double timing_now(void) {
+  struct timespec now;
+  int error = clock_gettime(CLOCK_MONOTONIC, &now);
+  assert(error == 0);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+timing_histogram_t *timing_histogram_init(size_t window) {
+  assert(window > 0);
+  timing_histogram_t *histogram =
+      mem_alloc(MEM_TIMING, sizeof(timing_histogram_t));
+#ifndef __EMSCRIPTEN__
+  pthread_mutex_init(&histogram->lock, NULL);
+#endif
+  histogram->samples = mem_alloc(MEM_TIMING, window * sizeof(double));
+  histogram->sorted = mem_alloc(MEM_TIMING, window * sizeof(double));
+  histogram->window = window;
+  histogram->count = 0;
+  histogram->next = 0;
+  return histogram;
+}
+
+void timing_histogram_free(timing_histogram_t *histogram) {
+#ifndef __EMSCRIPTEN__
+  pthread_mutex_destroy(&histogram->lock);
+#endif
+  mem_free(MEM_TIMING, histogram->samples, histogram->window * sizeof(double));
+  mem_free(MEM_TIMING, histogram->sorted, histogram->window * sizeof(double));
+  mem_free(MEM_TIMING, histogram, sizeof(timing_histogram_t));
+}
+
+void timing_histogram_add(timing_histogram_t *histogram, double seconds) {
+#ifndef __EMSCRIPTEN__
+  pthread_mutex_lock(&histogram->lock);
+#endif
+  histogram->samples[histogram->next] = seconds;
+  histogram->next = (histogram->next + 1) % histogram->window;
+  if (histogram->count < histogram->window) {
+    histogram->count++;
+  }
+#ifndef __EMSCRIPTEN__
+  pthread_mutex_unlock(&histogram->lock);
+#endif
+}
+
+int compare_durations(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Gets the smallest sample that at least the given percentage
+ * of the sorted samples are less than or equal to.
+ */
+double percentile(const double *sorted, size_t count, size_t percent) {
+  // Rounds up in integers, since percent / 100.0 may not be exact
+  size_t rank = (percent * count + 99) / 100;
+  return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+timing_summary_t timing_histogram_summary(timing_histogram_t *histogram) {
+#ifndef __EMSCRIPTEN__
+  pthread_mutex_lock(&histogram->lock);
+#endif
+  size_t count = histogram->count;
+  timing_summary_t summary = {0};
+  if (count > 0) {
+    double *sorted = histogram->sorted;
+    memcpy(sorted, histogram->samples, count * sizeof(double));
+    qsort(sorted, count, sizeof(double), compare_durations);
+    summary = (timing_summary_t){.samples = count,
+                                 .p50 = percentile(sorted, count, 50),
+                                 .p95 = percentile(sorted, count, 95),
+                                 .p99 = percentile(sorted, count, 99),
+                                 .max = sorted[count - 1]};
+  }
+#ifndef __EMSCRIPTEN__
+  pthread_mutex_unlock(&histogram->lock);
+#endif
+  return summary;
+}
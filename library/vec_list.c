@@ -1,5 +1,6 @@
 #include "vec_list.h"
 #include "list.h"
+#include "mem_stats.h"
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,6 +9,7 @@ typedef struct vec_list {
   vector_t **array;
   size_t size;
   size_t alloc;
+  free_func_t freer;
 } vec_list_t;
 
 vec_list_t *vec_list_init(size_t initial_size) {
@@ -17,8 +19,8 @@ vec_list_t *vec_list_init(size_t initial_size) {
 void vec_list_free(vec_list_t *list) { list_free((list_t *)list); }
 
 void vec_list_array_free(vec_list_t *list) {
-  free(list->array);
-  free(list);
+  mem_free(MEM_LIST, list->array, list->alloc * sizeof(void *));
+  mem_free(MEM_LIST, list, sizeof(*list));
 }
 
 size_t vec_list_size(vec_list_t *list) { return list_size((list_t *)list); }
@@ -0,0 +1,126 @@
+#include "voice_pool.h"
+#include "mem_stats.h"
+#include <assert.h>
+
+// The sound of a voice that is not playing anything
+const size_t NO_SOUND = (size_t)-1;
+
+typedef struct voice {
+  size_t sound;
+  // The pool's start count when the sound started, to find the oldest
+  size_t started;
+} voice_t;
+
+typedef struct voice_pool {
+  size_t sounds;
+  voice_t *voices;
+  size_t voice_count;
+  size_t max_per_sound;
+  // The sounds queued this frame, in order, with a flag per sound
+  size_t *queue;
+  size_t queue_size;
+  bool *queued;
+  size_t starts;
+} voice_pool_t;
+
+voice_pool_t *voice_pool_init(size_t sounds, size_t voices,
+                              size_t max_per_sound) {
+  assert(voices > 0);
+  assert(max_per_sound > 0);
+  voice_pool_t *pool = mem_alloc(MEM_AUDIO, sizeof(voice_pool_t));
+  pool->sounds = sounds;
+  pool->voices = mem_alloc(MEM_AUDIO, voices * sizeof(voice_t));
+  for (size_t i = 0; i < voices; i++) {
+    pool->voices[i] = (voice_t){.sound = NO_SOUND, .started = 0};
+  }
+  pool->voice_count = voices;
+  pool->max_per_sound = max_per_sound;
+  pool->queue = mem_alloc(MEM_AUDIO, sounds * sizeof(size_t));
+  pool->queue_size = 0;
+  pool->queued = mem_alloc(MEM_AUDIO, sounds * sizeof(bool));
+  for (size_t i = 0; i < sounds; i++) {
+    pool->queued[i] = false;
+  }
+  pool->starts = 0;
+  return pool;
+}
+
+void voice_pool_free(voice_pool_t *pool) {
+  mem_free(MEM_AUDIO, pool->voices, pool->voice_count * sizeof(voice_t));
+  mem_free(MEM_AUDIO, pool->queue, pool->sounds * sizeof(size_t));
+  mem_free(MEM_AUDIO, pool->queued, pool->sounds * sizeof(bool));
+  mem_free(MEM_AUDIO, pool, sizeof(voice_pool_t));
+}
+
+void voice_pool_queue(voice_pool_t *pool, size_t sound) {
+  assert(sound < pool->sounds);
+  if (!pool->queued[sound]) {
+    pool->queued[sound] = true;
+    pool->queue[pool->queue_size++] = sound;
+  }
+}
+
+void voice_pool_finished(voice_pool_t *pool, size_t voice) {
+  assert(voice < pool->voice_count);
+  pool->voices[voice].sound = NO_SOUND;
+}
+
+/**
+ * Chooses the voice to play a sound on: the sound's oldest voice if it
+ * is playing on as many as it may, otherwise a free voice,
+ * otherwise the oldest voice of all.
+ */
+size_t choose_voice(voice_pool_t *pool, size_t sound) {
+  size_t playing = 0;
+  size_t oldest_of_sound = 0;
+  size_t oldest = 0;
+  size_t free_voice = NO_SOUND;
+  for (size_t i = 0; i < pool->voice_count; i++) {
+    voice_t *voice = &pool->voices[i];
+    if (voice->sound == NO_SOUND) {
+      if (free_voice == NO_SOUND) {
+        free_voice = i;
+      }
+      continue;
+    }
+    if (voice->started < pool->voices[oldest].started ||
+        pool->voices[oldest].sound == NO_SOUND) {
+      oldest = i;
+    }
+    if (voice->sound == sound) {
+      if (playing == 0 ||
+          voice->started < pool->voices[oldest_of_sound].started) {
+        oldest_of_sound = i;
+      }
+      playing++;
+    }
+  }
+  if (playing >= pool->max_per_sound) {
+    return oldest_of_sound;
+  }
+  return free_voice != NO_SOUND ? free_voice : oldest;
+}
+
+size_t voice_pool_flush(voice_pool_t *pool, voice_play_t play, void *aux) {
+  for (size_t i = 0; i < pool->queue_size; i++) {
+    size_t sound = pool->queue[i];
+    pool->queued[sound] = false;
+    size_t voice = choose_voice(pool, sound);
+    pool->voices[voice] =
+        (voice_t){.sound = sound, .started = pool->starts++};
+    play(sound, voice, aux);
+  }
+  size_t started = pool->queue_size;
+  pool->queue_size = 0;
+  return started;
+}
+
+size_t voice_pool_playing(voice_pool_t *pool, size_t sound) {
+  size_t playing = 0;
+  for (size_t i = 0; i < pool->voice_count; i++) {
+    if (pool->voices[i].sound == sound) {
+      playing++;
+    }
+  }
+  return playing;
+}
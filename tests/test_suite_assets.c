@@ -0,0 +1,158 @@
+#include "assets.h"
+#include "mem_stats.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+atomic_size_t loads;
+atomic_size_t frees;
+
+// "Loads" a file by copying its path, or fails if the path is "missing"
+void *load_path(const char *path, void *aux) {
+  atomic_fetch_add(&loads, 1);
+  if (strcmp(path, "missing") == 0) {
+    return NULL;
+  }
+  char *copy = malloc(strlen(path) + 1);
+  strcpy(copy, path);
+  return copy;
+}
+
+void free_path(void *data) {
+  atomic_fetch_add(&frees, 1);
+  free(data);
+}
+
+// Loads a file only once the test opens the gate
+atomic_bool gate_open;
+
+void *load_after_gate(const char *path, void *aux) {
+  while (!atomic_load(&gate_open)) {
+  }
+  return load_path(path, aux);
+}
+
+void reset_counts() {
+  atomic_store(&loads, 0);
+  atomic_store(&frees, 0);
+}
+
+void test_poll() {
+  reset_counts();
+  size_t bytes = mem_live_bytes(MEM_ASSET);
+  asset_manager_t *manager = asset_manager_init(false);
+  assert(asset_manager_progress(manager) == 1);
+
+  asset_t *a = asset_load(manager, "a.png", load_path, free_path, NULL);
+  asset_t *b = asset_load(manager, "b.wav", load_path, free_path, NULL);
+  asset_t *missing = asset_load(manager, "missing", load_path, free_path, NULL);
+  // Nothing loads until the manager is polled
+  assert(asset_get_state(a) == ASSET_LOADING);
+  assert(asset_get(a) == NULL);
+  assert(asset_manager_progress(manager) == 0);
+
+  // One asset loads per poll, in the order they were requested
+  asset_manager_poll(manager);
+  assert(asset_get_state(a) == ASSET_READY);
+  assert(strcmp(asset_get(a), "a.png") == 0);
+  assert(asset_get_state(b) == ASSET_LOADING);
+  assert(isclose(asset_manager_progress(manager), 1.0 / 3));
+  asset_manager_poll(manager);
+  assert(strcmp(asset_get(b), "b.wav") == 0);
+  assert(isclose(asset_manager_progress(manager), 2.0 / 3));
+  asset_manager_poll(manager);
+  assert(asset_get_state(missing) == ASSET_FAILED);
+  assert(asset_get(missing) == NULL);
+  assert(asset_manager_progress(manager) == 1);
+  asset_manager_poll(manager);
+  assert(atomic_load(&loads) == 3);
+
+  asset_release(a);
+  asset_release(b);
+  asset_release(missing);
+  assert(atomic_load(&frees) == 2);
+  asset_manager_free(manager);
+  assert(mem_live_bytes(MEM_ASSET) == bytes);
+}
+
+void test_references() {
+  reset_counts();
+  atomic_store(&gate_open, true);
+  asset_manager_t *manager = asset_manager_init(false);
+  asset_t *a = asset_load(manager, "a.png", load_path, free_path, NULL);
+  // The same file is shared, but a different loader gets its own handle
+  assert(asset_load(manager, "a.png", load_path, free_path, NULL) == a);
+  asset_t *other = asset_load(manager, "a.png", load_after_gate, free_path,
+                              NULL);
+  assert(other != a);
+  asset_retain(a);
+  asset_manager_wait(manager);
+  assert(atomic_load(&loads) == 2);
+
+  asset_release(a);
+  asset_release(a);
+  assert(atomic_load(&frees) == 0);
+  assert(strcmp(asset_get(a), "a.png") == 0);
+  asset_release(a);
+  assert(atomic_load(&frees) == 1);
+  asset_release(other);
+  asset_release(NULL);
+  assert(atomic_load(&frees) == 2);
+
+  // Releasing an asset before it loads frees it without loading it
+  asset_t *unused = asset_load(manager, "b.wav", load_path, free_path, NULL);
+  asset_release(unused);
+  asset_manager_free(manager);
+  assert(atomic_load(&frees) == 2);
+}
+
+void test_thread() {
+  reset_counts();
+  atomic_store(&gate_open, false);
+  size_t bytes = mem_live_bytes(MEM_ASSET);
+  asset_manager_t *manager = asset_manager_init(true);
+  asset_t *slow = asset_load(manager, "slow", load_after_gate, free_path, NULL);
+  asset_t *fast = asset_load(manager, "fast", load_path, free_path, NULL);
+  // Requesting assets never waits for them
+  assert(asset_get_state(slow) == ASSET_LOADING);
+  assert(asset_get_state(fast) == ASSET_LOADING);
+  assert(asset_manager_progress(manager) < 1);
+  asset_manager_poll(manager);
+  assert(asset_get_state(fast) == ASSET_LOADING);
+
+  atomic_store(&gate_open, true);
+  asset_manager_wait(manager);
+  assert(strcmp(asset_get(slow), "slow") == 0);
+  assert(strcmp(asset_get(fast), "fast") == 0);
+  assert(asset_manager_progress(manager) == 1);
+
+  // The loader thread keeps working after going idle
+  asset_t *late = asset_load(manager, "late", load_path, free_path, NULL);
+  asset_manager_wait(manager);
+  assert(strcmp(asset_get(late), "late") == 0);
+
+  asset_release(slow);
+  asset_release(fast);
+  asset_release(late);
+  asset_manager_free(manager);
+  assert(atomic_load(&frees) == 3);
+  assert(mem_live_bytes(MEM_ASSET) == bytes);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_poll)
+  DO_TEST(test_references)
+  DO_TEST(test_thread)
+
+  puts("assets_test PASS");
+}
@@ -78,6 +78,10 @@ void test_body_setters() {
   assert(
       vec_isclose(*(vector_t *)list_get(shape, 2), (vector_t){10.0 / 3.0, 3}));
   list_free(shape);
+  assert(body_get_layers(body) == LAYER_DEFAULT);
+  body_set_layers(body, 0x6);
+  assert(body_get_layers(body) == 0x6);
+  assert(body_get_state(body).layers == 0x6);
   body_free(body);
 }
 
@@ -248,6 +252,105 @@ void test_body_info_freer() {
   body_free(body);
 }
 
+void test_body_version() {
+  vector_t v[] = {{1, 1}, {2, 1}, {2, 2}, {1, 2}};
+  list_t *shape = list_init(4, free);
+  list_t *other_shape = list_init(4, free);
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *list_v = malloc(sizeof(*list_v));
+    *list_v = v[i];
+    list_add(shape, list_v);
+    list_v = malloc(sizeof(*list_v));
+    *list_v = v[i];
+    list_add(other_shape, list_v);
+  }
+  body_t *body = body_init(shape, INFINITY, (rgb_color_t){0, 0, 0});
+  body_t *other = body_init(other_shape, 1, (rgb_color_t){0, 0, 0});
+  assert(!body_is_static(body));
+  body_set_static(body, true);
+  assert(body_is_static(body));
+  assert(body_get_version(body) != body_get_version(other));
+
+  // Ticking a body that does not move leaves its version alone
+  uint64_t version = body_get_version(body);
+  body_tick(body, 1);
+  body_set_centroid(body, body_get_centroid(body));
+  body_set_rotation(body, 0);
+  assert(body_get_version(body) == version);
+
+  body_set_centroid(body, (vector_t){5, 5});
+  assert(body_get_version(body) != version);
+  version = body_get_version(body);
+  body_y_scale(body, 2);
+  assert(body_get_version(body) != version);
+  version = body_get_version(body);
+  body_set_color(body, (rgb_color_t){1, 0, 0});
+  assert(body_get_version(body) != version);
+  version = body_get_version(body);
+  body_set_rotation(body, 0.5);
+  assert(body_get_version(body) != version);
+  body_free(body);
+  body_free(other);
+}
+
+// Checks that a mesh transformed by the body's motion matches its shape
+void check_mesh(body_t *body, const body_mesh_t *mesh) {
+  list_t *shape = body_peek_shape(body);
+  assert(mesh->vertex_count == list_size(shape));
+  assert(mesh->triangle_count == list_size(shape) - 2);
+  double angle = body_get_rotation(body) - mesh->rotation;
+  for (size_t i = 0; i < mesh->vertex_count; i++) {
+    vector_t vertex = vec_add(body_get_centroid(body),
+                              vec_rotate(mesh->vertices[i], angle));
+    assert(vec_isclose(vertex, *(vector_t *)list_get(shape, i)));
+  }
+  for (size_t i = 0; i < 3 * mesh->triangle_count; i++) {
+    assert(mesh->indices[i] < mesh->vertex_count);
+  }
+}
+
+void test_body_mesh() {
+  vector_t v[] = {{1, 1}, {2, 1}, {2, 2}, {1.5, 1.2}, {1, 2}};
+  list_t *shape = list_init(5, free);
+  for (size_t i = 0; i < 5; i++) {
+    vector_t *list_v = malloc(sizeof(*list_v));
+    *list_v = v[i];
+    list_add(shape, list_v);
+  }
+  body_t *body = body_init(shape, 1, (rgb_color_t){0, 0, 0});
+  const body_mesh_t *mesh = body_get_mesh(body);
+  check_mesh(body, mesh);
+  size_t memory = body_memory_size(body);
+
+  // Moving the body keeps the mesh
+  body_set_centroid(body, (vector_t){10, -3});
+  body_set_rotation(body, 1.0);
+  assert(body_get_mesh(body) == mesh);
+  check_mesh(body, mesh);
+
+  // Reshaping it rebuilds the mesh
+  body_y_scale(body, 2);
+  mesh = body_get_mesh(body);
+  check_mesh(body, mesh);
+  assert(body_memory_size(body) == memory);
+  body_free(body);
+}
+
+void test_degenerate_mesh() {
+  list_t *shape = list_init(2, free);
+  for (size_t i = 0; i < 2; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t){i, 0};
+    list_add(shape, v);
+  }
+  body_t *body = body_init(shape, 1, (rgb_color_t){0, 0, 0});
+  const body_mesh_t *mesh = body_get_mesh(body);
+  assert(mesh->vertex_count == 2);
+  assert(mesh->triangle_count == 0);
+  assert(mesh->indices == NULL);
+  body_free(body);
+}
+
 int main(int argc, char *argv[]) {
   // Run all tests if there are no command-line arguments
   bool all_tests = argc == 1;
@@ -265,6 +368,9 @@ int main(int argc, char *argv[]) {
   DO_TEST(test_body_remove)
   DO_TEST(test_body_info)
   DO_TEST(test_body_info_freer)
+  DO_TEST(test_body_version)
+  DO_TEST(test_body_mesh)
+  DO_TEST(test_degenerate_mesh)
 
   puts("body_test PASS");
 }
@@ -1,7 +1,42 @@
+#include "collision.h"
 #include "test_util.h"
 #include <assert.h>
 #include <stdlib.h>
 
+// A triangle with its bounding box's corner at the origin
+list_t *make_triangle(vector_t offset) {
+  list_t *shape = list_init(3, free);
+  vector_t vertices[] = {{0, 0}, {2, 0}, {0, 1}};
+  for (size_t i = 0; i < 3; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = vec_add(vertices[i], offset);
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+void test_bounding_boxes() {
+  list_t *shape = make_triangle(VEC_ZERO);
+  vector_t offsets[] = {{1, 0.5}, {2, 0}, {-2, -1}, {2.1, 0}, {0, -1.1}};
+  bool overlaps[] = {true, true, true, false, false};
+  for (size_t i = 0; i < 5; i++) {
+    list_t *other = make_triangle(offsets[i]);
+    assert(bounding_boxes_overlap(shape, other) == overlaps[i]);
+    assert(bounding_boxes_overlap(other, shape) == overlaps[i]);
+    // Shapes whose boxes don't overlap never collide
+    if (!overlaps[i]) {
+      assert(!find_collision(shape, other).collided);
+    }
+    list_free(other);
+  }
+  // The boxes overlap, but the triangles don't
+  list_t *other = make_triangle((vector_t){1.5, 0.5});
+  assert(bounding_boxes_overlap(shape, other));
+  assert(!find_collision(shape, other).collided);
+  list_free(other);
+  list_free(shape);
+}
+
 int main(int argc, char *argv[]) {
   // Run all tests if there are no command-line arguments
   bool all_tests = argc == 1;
@@ -11,5 +46,7 @@ int main(int argc, char *argv[]) {
     read_testname(argv[1], testname, sizeof(testname));
   }
 
+  DO_TEST(test_bounding_boxes)
+
   puts("list_test PASS");
 }
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include "collision_events.h"
+#include "forces.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+// A 2x2 square, the same shape the other suites use
+list_t *make_shape() {
+  list_t *shape = list_init(4, free);
+  vector_t *v = malloc(sizeof(*v));
+  *v = (vector_t){-1, -1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){+1, -1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){+1, +1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){-1, +1};
+  list_add(shape, v);
+  return shape;
+}
+
+body_t *make_body(vector_t centroid) {
+  body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  body_set_centroid(body, centroid);
+  return body;
+}
+
+typedef struct {
+  size_t calls;
+  // The tag of the pair whose handler ran last
+  size_t last;
+} record_t;
+
+void record_first(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+  record_t *record = aux;
+  record->calls++;
+  record->last = 1;
+}
+
+void record_second(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+  record_t *record = aux;
+  record->calls++;
+  record->last = 2;
+}
+
+void test_detect() {
+  collision_events_t *events = collision_events_init();
+  body_t *center = make_body(VEC_ZERO);
+  body_t *right = make_body((vector_t){1.5, 0});
+  body_t *far = make_body((vector_t){10, 0});
+  collision_events_add(events, center, far, NULL, NULL, 0, NULL, 7);
+  collision_events_add(events, center, right, NULL, NULL, 0, NULL, 8);
+  assert(collision_events_pairs(events) == 2);
+
+  assert(collision_events_detect(events, NULL) == 1);
+  collision_event_t *event = collision_events_get(events, 0);
+  assert(event->pair == 1);
+  assert(event->body1 == center && event->body2 == right);
+  assert(event->tag == 8);
+  assert(vec_isclose(event->axis, (vector_t){1, 0}));
+  assert(isclose(event->depth, 0.5));
+
+  // No new event while the bodies keep touching
+  assert(collision_events_detect(events, NULL) == 0);
+  body_set_centroid(right, (vector_t){3, 0});
+  assert(collision_events_detect(events, NULL) == 0);
+  // Touching again is a new collision
+  body_set_centroid(right, (vector_t){-1.5, 0});
+  assert(collision_events_detect(events, NULL) == 1);
+  assert(vec_isclose(collision_events_get(events, 0)->axis, (vector_t){-1, 0}));
+
+  collision_events_free(events);
+  body_free(center);
+  body_free(right);
+  body_free(far);
+}
+
+void test_dispatch_order() {
+  collision_events_t *events = collision_events_init();
+  body_t *bodies[3];
+  for (size_t i = 0; i < 3; i++) {
+    bodies[i] = make_body((vector_t){i * 1.5, 0});
+  }
+  record_t record = {0, 0};
+  collision_events_add(events, bodies[0], bodies[1], record_first, &record,
+                       0, NULL, 0);
+  collision_events_add(events, bodies[1], bodies[2], record_second, &record,
+                       0, NULL, 0);
+  assert(collision_events_detect(events, NULL) == 2);
+  // Detection only queues the events
+  assert(record.calls == 0);
+  collision_events_dispatch(events);
+  assert(record.calls == 2);
+  assert(record.last == 2);
+  // Each event is only dispatched once
+  collision_events_dispatch(events);
+  assert(record.calls == 2);
+
+  collision_events_free(events);
+  for (size_t i = 0; i < 3; i++) {
+    body_free(bodies[i]);
+  }
+}
+
+void test_job_pool() {
+  const size_t BODIES = 200;
+  collision_events_t *serial = collision_events_init();
+  collision_events_t *parallel = collision_events_init();
+  body_t *bodies[BODIES];
+  for (size_t i = 0; i < BODIES; i++) {
+    bodies[i] = make_body((vector_t){i * 1.5, (i * 7 % 5) * 0.6});
+  }
+  for (size_t i = 0; i < BODIES; i++) {
+    for (size_t j = i + 1; j < BODIES && j < i + 4; j++) {
+      collision_events_add(serial, bodies[i], bodies[j], NULL, NULL, 0, NULL,
+                           i);
+      collision_events_add(parallel, bodies[i], bodies[j], NULL, NULL, 0, NULL,
+                           i);
+    }
+  }
+  job_pool_t *pool = job_pool_init(4);
+  size_t count = collision_events_detect(serial, NULL);
+  assert(count > 0);
+  assert(collision_events_detect(parallel, pool) == count);
+  for (size_t i = 0; i < count; i++) {
+    collision_event_t *expected = collision_events_get(serial, i);
+    collision_event_t *actual = collision_events_get(parallel, i);
+    assert(expected->pair == actual->pair);
+    assert(vec_equal(expected->axis, actual->axis));
+  }
+  job_pool_free(pool);
+  collision_events_free(serial);
+  collision_events_free(parallel);
+  for (size_t i = 0; i < BODIES; i++) {
+    body_free(bodies[i]);
+  }
+}
+
+void test_remove_dead() {
+  collision_events_t *events = collision_events_init();
+  body_t *bodies[3];
+  for (size_t i = 0; i < 3; i++) {
+    bodies[i] = make_body((vector_t){i * 1.5, 0});
+  }
+  size_t *aux = malloc(sizeof(size_t));
+  collision_events_add(events, bodies[0], bodies[1], NULL, aux, 0, free, 0);
+  collision_events_add(events, bodies[1], bodies[2], NULL, NULL, 0, NULL, 5);
+  body_remove(bodies[0]);
+  // The pair's aux is freed with it
+  assert(collision_events_remove_dead(events) == 1);
+  assert(collision_events_pairs(events) == 1);
+  assert(collision_events_detect(events, NULL) == 1);
+  assert(collision_events_get(events, 0)->tag == 5);
+  collision_events_free(events);
+  for (size_t i = 0; i < 3; i++) {
+    body_free(bodies[i]);
+  }
+}
+
+typedef struct {
+  scene_t *scene;
+  vector_t ball_position;
+  size_t scene_bodies;
+} scene_record_t;
+
+void remember_ball(body_t *ball, body_t *wall, vector_t axis, void *aux) {
+  scene_record_t *record = aux;
+  record->ball_position = body_get_centroid(ball);
+  body_remove(wall);
+  record->scene_bodies = scene_bodies(record->scene);
+}
+
+// Tests that scenes run collision handlers after the bodies move,
+// and still remove the bodies they remove in the same tick
+void test_scene_dispatch() {
+  scene_t *scene = scene_init();
+  body_t *ball = make_body(VEC_ZERO);
+  body_t *wall = make_body((vector_t){1.5, 0});
+  body_set_velocity(ball, (vector_t){1, 0});
+  scene_add_body(scene, ball);
+  scene_add_body(scene, wall);
+  scene_record_t record = {scene, VEC_ZERO, 0};
+  create_collision(scene, ball, wall, remember_ball, &record, NULL);
+  scene_tick(scene, 0.5);
+  assert(vec_isclose(record.ball_position, (vector_t){0.5, 0}));
+  assert(record.scene_bodies == 2);
+  assert(scene_bodies(scene) == 1);
+  assert(collision_events_pairs(scene_get_collision_events(scene)) == 0);
+  scene_free(scene);
+}
+
+// Tests that the tag given to create_tagged_collision() reaches its events
+void test_scene_tags() {
+  scene_t *scene = scene_init();
+  body_t *ball = make_body(VEC_ZERO);
+  body_t *wall = make_body((vector_t){1.5, 0});
+  body_t *far = make_body((vector_t){10, 0});
+  scene_add_body(scene, ball);
+  scene_add_body(scene, wall);
+  scene_add_body(scene, far);
+  create_tagged_collision(scene, ball, far, NULL, NULL, NULL, 3);
+  create_tagged_collision(scene, ball, wall, NULL, NULL, NULL, 42);
+  create_collision(scene, wall, far, NULL, NULL, NULL);
+  scene_tick(scene, 0.5);
+  collision_events_t *events = scene_get_collision_events(scene);
+  assert(collision_events_size(events) == 1);
+  collision_event_t *event = collision_events_get(events, 0);
+  assert(event->tag == 42);
+  assert(event->body1 == ball && event->body2 == wall);
+  scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_detect)
+  DO_TEST(test_dispatch_order)
+  DO_TEST(test_job_pool)
+  DO_TEST(test_remove_dead)
+  DO_TEST(test_scene_dispatch)
+  DO_TEST(test_scene_tags)
+
+  puts("collision_events_test PASS");
+}
@@ -0,0 +1,221 @@
+#include "contact_solver.h"
+#include "forces.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+// A 2x2 square, the same shape the other suites use
+list_t *make_shape() {
+  list_t *shape = list_init(4, free);
+  vector_t *v = malloc(sizeof(*v));
+  *v = (vector_t){-1, -1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){+1, -1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){+1, +1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){-1, +1};
+  list_add(shape, v);
+  return shape;
+}
+
+body_t *make_body(double mass, vector_t centroid) {
+  body_t *body = body_init(make_shape(), mass, (rgb_color_t){0, 0, 0});
+  body_set_centroid(body, centroid);
+  return body;
+}
+
+void test_elastic_bounce() {
+  body_t *ball = make_body(1, VEC_ZERO);
+  body_t *wall = make_body(INFINITY, (vector_t){1.5, 0});
+  body_set_velocity(ball, (vector_t){1, 0});
+  force_batch_t *contacts = force_batch_init(FORCE_PHYSICS_COLLISION, 1);
+  force_batch_add(contacts, 1, ball, wall);
+  contact_solver_t *solver = contact_solver_init(4);
+  assert(contact_solver_get_iterations(solver) == 4);
+
+  assert(contact_solver_solve(solver, contacts, 0) == 1);
+  assert(isclose(force_batch_get_impulse(contacts, 0), 2));
+  body_tick(ball, 0);
+  assert(vec_isclose(body_get_velocity(ball), (vector_t){-1, 0}));
+
+  // While the bodies are still touching but separating,
+  // the warm starting impulse is taken back
+  assert(contact_solver_solve(solver, contacts, 0) == 1);
+  assert(isclose(force_batch_get_impulse(contacts, 0), 0));
+  body_tick(ball, 0);
+  assert(vec_isclose(body_get_velocity(ball), (vector_t){-1, 0}));
+
+  body_set_centroid(ball, (vector_t){-5, 0});
+  assert(contact_solver_solve(solver, contacts, 0) == 0);
+  contact_solver_free(solver);
+  force_batch_free(contacts);
+  body_free(ball);
+  body_free(wall);
+}
+
+// A ball pushed against a wall by another ball should stop,
+// rather than the two contacts undoing each other's impulses
+void test_multiple_contacts() {
+  const size_t ITERATIONS[] = {1, 30};
+  double residual[2];
+  for (size_t i = 0; i < 2; i++) {
+    body_t *ball1 = make_body(1, VEC_ZERO);
+    body_t *ball2 = make_body(1, (vector_t){1.9, 0});
+    body_t *wall = make_body(INFINITY, (vector_t){3.8, 0});
+    body_set_velocity(ball1, (vector_t){1, 0});
+    body_set_velocity(ball2, (vector_t){1, 0});
+    force_batch_t *contacts = force_batch_init(FORCE_PHYSICS_COLLISION, 2);
+    force_batch_add(contacts, 0, ball1, ball2);
+    force_batch_add(contacts, 0, ball2, wall);
+    contact_solver_t *solver = contact_solver_init(ITERATIONS[i]);
+    assert(contact_solver_solve(solver, contacts, 0) == 2);
+    body_tick(ball1, 0);
+    body_tick(ball2, 0);
+    // Perfectly inelastic contacts with a wall bring both balls to rest
+    residual[i] = fmax(body_get_velocity(ball1).x, body_get_velocity(ball2).x);
+    assert(body_get_velocity(ball2).x <= body_get_velocity(ball1).x + 1e-9);
+    contact_solver_free(solver);
+    force_batch_free(contacts);
+    body_free(ball1);
+    body_free(ball2);
+    body_free(wall);
+  }
+  assert(residual[0] > 0.1);
+  assert(residual[1] < 1e-6);
+}
+
+// Returns the largest speed left in a stack of boxes resting on the floor
+// under gravity after several ticks with one solver iteration per tick
+double stack_residual(bool warm_start) {
+  const size_t HEIGHT = 4;
+  const double GRAVITY = 10;
+  const double DT = 1e-2;
+  body_t *floor = make_body(INFINITY, VEC_ZERO);
+  body_t *boxes[HEIGHT];
+  force_batch_t *contacts = force_batch_init(FORCE_PHYSICS_COLLISION, HEIGHT);
+  for (size_t i = 0; i < HEIGHT; i++) {
+    boxes[i] = make_body(1, (vector_t){0, 1.9 * (i + 1)});
+    force_batch_add(contacts, 0, i == 0 ? floor : boxes[i - 1], boxes[i]);
+  }
+  contact_solver_t *solver = contact_solver_init(1);
+  contact_solver_set_warm_start(solver, warm_start);
+  double residual = 0;
+  for (size_t tick = 0; tick < 20; tick++) {
+    for (size_t i = 0; i < HEIGHT; i++) {
+      body_add_force(boxes[i], (vector_t){0, -GRAVITY});
+    }
+    assert(contact_solver_solve(solver, contacts, DT) == HEIGHT);
+    residual = 0;
+    for (size_t i = 0; i < HEIGHT; i++) {
+      body_tick(boxes[i], DT);
+      double speed = fabs(body_get_velocity(boxes[i]).y);
+      residual = fmax(residual, speed);
+      // Only the velocity is of interest, so the boxes are put back
+      body_set_centroid(boxes[i], (vector_t){0, 1.9 * (i + 1)});
+      body_set_velocity(boxes[i], VEC_ZERO);
+    }
+  }
+  contact_solver_free(solver);
+  force_batch_free(contacts);
+  body_free(floor);
+  for (size_t i = 0; i < HEIGHT; i++) {
+    body_free(boxes[i]);
+  }
+  return residual;
+}
+
+void test_warm_start() {
+  double cold = stack_residual(false);
+  double warm = stack_residual(true);
+  // Warm starting carries the solution over from tick to tick,
+  // so one iteration per tick still converges
+  assert(cold > 0.05);
+  assert(warm < cold / 10);
+}
+
+// Solves a grid of overlapping boxes, each touching its neighbors
+void solve_grid(job_pool_t *pool, vector_t *velocities) {
+  const size_t SIDE = 12;
+  body_t *boxes[SIDE * SIDE];
+  force_batch_t *contacts = force_batch_init(FORCE_PHYSICS_COLLISION, 0);
+  for (size_t i = 0; i < SIDE * SIDE; i++) {
+    size_t row = i / SIDE;
+    size_t column = i % SIDE;
+    boxes[i] = make_body(1 + i % 5, (vector_t){1.9 * column, 1.9 * row});
+    body_set_velocity(boxes[i], (vector_t){(i * 7 % 11) - 5.0, 3 - i % 7});
+    if (column > 0) {
+      force_batch_add(contacts, 0.5, boxes[i - 1], boxes[i]);
+    }
+    if (row > 0) {
+      force_batch_add(contacts, 0.5, boxes[i - SIDE], boxes[i]);
+    }
+    // Boxes two columns apart are too far apart to touch
+    if (column > 1) {
+      force_batch_add(contacts, 0.5, boxes[i - 2], boxes[i]);
+    }
+  }
+  contact_solver_t *solver = contact_solver_init(8);
+  contact_solver_set_job_pool(solver, pool);
+  size_t touching = contact_solver_solve(solver, contacts, 1e-2);
+  assert(touching == 2 * SIDE * (SIDE - 1));
+  for (size_t i = 0; i < SIDE * SIDE; i++) {
+    body_tick(boxes[i], 1e-2);
+    velocities[i] = body_get_velocity(boxes[i]);
+    body_free(boxes[i]);
+  }
+  contact_solver_free(solver);
+  force_batch_free(contacts);
+}
+
+// Tests that finding contacts on several threads gives the same solve
+void test_job_pool() {
+  vector_t serial[144];
+  vector_t parallel[144];
+  job_pool_t *pool = job_pool_init(4);
+  solve_grid(NULL, serial);
+  solve_grid(pool, parallel);
+  for (size_t i = 0; i < 144; i++) {
+    assert(serial[i].x == parallel[i].x && serial[i].y == parallel[i].y);
+  }
+  job_pool_free(pool);
+}
+
+// Tests that scenes resolve physics collisions through their contact solver
+void test_scene_contacts() {
+  scene_t *scene = scene_init();
+  assert(contact_solver_get_iterations(scene_get_contact_solver(scene)) > 1);
+  body_t *ball = make_body(2, VEC_ZERO);
+  body_t *wall = make_body(INFINITY, (vector_t){1.5, 0});
+  body_set_velocity(ball, (vector_t){3, 0});
+  scene_add_body(scene, ball);
+  scene_add_body(scene, wall);
+  create_physics_collision(scene, 0.5, ball, wall);
+  scene_tick(scene, 1e-3);
+  assert(vec_isclose(body_get_velocity(ball), (vector_t){-1.5, 0}));
+  scene_tick(scene, 1e-3);
+  assert(vec_isclose(body_get_velocity(ball), (vector_t){-1.5, 0}));
+  scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_elastic_bounce)
+  DO_TEST(test_multiple_contacts)
+  DO_TEST(test_warm_start)
+  DO_TEST(test_job_pool)
+  DO_TEST(test_scene_contacts)
+
+  puts("contact_solver_test PASS");
+}
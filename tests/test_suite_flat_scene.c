@@ -0,0 +1,167 @@
+#include "flat_scene.h"
+#include "forces.h"
+#include "mem_stats.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+list_t *make_shape() {
+  list_t *shape = list_init(4, free);
+  vector_t *v = malloc(sizeof(*v));
+  *v = (vector_t){-1, -1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){+1, -1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){+1, +1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){-1, +1};
+  list_add(shape, v);
+  return shape;
+}
+
+scene_t *make_scene() {
+  scene_t *scene = scene_init();
+  for (int i = 0; i < 5; i++) {
+    body_t *body = body_init(make_shape(), i + 1, (rgb_color_t){0, 0, 0});
+    body_set_centroid(body, (vector_t){10 * i, 0});
+    body_set_velocity(body, (vector_t){0, i});
+    scene_add_body(scene, body);
+  }
+  for (int i = 1; i < 5; i++) {
+    create_spring(scene, 2, scene_get_body(scene, i - 1),
+                  scene_get_body(scene, i));
+  }
+  return scene;
+}
+
+void test_capture() {
+  scene_t *scene = make_scene();
+  flat_scene_t *flat = flat_scene_init();
+  flat_scene_capture(flat, scene);
+  assert(flat_scene_bodies(flat) == 5);
+  for (size_t i = 0; i < 5; i++) {
+    flat_body_t *record = flat_scene_get_body(flat, i);
+    assert(record->vertex_count == 4);
+    assert(record->state.mass == i + 1);
+    assert(vec_equal(record->state.velocity, (vector_t){0, i}));
+    vector_t *vertices = flat_scene_get_vertices(flat, i);
+    assert(vec_isclose(vertices[0], (vector_t){10.0 * i - 1, -1}));
+  }
+  assert(flat_scene_forces(flat) == 4);
+  for (size_t i = 0; i < 4; i++) {
+    assert(flat_scene_get_force(flat, i)->body_count == 2);
+    assert(flat_scene_get_force_body(flat, i, 0) == i);
+    assert(flat_scene_get_force_body(flat, i, 1) == i + 1);
+  }
+  flat_scene_free(flat);
+  scene_free(scene);
+}
+
+void test_clone_restore() {
+  scene_t *scene = make_scene();
+  flat_scene_t *flat = flat_scene_init();
+  flat_scene_capture(flat, scene);
+  flat_scene_t *copy = flat_scene_clone(flat);
+  flat_scene_free(flat);
+
+  vector_t centroids[5];
+  for (size_t i = 0; i < 5; i++) {
+    centroids[i] = body_get_centroid(scene_get_body(scene, i));
+  }
+  for (int i = 0; i < 100; i++) {
+    scene_tick(scene, 0.01);
+  }
+  assert(!vec_isclose(body_get_centroid(scene_get_body(scene, 4)),
+                      centroids[4]));
+
+  flat_scene_restore(copy, scene);
+  for (size_t i = 0; i < 5; i++) {
+    body_t *body = scene_get_body(scene, i);
+    assert(vec_isclose(body_get_centroid(body), centroids[i]));
+    assert(vec_equal(body_get_velocity(body), (vector_t){0, i}));
+  }
+
+  // Re-capturing into an existing flat scene reuses its buffers
+  flat_scene_capture(copy, scene);
+  size_t bytes = flat_scene_memory_size(copy);
+  size_t allocs = mem_alloc_calls();
+  flat_scene_capture(copy, scene);
+  assert(flat_scene_memory_size(copy) == bytes);
+  assert(mem_alloc_calls() == allocs);
+  flat_scene_free(copy);
+  scene_free(scene);
+}
+
+void count_hits(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+  size_t *hits = aux;
+  (*hits)++;
+}
+
+// Tests that collision pairs and force fields are captured, and that
+// restoring a scene makes its collisions start again
+void test_collisions_and_fields() {
+  scene_t *scene = make_scene();
+  body_t *ball = scene_get_body(scene, 0);
+  body_t *wall = scene_get_body(scene, 1);
+  body_set_velocity(ball, (vector_t){40, 0});
+  size_t hits = 0;
+  create_tagged_collision(scene, ball, wall, count_hits, &hits, NULL, 7);
+  scene_add_uniform_field(scene, (vector_t){0, -9.8}, LAYER_ALL);
+  scene_add_global_drag(scene, 0.5, 2);
+
+  flat_scene_t *flat = flat_scene_init();
+  flat_scene_capture(flat, scene);
+  assert(flat_scene_forces(flat) == 5);
+  flat_force_t *record = flat_scene_get_force(flat, 4);
+  assert(record->type == FLAT_COLLISION);
+  assert(record->handler == count_hits);
+  assert(record->aux == &hits);
+  assert(record->tag == 7);
+  assert(!record->touching);
+  assert(flat_scene_get_force_body(flat, 4, 0) == 0);
+  assert(flat_scene_get_force_body(flat, 4, 1) == 1);
+  assert(flat_scene_get_force(flat, 0)->type == FLAT_BATCHED_FORCE);
+  assert(flat_scene_fields(flat) == 2);
+  force_field_t *field = flat_scene_get_field(flat, 0);
+  assert(vec_equal(field->acceleration, (vector_t){0, -9.8}));
+  assert(field->drag == 0 && field->layers == LAYER_ALL);
+  field = flat_scene_get_field(flat, 1);
+  assert(vec_equal(field->acceleration, VEC_ZERO));
+  assert(field->drag == 0.5 && field->layers == 2);
+
+  flat_scene_t *copy = flat_scene_clone(flat);
+  assert(flat_scene_get_force(copy, 4)->tag == 7);
+  assert(flat_scene_fields(copy) == 2);
+  for (int i = 0; i < 30; i++) {
+    scene_tick(scene, 0.01);
+  }
+  assert(hits == 1);
+  flat_scene_restore(copy, scene);
+  for (int i = 0; i < 30; i++) {
+    scene_tick(scene, 0.01);
+  }
+  assert(hits == 2);
+  flat_scene_free(copy);
+  flat_scene_free(flat);
+  scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_capture)
+  DO_TEST(test_clone_restore)
+  DO_TEST(test_collisions_and_fields)
+
+  puts("flat_scene_test PASS");
+}
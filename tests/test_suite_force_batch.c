@@ -0,0 +1,123 @@
+#include "force_batch.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+list_t *make_shape() {
+  list_t *shape = list_init(4, free);
+  vector_t *v = malloc(sizeof(*v));
+  *v = (vector_t){-1, -1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){+1, -1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){+1, +1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){-1, +1};
+  list_add(shape, v);
+  return shape;
+}
+
+body_t *make_body(double mass, vector_t centroid) {
+  body_t *body = body_init(make_shape(), mass, (rgb_color_t){0, 0, 0});
+  body_set_centroid(body, centroid);
+  return body;
+}
+
+void test_drag_batch() {
+  force_batch_t *batch = force_batch_init(FORCE_DRAG, 0);
+  body_t *bodies[3];
+  for (size_t i = 0; i < 3; i++) {
+    bodies[i] = make_body(1, VEC_ZERO);
+    body_set_velocity(bodies[i], (vector_t){i, -1.0 * i});
+    force_batch_add(batch, 2, bodies[i], NULL);
+  }
+  assert(force_batch_size(batch) == 3);
+  assert(force_batch_get_body(batch, 1, 1) == NULL);
+  force_batch_apply(batch);
+  for (size_t i = 0; i < 3; i++) {
+    assert(vec_isclose(body_get_force(bodies[i]), (vector_t){-2.0 * i, 2.0 * i}));
+    body_free(bodies[i]);
+  }
+  force_batch_free(batch);
+}
+
+void test_spring_gravity_batch() {
+  body_t *body1 = make_body(2, VEC_ZERO);
+  body_t *body2 = make_body(3, (vector_t){300, 400});
+  force_batch_t *springs = force_batch_init(FORCE_SPRING, 1);
+  force_batch_add(springs, 0.5, body1, body2);
+  force_batch_apply(springs);
+  assert(vec_isclose(body_get_force(body1), (vector_t){150, 200}));
+  assert(vec_isclose(body_get_force(body2), (vector_t){-150, -200}));
+
+  force_batch_t *gravity = force_batch_init(FORCE_GRAVITY, 1);
+  force_batch_add(gravity, 1e4, body1, body2);
+  force_batch_apply(gravity);
+  // |F| = G m1 m2 / r^2 = 1e4 * 6 / 250000 = 0.24, pulling the bodies together
+  assert(vec_isclose(body_get_force(body1), (vector_t){150.144, 200.192}));
+  assert(vec_isclose(body_get_force(body2), (vector_t){-150.144, -200.192}));
+  force_batch_free(springs);
+  force_batch_free(gravity);
+  body_free(body1);
+  body_free(body2);
+}
+
+void test_physics_collision_batch() {
+  body_t *body1 = make_body(1, VEC_ZERO);
+  body_t *body2 = make_body(INFINITY, (vector_t){1.5, 0});
+  body_set_velocity(body1, (vector_t){1, 0});
+  force_batch_t *batch = force_batch_init(FORCE_PHYSICS_COLLISION, 1);
+  force_batch_add(batch, 1, body1, body2);
+  // Physics collisions are left to the contact solver
+  force_batch_apply(batch);
+  assert(vec_equal(body_get_impulse(body1), VEC_ZERO));
+  assert(force_batch_get_impulse(batch, 0) == 0);
+  force_batch_set_impulse(batch, 0, 2.5);
+  assert(force_batch_get_impulse(batch, 0) == 2.5);
+  force_batch_free(batch);
+  body_free(body1);
+  body_free(body2);
+}
+
+void test_remove_dead() {
+  force_batch_t *batch = force_batch_init(FORCE_PHYSICS_COLLISION, 1);
+  body_t *bodies[4];
+  for (size_t i = 0; i < 4; i++) {
+    bodies[i] = make_body(1, (vector_t){i, 0});
+  }
+  for (size_t i = 1; i < 4; i++) {
+    force_batch_add(batch, i, bodies[i - 1], bodies[i]);
+    force_batch_set_impulse(batch, i - 1, 10 * i);
+  }
+  body_remove(bodies[1]);
+  assert(force_batch_remove_dead(batch) == 2);
+  assert(force_batch_size(batch) == 1);
+  assert(force_batch_get_constant(batch, 0) == 3);
+  assert(force_batch_get_impulse(batch, 0) == 30);
+  assert(force_batch_get_body(batch, 0, 0) == bodies[2]);
+  for (size_t i = 0; i < 4; i++) {
+    body_free(bodies[i]);
+  }
+  force_batch_free(batch);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_drag_batch)
+  DO_TEST(test_spring_gravity_batch)
+  DO_TEST(test_physics_collision_batch)
+  DO_TEST(test_remove_dead)
+
+  puts("force_batch_test PASS");
+}
@@ -0,0 +1,124 @@
+#include "input.h"
+#include "mem_stats.h"
+#include "test_util.h"
+#include <assert.h>
+
+input_event_t make_key(char key, bool pressed, uint32_t timestamp) {
+  return (input_event_t){.kind = INPUT_KEY,
+                         .timestamp = timestamp,
+                         .key = key,
+                         .which = 0,
+                         .pressed = pressed,
+                         .value = 0,
+                         .held_time = 0};
+}
+
+input_event_t make_axis(char axis, int which, int value, uint32_t timestamp) {
+  return (input_event_t){.kind = INPUT_AXIS,
+                         .timestamp = timestamp,
+                         .key = axis,
+                         .which = which,
+                         .pressed = false,
+                         .value = value,
+                         .held_time = timestamp / 1000.0};
+}
+
+void test_order() {
+  size_t bytes = mem_live_bytes(MEM_INPUT);
+  input_buffer_t *buffer = input_buffer_init(4);
+  input_event_t event;
+  assert(!input_buffer_pop(buffer, &event));
+
+  // Wrap around the end of the ring a few times
+  for (uint32_t round = 0; round < 5; round++) {
+    for (uint32_t i = 0; i < 3; i++) {
+      assert(input_buffer_push(buffer, make_key('a' + i, true, i)));
+    }
+    assert(input_buffer_size(buffer) == 3);
+    for (uint32_t i = 0; i < 3; i++) {
+      assert(input_buffer_pop(buffer, &event));
+      assert(event.kind == INPUT_KEY);
+      assert(event.key == 'a' + i);
+      assert(event.timestamp == i);
+      assert(event.pressed);
+    }
+    assert(!input_buffer_pop(buffer, &event));
+  }
+  assert(input_buffer_dropped(buffer) == 0);
+  input_buffer_free(buffer);
+  assert(mem_live_bytes(MEM_INPUT) == bytes);
+}
+
+void test_full() {
+  input_buffer_t *buffer = input_buffer_init(2);
+  assert(input_buffer_push(buffer, make_key('a', true, 1)));
+  assert(input_buffer_push(buffer, make_key('a', false, 2)));
+  assert(!input_buffer_push(buffer, make_key('b', true, 3)));
+  assert(input_buffer_dropped(buffer) == 1);
+  assert(input_buffer_size(buffer) == 2);
+
+  // A full buffer can still take the latest position of a queued axis
+  input_event_t event;
+  assert(input_buffer_pop(buffer, &event));
+  assert(input_buffer_push(buffer, make_axis(1, 0, 100, 4)));
+  assert(input_buffer_push(buffer, make_axis(1, 0, 200, 5)));
+  assert(input_buffer_dropped(buffer) == 1);
+  assert(input_buffer_pop(buffer, &event));
+  assert(event.key == 'a' && !event.pressed);
+  assert(input_buffer_pop(buffer, &event));
+  assert(event.value == 200);
+  input_buffer_free(buffer);
+}
+
+void test_coalesce_axes() {
+  input_buffer_t *buffer = input_buffer_init(16);
+  input_buffer_push(buffer, make_axis(1, 0, -10, 1));
+  input_buffer_push(buffer, make_key('w', true, 2));
+  // Another axis, and the same axis on another controller
+  input_buffer_push(buffer, make_axis(2, 0, 5, 3));
+  input_buffer_push(buffer, make_axis(1, 1, 7, 4));
+  for (int i = 0; i < 50; i++) {
+    input_buffer_push(buffer, make_axis(1, 0, i, 10 + i));
+  }
+  assert(input_buffer_size(buffer) == 4);
+
+  // The coalesced axis keeps its place but has the latest value
+  input_event_t event;
+  input_buffer_pop(buffer, &event);
+  assert(event.kind == INPUT_AXIS && event.key == 1 && event.which == 0);
+  assert(event.value == 49);
+  assert(event.timestamp == 59);
+  assert(isclose(event.held_time, 0.059));
+  input_buffer_pop(buffer, &event);
+  assert(event.kind == INPUT_KEY && event.key == 'w');
+  input_buffer_pop(buffer, &event);
+  assert(event.key == 2 && event.value == 5);
+  input_buffer_pop(buffer, &event);
+  assert(event.key == 1 && event.which == 1 && event.value == 7);
+
+  // Once drained, the axis is queued again as a new event
+  input_buffer_push(buffer, make_key('w', false, 60));
+  input_buffer_push(buffer, make_axis(1, 0, 0, 61));
+  assert(input_buffer_size(buffer) == 2);
+  input_buffer_pop(buffer, &event);
+  assert(event.kind == INPUT_KEY && !event.pressed);
+  input_buffer_pop(buffer, &event);
+  assert(event.kind == INPUT_AXIS && event.value == 0);
+  input_buffer_free(buffer);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_order)
+  DO_TEST(test_full)
+  DO_TEST(test_coalesce_axes)
+
+  puts("input_test PASS");
+}
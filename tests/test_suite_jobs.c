@@ -0,0 +1,148 @@
+#include "jobs.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+typedef struct counts {
+  atomic_size_t calls;
+  size_t *hits;
+} counts_t;
+
+void count_item(void *aux, size_t index) {
+  counts_t *counts = aux;
+  atomic_fetch_add(&counts->calls, 1);
+  // Each index is run exactly once, so no two threads write the same hit
+  counts->hits[index]++;
+}
+
+void check_loops(size_t threads) {
+  const size_t ITEMS = 1000;
+  job_pool_t *pool = job_pool_init(threads);
+  assert(job_pool_threads(pool) == threads);
+  counts_t counts;
+  counts.hits = calloc(ITEMS, sizeof(size_t));
+  // Run many loops to catch workers missing or repeating a loop
+  for (size_t loop = 0; loop < 200; loop++) {
+    size_t items = loop % 7 == 0 ? loop % 3 : ITEMS;
+    atomic_init(&counts.calls, 0);
+    job_pool_parallel_for(pool, items, count_item, &counts);
+    assert(atomic_load(&counts.calls) == items);
+  }
+  for (size_t i = 0; i < ITEMS; i++) {
+    assert(counts.hits[i] > 0);
+  }
+  free(counts.hits);
+  job_pool_free(pool);
+}
+
+typedef struct sum_job {
+  job_pool_t *pool;
+  size_t start;
+  size_t end;
+  size_t sum;
+} sum_job_t;
+
+// Sums a range of integers by forking each half into its own task
+void sum_range(void *aux) {
+  sum_job_t *job = aux;
+  if (job->end - job->start <= 8) {
+    job->sum = 0;
+    for (size_t i = job->start; i < job->end; i++) {
+      job->sum += i;
+    }
+    return;
+  }
+  size_t middle = (job->start + job->end) / 2;
+  sum_job_t lower = {job->pool, job->start, middle, 0};
+  sum_job_t upper = {job->pool, middle, job->end, 0};
+  job_join_t join;
+  job_join_init(&join);
+  job_pool_spawn(job->pool, &join, sum_range, &lower);
+  job_pool_spawn(job->pool, &join, sum_range, &upper);
+  job_pool_join(job->pool, &join);
+  job->sum = lower.sum + upper.sum;
+}
+
+void check_fork_join(size_t threads) {
+  const size_t N = 100000;
+  job_pool_t *pool = job_pool_init(threads);
+  for (size_t round = 0; round < 20; round++) {
+    sum_job_t job = {pool, 0, N, 0};
+    sum_range(&job);
+    assert(job.sum == N * (N - 1) / 2);
+  }
+  job_pool_free(pool);
+}
+
+typedef struct nested {
+  job_pool_t *pool;
+  counts_t *inner;
+} nested_t;
+
+void run_inner_loop(void *aux, size_t index) {
+  nested_t *nested = aux;
+  job_pool_parallel_for(nested->pool, 10, count_item,
+                        &nested->inner[index]);
+}
+
+void test_serial() {
+  check_loops(1);
+  check_fork_join(1);
+}
+
+void test_parallel() {
+  check_loops(2);
+  check_loops(4);
+  check_loops(9);
+}
+
+void test_fork_join() {
+  check_fork_join(2);
+  check_fork_join(4);
+  check_fork_join(9);
+}
+
+// Tests that loops can run inside the items of another loop
+void test_nested_loops() {
+  const size_t OUTER = 50;
+  job_pool_t *pool = job_pool_init(4);
+  counts_t inner[OUTER];
+  for (size_t i = 0; i < OUTER; i++) {
+    atomic_init(&inner[i].calls, 0);
+    inner[i].hits = calloc(10, sizeof(size_t));
+  }
+  nested_t nested = {pool, inner};
+  job_pool_parallel_for(pool, OUTER, run_inner_loop, &nested);
+  for (size_t i = 0; i < OUTER; i++) {
+    assert(atomic_load(&inner[i].calls) == 10);
+    for (size_t j = 0; j < 10; j++) {
+      assert(inner[i].hits[j] == 1);
+    }
+    free(inner[i].hits);
+  }
+  job_pool_free(pool);
+}
+
+void test_idle_pool() {
+  // A pool can be freed without ever running a loop
+  job_pool_free(job_pool_init(4));
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_serial)
+  DO_TEST(test_parallel)
+  DO_TEST(test_fork_join)
+  DO_TEST(test_nested_loops)
+  DO_TEST(test_idle_pool)
+
+  puts("jobs_test PASS");
+}
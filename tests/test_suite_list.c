@@ -91,6 +91,75 @@ void test_list_large_get_set() {
   list_free(pl);
 }
 
+void get_out_of_bounds(void *list) { list_get(list, list_size(list)); }
+
+void test_list_out_of_bounds() {
+  list_t *l = list_init(4, (free_func_t)vec_list_free);
+  assert(test_assert_fail(get_out_of_bounds, l));
+  list_add(l, create_vec_list(1, 0, 0));
+  assert(test_assert_fail(get_out_of_bounds, l));
+  list_free(l);
+}
+
+void test_list_reserve_extend() {
+  list_t *l1 = list_init(0, NULL);
+  list_t *l2 = list_init(1, NULL);
+  int values[10];
+  list_reserve(l1, 10);
+  for (size_t i = 0; i < 5; i++) {
+    list_add(l1, &values[i]);
+  }
+  for (size_t i = 5; i < 10; i++) {
+    list_add(l2, &values[i]);
+  }
+  list_extend(l1, l2);
+  assert(list_size(l1) == 10);
+  assert(list_size(l2) == 5);
+  for (size_t i = 0; i < 10; i++) {
+    assert(list_get(l1, i) == &values[i]);
+  }
+  list_shrink_to_fit(l1);
+  assert(list_size(l1) == 10);
+  list_add(l1, &values[0]);
+  assert(list_get(l1, 10) == &values[0]);
+  list_free(l1);
+  list_free(l2);
+}
+
+void test_list_swap_remove() {
+  list_t *l = list_init(4, NULL);
+  int values[4];
+  for (size_t i = 0; i < 4; i++) {
+    list_add(l, &values[i]);
+  }
+  assert(list_swap_remove(l, 1) == &values[1]);
+  assert(list_size(l) == 3);
+  assert(list_get(l, 0) == &values[0]);
+  assert(list_get(l, 1) == &values[3]);
+  assert(list_get(l, 2) == &values[2]);
+  assert(list_swap_remove(l, 2) == &values[2]);
+  assert(list_size(l) == 2);
+  list_free(l);
+}
+
+bool is_odd(int *value, void *aux) { return *value % 2 == 1; }
+
+void test_list_erase_if() {
+  list_t *l = list_init(LARGE_SIZE, free);
+  for (int i = 0; i < LARGE_SIZE; i++) {
+    int *value = malloc(sizeof(*value));
+    *value = i;
+    list_add(l, value);
+  }
+  assert(list_erase_if(l, (list_pred_t)is_odd, NULL) == LARGE_SIZE / 2);
+  assert(list_size(l) == LARGE_SIZE / 2);
+  for (size_t i = 0; i < list_size(l); i++) {
+    assert(*(int *)list_get(l, i) == 2 * i);
+  }
+  assert(list_erase_if(l, (list_pred_t)is_odd, NULL) == 0);
+  list_free(l);
+}
+
 int main(int argc, char *argv[]) {
   // Run all tests if there are no command-line arguments
   bool all_tests = argc == 1;
@@ -103,6 +172,10 @@ int main(int argc, char *argv[]) {
   DO_TEST(test_list_size0)
   DO_TEST(test_list_size1)
   DO_TEST(test_list_large_get_set)
+  DO_TEST(test_list_out_of_bounds)
+  DO_TEST(test_list_reserve_extend)
+  DO_TEST(test_list_swap_remove)
+  DO_TEST(test_list_erase_if)
 
   puts("list_test PASS");
 }
\ No newline at end of file
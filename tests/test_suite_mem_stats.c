@@ -0,0 +1,138 @@
+#include "jobs.h"
+#include "mem_stats.h"
+#include "poly_list.h"
+#include "scene.h"
+#include "test_util.h"
+#include "vec_list.h"
+#include <assert.h>
+#include <stdlib.h>
+
+void test_counters() {
+  size_t calls = mem_alloc_calls();
+  size_t bytes = mem_live_bytes(MEM_AUX);
+  size_t count = mem_live_count(MEM_AUX);
+  void *ptr = mem_alloc(MEM_AUX, 16);
+  assert(mem_alloc_calls() == calls + 1);
+  assert(mem_live_bytes(MEM_AUX) == bytes + 16);
+  assert(mem_live_count(MEM_AUX) == count + 1);
+  ptr = mem_realloc(MEM_AUX, ptr, 16, 48);
+  assert(mem_alloc_calls() == calls + 2);
+  assert(mem_live_bytes(MEM_AUX) == bytes + 48);
+  assert(mem_live_count(MEM_AUX) == count + 1);
+  mem_free(MEM_AUX, ptr, 48);
+  assert(mem_live_bytes(MEM_AUX) == bytes);
+  assert(mem_live_count(MEM_AUX) == count);
+}
+
+void test_realloc_to_zero() {
+  size_t bytes = mem_live_bytes(MEM_AUX);
+  size_t count = mem_live_count(MEM_AUX);
+  void *ptr = mem_alloc(MEM_AUX, 16);
+  assert(mem_realloc(MEM_AUX, ptr, 16, 0) == NULL);
+  assert(mem_live_bytes(MEM_AUX) == bytes);
+  assert(mem_live_count(MEM_AUX) == count);
+}
+
+void alloc_task(void *aux) { mem_free(MEM_AUX, mem_alloc(MEM_AUX, 8), 8); }
+
+void test_call_counter() {
+  job_pool_t *pool = job_pool_init(4);
+  atomic_size_t calls;
+  atomic_init(&calls, 0);
+  assert(mem_count_calls(&calls) == NULL);
+  assert(mem_call_counter() == &calls);
+  void *ptr = mem_alloc(MEM_AUX, 16);
+  ptr = mem_realloc(MEM_AUX, ptr, 16, 32);
+  mem_free(MEM_AUX, ptr, 32);
+  assert(calls == 2);
+
+  // Tasks are charged to the thread that spawned them
+  job_join_t join;
+  job_join_init(&join);
+  for (size_t i = 0; i < 50; i++) {
+    job_pool_spawn(pool, &join, alloc_task, NULL);
+  }
+  job_pool_join(pool, &join);
+  assert(calls == 52);
+  assert(mem_count_calls(NULL) == &calls);
+  mem_free(MEM_AUX, mem_alloc(MEM_AUX, 8), 8);
+  assert(calls == 52);
+  job_pool_free(pool);
+}
+
+void test_list_accounting() {
+  size_t bytes = mem_live_bytes(MEM_LIST);
+  list_t *list = list_init(2, NULL);
+  assert(mem_live_bytes(MEM_LIST) == bytes + list_memory_size(list));
+  int value;
+  for (size_t i = 0; i < 100; i++) {
+    list_add(list, &value);
+  }
+  assert(mem_live_bytes(MEM_LIST) == bytes + list_memory_size(list));
+  list_shrink_to_fit(list);
+  assert(mem_live_bytes(MEM_LIST) == bytes + list_memory_size(list));
+  list_free(list);
+  assert(mem_live_bytes(MEM_LIST) == bytes);
+}
+
+void test_empty_list_accounting() {
+  size_t bytes = mem_live_bytes(MEM_LIST);
+  size_t count = mem_live_count(MEM_LIST);
+  list_t *list = list_init(0, NULL);
+  int value;
+  list_add(list, &value);
+  assert(mem_live_bytes(MEM_LIST) == bytes + list_memory_size(list));
+  list_free(list);
+  assert(mem_live_bytes(MEM_LIST) == bytes);
+  assert(mem_live_count(MEM_LIST) == count);
+}
+
+void test_array_free_accounting() {
+  size_t bytes = mem_live_bytes(MEM_LIST);
+  size_t count = mem_live_count(MEM_LIST);
+  poly_list_t *polys = poly_list_init(0);
+  vec_list_t *vecs = vec_list_init(1);
+  poly_list_add(polys, vecs);
+  vec_list_array_free(vecs);
+  poly_list_array_free(polys);
+  assert(mem_live_bytes(MEM_LIST) == bytes);
+  assert(mem_live_count(MEM_LIST) == count);
+}
+
+void test_vertex_accounting() {
+  size_t count = mem_live_count(MEM_VERTEX);
+  list_t *shape = list_init(3, free);
+  for (size_t i = 0; i < 3; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t){i, i * i};
+    list_add(shape, v);
+  }
+  body_t *body = body_init(shape, 1, (rgb_color_t){0, 0, 0});
+  // The body's own shape was allocated by the caller; copies are tracked
+  assert(mem_live_count(MEM_VERTEX) == count);
+  list_t *copy = body_get_shape(body);
+  assert(mem_live_count(MEM_VERTEX) == count + 3);
+  list_free(copy);
+  assert(mem_live_count(MEM_VERTEX) == count);
+  body_free(body);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_counters)
+  DO_TEST(test_realloc_to_zero)
+  DO_TEST(test_call_counter)
+  DO_TEST(test_list_accounting)
+  DO_TEST(test_empty_list_accounting)
+  DO_TEST(test_array_free_accounting)
+  DO_TEST(test_vertex_accounting)
+
+  puts("mem_stats_test PASS");
+}
@@ -0,0 +1,174 @@
+#include "forces.h"
+#include "nbody.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+list_t *make_shape() {
+  list_t *shape = list_init(4, free);
+  vector_t *v = malloc(sizeof(*v));
+  *v = (vector_t){-1, -1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){+1, -1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){+1, +1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){-1, +1};
+  list_add(shape, v);
+  return shape;
+}
+
+scene_t *make_cluster(size_t count) {
+  scene_t *scene = scene_init();
+  srand(42);
+  for (size_t i = 0; i < count; i++) {
+    double mass = 1 + rand() % 10;
+    body_t *body = body_init(make_shape(), mass, (rgb_color_t){0, 0, 0});
+    body_set_centroid(body,
+                      (vector_t){rand() % 100000 / 10.0, rand() % 50000 / 10.0});
+    scene_add_body(scene, body);
+  }
+  return scene;
+}
+
+// Returns the total force error relative to the total exact force
+double relative_error(scene_t *approximate, scene_t *exact) {
+  double error = 0;
+  double total = 0;
+  for (size_t i = 0; i < scene_bodies(exact); i++) {
+    vector_t force = body_get_force(scene_get_body(exact, i));
+    vector_t diff = vec_subtract(body_get_force(scene_get_body(approximate, i)),
+                                 force);
+    error += sqrt(vec_dot(diff, diff));
+    total += sqrt(vec_dot(force, force));
+  }
+  return error / total;
+}
+
+void test_matches_brute_force() {
+  const size_t COUNT = 500;
+  scene_t *exact = make_cluster(COUNT);
+  nbody_t *brute_force = nbody_init(10, 0);
+  nbody_apply_brute_force(brute_force, exact);
+
+  // With an opening angle of 0 the tree computes every pair exactly
+  scene_t *tree = make_cluster(COUNT);
+  nbody_t *nbody = nbody_init(10, 0);
+  nbody_apply(nbody, tree);
+  assert(nbody_tree_size(nbody) > COUNT);
+  assert(relative_error(tree, exact) < 1e-9);
+  nbody_free(nbody);
+  scene_free(tree);
+
+  double previous_error = 0;
+  // Larger opening angles approximate more, so they are less accurate
+  double thetas[] = {0.3, 0.5, 1.0};
+  double max_errors[] = {0.005, 0.02, 0.1};
+  for (size_t i = 0; i < sizeof(thetas) / sizeof(thetas[0]); i++) {
+    scene_t *approximate = make_cluster(COUNT);
+    nbody = nbody_init(10, thetas[i]);
+    nbody_apply(nbody, approximate);
+    double error = relative_error(approximate, exact);
+    assert(error < max_errors[i]);
+    assert(error >= previous_error);
+    previous_error = error;
+    nbody_free(nbody);
+    scene_free(approximate);
+  }
+  nbody_free(brute_force);
+  scene_free(exact);
+}
+
+void test_coincident_bodies() {
+  scene_t *scene = scene_init();
+  for (size_t i = 0; i < 10; i++) {
+    body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+    body_set_centroid(body, (vector_t){5, 5});
+    scene_add_body(scene, body);
+  }
+  body_t *far = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  body_set_centroid(far, (vector_t){1005, 5});
+  scene_add_body(scene, far);
+  nbody_t *nbody = nbody_init(1e6, 0.5);
+  nbody_apply(nbody, scene);
+  // Each body is pulled only by the bodies at least MIN_GRAVITY_DISTANCE away
+  assert(vec_isclose(body_get_force(far), (vector_t){-10, 0}));
+  for (size_t i = 0; i < 10; i++) {
+    assert(vec_isclose(body_get_force(scene_get_body(scene, i)),
+                       (vector_t){1, 0}));
+  }
+  nbody_free(nbody);
+  scene_free(scene);
+}
+
+void test_ignores_infinite_mass() {
+  scene_t *scene = scene_init();
+  body_t *wall = body_init(make_shape(), INFINITY, (rgb_color_t){0, 0, 0});
+  scene_add_body(scene, wall);
+  body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  body_set_centroid(body, (vector_t){1000, 0});
+  scene_add_body(scene, body);
+  nbody_t *nbody = nbody_init(1, 0.5);
+  nbody_apply(nbody, scene);
+  assert(vec_equal(body_get_force(wall), VEC_ZERO));
+  assert(vec_equal(body_get_force(body), VEC_ZERO));
+  nbody_free(nbody);
+  scene_free(scene);
+}
+
+// Tests that create_nbody_gravity() matches create_newtonian_gravity()
+void test_create_nbody_gravity() {
+  const double G = 1e3;
+  const double DT = 1e-3;
+  const int STEPS = 1000;
+  scene_t *pairwise = scene_init();
+  scene_t *field = scene_init();
+  vector_t positions[] = {{0, 0}, {300, 0}, {0, 400}};
+  double masses[] = {10, 20, 30};
+  for (size_t i = 0; i < 3; i++) {
+    body_t *body = body_init(make_shape(), masses[i], (rgb_color_t){0, 0, 0});
+    body_set_centroid(body, positions[i]);
+    scene_add_body(pairwise, body);
+    body = body_init(make_shape(), masses[i], (rgb_color_t){0, 0, 0});
+    body_set_centroid(body, positions[i]);
+    scene_add_body(field, body);
+  }
+  for (size_t i = 0; i < 3; i++) {
+    for (size_t j = i + 1; j < 3; j++) {
+      create_newtonian_gravity(pairwise, G, scene_get_body(pairwise, i),
+                               scene_get_body(pairwise, j));
+    }
+  }
+  create_nbody_gravity(field, G, 0.5);
+  for (int i = 0; i < STEPS; i++) {
+    scene_tick(pairwise, DT);
+    scene_tick(field, DT);
+    for (size_t j = 0; j < 3; j++) {
+      assert(vec_isclose(body_get_centroid(scene_get_body(pairwise, j)),
+                         body_get_centroid(scene_get_body(field, j))));
+    }
+  }
+  scene_free(pairwise);
+  scene_free(field);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_matches_brute_force)
+  DO_TEST(test_coincident_bodies)
+  DO_TEST(test_ignores_infinite_mass)
+  DO_TEST(test_create_nbody_gravity)
+
+  puts("nbody_test PASS");
+}
@@ -221,6 +221,66 @@ void test_weird_rotate() {
   vec_list_free(w);
 }
 
+// Checks that the triangles cover the polygon exactly once
+void check_triangulation(vec_list_t *polygon) {
+  size_t size = vec_list_size(polygon);
+  size_t *indices = malloc(3 * (size - 2) * sizeof(size_t));
+  size_t *scratch = malloc(size * sizeof(size_t));
+  size_t triangles = polygon_triangulate((list_t *)polygon, indices, scratch);
+  assert(triangles == size - 2);
+
+  double signed_area = 0;
+  for (size_t i = 0; i < size; i++) {
+    signed_area += vec_cross(*vec_list_get(polygon, i),
+                             *vec_list_get(polygon, (i + 1) % size));
+  }
+  double area = 0;
+  for (size_t i = 0; i < triangles; i++) {
+    vector_t a = *vec_list_get(polygon, indices[3 * i]);
+    vector_t b = *vec_list_get(polygon, indices[3 * i + 1]);
+    vector_t c = *vec_list_get(polygon, indices[3 * i + 2]);
+    double triangle_area = vec_cross(vec_subtract(b, a), vec_subtract(c, a));
+    // Each triangle keeps the polygon's direction
+    assert(triangle_area * signed_area > 0);
+    area += fabs(triangle_area) / 2;
+  }
+  assert(isclose(area, polygon_area((list_t *)polygon)));
+  free(indices);
+  free(scratch);
+}
+
+void test_triangulate() {
+  vec_list_t *sq = make_square();
+  check_triangulation(sq);
+  // Clockwise
+  vector_t swap = *vec_list_get(sq, 1);
+  *vec_list_get(sq, 1) = *vec_list_get(sq, 3);
+  *vec_list_get(sq, 3) = swap;
+  check_triangulation(sq);
+  vec_list_free(sq);
+
+  vec_list_t *w = make_weird();
+  check_triangulation(w);
+  vec_list_free(w);
+
+  // Convex, so it is split into a fan
+  vec_list_t *circ = make_big_circ();
+  check_triangulation(circ);
+  vec_list_free(circ);
+
+  // A 5-pointed star, which a fan from any vertex would spill out of
+  vec_list_t *star = vec_list_init(10);
+  for (size_t i = 0; i < 10; i++) {
+    double radius = i % 2 == 0 ? 2 : 0.5;
+    double angle = M_PI * i / 5;
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t){radius * cos(angle), radius * sin(angle)};
+    vec_list_add(star, v);
+  }
+  check_triangulation(star);
+  vec_list_free(star);
+}
+
 int main(int argc, char *argv[]) {
   // Run all tests? True if there are no command-line arguments
   bool all_tests = argc == 1;
@@ -242,6 +302,7 @@ int main(int argc, char *argv[]) {
   DO_TEST(test_weird_area_centroid)
   DO_TEST(test_weird_translate)
   DO_TEST(test_weird_rotate)
+  DO_TEST(test_triangulate)
 
   puts("polygon_test PASS");
 }
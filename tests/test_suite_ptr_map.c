@@ -0,0 +1,79 @@
+#include "mem_stats.h"
+#include "ptr_map.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+void test_put_get() {
+  ptr_map_t *map = ptr_map_init(MEM_AUX, 0);
+  int keys[3];
+  assert(ptr_map_get(map, &keys[0], 7) == 7);
+  assert(ptr_map_get(map, NULL, 7) == 7);
+  ptr_map_put(map, &keys[0], 10);
+  ptr_map_put(map, &keys[1], 11);
+  assert(ptr_map_size(map) == 2);
+  assert(ptr_map_get(map, &keys[0], 7) == 10);
+  assert(ptr_map_get(map, &keys[1], 7) == 11);
+  assert(ptr_map_get(map, &keys[2], 7) == 7);
+  // Putting an existing key replaces its value
+  ptr_map_put(map, &keys[0], 20);
+  assert(ptr_map_size(map) == 2);
+  assert(ptr_map_get(map, &keys[0], 7) == 20);
+  ptr_map_free(map);
+}
+
+void test_growth() {
+  const size_t KEYS = 10000;
+  size_t bytes = mem_live_bytes(MEM_AUX);
+  ptr_map_t *map = ptr_map_init(MEM_AUX, 4);
+  char *keys = malloc(KEYS);
+  for (size_t i = 0; i < KEYS; i++) {
+    ptr_map_put(map, &keys[i], i * 3);
+  }
+  assert(ptr_map_size(map) == KEYS);
+  for (size_t i = 0; i < KEYS; i++) {
+    assert(ptr_map_get(map, &keys[i], KEYS) == i * 3);
+  }
+  assert(mem_live_bytes(MEM_AUX) == bytes + ptr_map_memory_size(map));
+  ptr_map_free(map);
+  assert(mem_live_bytes(MEM_AUX) == bytes);
+  free(keys);
+}
+
+void test_clear() {
+  const size_t KEYS = 100;
+  ptr_map_t *map = ptr_map_init(MEM_AUX, KEYS);
+  size_t memory = ptr_map_memory_size(map);
+  int *keys = malloc(KEYS * sizeof(int));
+  for (size_t round = 0; round < 3; round++) {
+    ptr_map_clear(map, KEYS);
+    assert(ptr_map_size(map) == 0);
+    assert(ptr_map_get(map, &keys[0], KEYS) == KEYS);
+    for (size_t i = 0; i < KEYS; i++) {
+      ptr_map_put(map, &keys[i], i + round);
+    }
+    for (size_t i = 0; i < KEYS; i++) {
+      assert(ptr_map_get(map, &keys[i], KEYS) == i + round);
+    }
+  }
+  // Refilling a cleared map does not allocate
+  assert(ptr_map_memory_size(map) == memory);
+  ptr_map_free(map);
+  free(keys);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_put_get)
+  DO_TEST(test_growth)
+  DO_TEST(test_clear)
+
+  puts("ptr_map_test PASS");
+}
@@ -0,0 +1,144 @@
+#include "raster.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+list_t *make_rectangle(double x0, double y0, double x1, double y1) {
+  list_t *shape = list_init(4, free);
+  vector_t corners[] = {{x0, y0}, {x1, y0}, {x1, y1}, {x0, y1}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = corners[i];
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+// Counts the pixels of exactly the given color
+size_t count_pixels(raster_t *raster, uint8_t r, uint8_t g, uint8_t b) {
+  const uint8_t *pixels = raster_pixels(raster);
+  size_t count = 0;
+  for (size_t i = 0; i < raster_width(raster) * raster_height(raster); i++) {
+    const uint8_t *pixel = &pixels[4 * i];
+    if (pixel[0] == r && pixel[1] == g && pixel[2] == b) {
+      assert(pixel[3] == 255);
+      count++;
+    }
+  }
+  return count;
+}
+
+// Checks whether the pixel at (x, y), counted from the top left, is white
+bool is_white(raster_t *raster, size_t x, size_t y) {
+  size_t index = y * raster_width(raster) + x;
+  const uint8_t *pixel = &raster_pixels(raster)[4 * index];
+  return pixel[0] == 255 && pixel[1] == 255 && pixel[2] == 255;
+}
+
+void test_init() {
+  raster_t *raster = raster_init((vector_t){0, 0}, (vector_t){8, 4}, 16, 8);
+  assert(raster_width(raster) == 16);
+  assert(raster_height(raster) == 8);
+  assert(count_pixels(raster, 255, 255, 255) == 16 * 8);
+  raster_free(raster);
+}
+
+void test_draw_polygon() {
+  raster_t *raster = raster_init((vector_t){0, 0}, (vector_t){8, 8}, 8, 8);
+  list_t *square = make_rectangle(0, 0, 4, 4);
+  raster_draw_polygon(raster, square, (rgb_color_t){1, 0, 0});
+  // The square's diagonal passes through pixel centers, but the two
+  // triangles on either side of it cover each pixel once between them
+  assert(count_pixels(raster, 255, 0, 0) == 16);
+  // Positive y is up in the scene but down in the image
+  assert(!is_white(raster, 0, 7));
+  assert(!is_white(raster, 3, 4));
+  assert(is_white(raster, 4, 4));
+  assert(is_white(raster, 3, 3));
+  list_free(square);
+
+  // Pixels are only covered where their centers are
+  list_t *thin = make_rectangle(5.6, 0, 6.4, 8);
+  raster_draw_polygon(raster, thin, (rgb_color_t){0, 0, 1});
+  assert(count_pixels(raster, 0, 0, 255) == 0);
+  list_free(thin);
+  list_t *column = make_rectangle(5.4, 0, 5.6, 8);
+  raster_draw_polygon(raster, column, (rgb_color_t){0, 0, 1});
+  assert(count_pixels(raster, 0, 0, 255) == 8);
+  list_free(column);
+
+  // Polygons off the image are clipped
+  list_t *outside = make_rectangle(-4, -4, 12, 1);
+  raster_draw_polygon(raster, outside, (rgb_color_t){0, 1, 0});
+  assert(count_pixels(raster, 0, 255, 0) == 8);
+  list_free(outside);
+
+  raster_clear(raster);
+  assert(count_pixels(raster, 255, 255, 255) == 64);
+  raster_free(raster);
+}
+
+scene_t *make_scene(double offset) {
+  scene_t *scene = scene_init();
+  for (size_t i = 0; i < 3; i++) {
+    body_t *body = body_init(make_rectangle(0, 0, 10, 5), 1,
+                             (rgb_color_t){0, 0.5, i / 2.0});
+    body_set_centroid(body, (vector_t){20 + 25 * i + offset, 50});
+    body_set_rotation(body, i * 0.3);
+    scene_add_body(scene, body);
+  }
+  return scene;
+}
+
+void test_render_scene() {
+  raster_t *raster =
+      raster_init((vector_t){0, 0}, (vector_t){100, 100}, 200, 200);
+  scene_t *scene = make_scene(0);
+  raster_render_scene(raster, scene);
+  uint64_t hash = raster_hash(raster);
+  // Each body covers close to its area of 50 units, or 200 pixels
+  for (size_t i = 0; i < 3; i++) {
+    size_t count = count_pixels(raster, 0, 127, i * 127.5);
+    assert(190 <= count && count <= 210);
+  }
+
+  // Rendering is deterministic
+  raster_render_scene(raster, scene);
+  assert(raster_hash(raster) == hash);
+  scene_t *same = make_scene(0);
+  raster_render_scene(raster, same);
+  assert(raster_hash(raster) == hash);
+  scene_free(same);
+
+  // Moving a body changes the frame
+  scene_t *moved = make_scene(1);
+  raster_render_scene(raster, moved);
+  assert(raster_hash(raster) != hash);
+  scene_free(moved);
+
+  // So does the image's size
+  raster_t *other =
+      raster_init((vector_t){0, 0}, (vector_t){100, 100}, 100, 100);
+  raster_render_scene(other, scene);
+  assert(raster_hash(other) != hash);
+  raster_free(other);
+
+  scene_free(scene);
+  raster_free(raster);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_init)
+  DO_TEST(test_draw_polygon)
+  DO_TEST(test_render_scene)
+
+  puts("raster_test PASS");
+}
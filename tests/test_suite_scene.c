@@ -1,3 +1,5 @@
+#include "forces.h"
+#include "mem_stats.h"
 #include "scene.h"
 #include "test_util.h"
 #include <assert.h>
@@ -228,6 +230,292 @@ void test_reaping() {
   scene_free(scene);
 }
 
+void no_force(void *aux) {}
+
+void free_aux24(void *aux) { mem_free(MEM_AUX, aux, 24); }
+
+void test_memory_stats() {
+  scene_t *scene = scene_init();
+  scene_memory_stats_t stats = scene_memory_stats(scene);
+  assert(stats.body_count == 0);
+  assert(stats.vertex_count == 0);
+  assert(stats.force_count == 0);
+  for (int i = 0; i < 3; i++) {
+    scene_add_body(scene, body_init(make_shape(), 1, (rgb_color_t){0, 0, 0}));
+  }
+  list_t *bodies = list_init(2, NULL);
+  list_add(bodies, scene_get_body(scene, 0));
+  list_add(bodies, scene_get_body(scene, 1));
+  count_aux_t *count_aux = malloc(sizeof(*count_aux));
+  count_aux->count = 0;
+  count_aux->scene = scene;
+  scene_add_bodies_force_creator(scene, no_force, count_aux, bodies, free);
+  scene_add_force_creator(scene, remove_body, scene, NULL);
+
+  stats = scene_memory_stats(scene);
+  assert(stats.body_count == 3);
+  assert(stats.vertex_count == 12);
+  assert(stats.vertex_bytes == 12 * sizeof(vector_t));
+  assert(stats.body_bytes > 0);
+  assert(stats.force_count == 2);
+  assert(stats.aux_count == 2);
+  // The auxiliary values passed in here have unknown sizes
+  assert(stats.aux_bytes == 0);
+  assert(stats.ticks == 0);
+
+  // remove_body() removes the last body, and the first force with it
+  scene_tick(scene, 1);
+  scene_tick(scene, 1);
+  stats = scene_memory_stats(scene);
+  assert(stats.body_count == 1);
+  assert(stats.vertex_count == 4);
+  assert(stats.force_count == 1);
+  assert(stats.ticks == 2);
+  assert(stats.total_tick_allocs >= stats.tick_allocs);
+
+  // Allocations outside the scene's ticks are not counted
+  void *other = mem_alloc(MEM_AUX, 64);
+  create_angular_collision(scene, 1, scene_get_body(scene, 0),
+                           scene_get_body(scene, 0));
+  stats = scene_memory_stats(scene);
+  assert(stats.aux_bytes == sizeof(aux_t));
+  // Collision pairs' auxiliary values are counted too
+  size_t aux_count = stats.aux_count;
+  create_sized_collision(scene, scene_get_body(scene, 0),
+                         scene_get_body(scene, 0), NULL,
+                         mem_alloc(MEM_AUX, 24), 24, free_aux24);
+  stats = scene_memory_stats(scene);
+  assert(stats.aux_count == aux_count + 1);
+  assert(stats.aux_bytes == sizeof(aux_t) + 24);
+  size_t total = stats.total_tick_allocs;
+  mem_free(MEM_AUX, other, 64);
+  scene_tick(scene, 1);
+  stats = scene_memory_stats(scene);
+  assert(stats.total_tick_allocs == total + stats.tick_allocs);
+  scene_free(scene);
+}
+
+// A force creator that pulls a body towards the origin like a spring
+void hooke_force(void *aux) {
+  body_t *body = aux;
+  body_add_force(body, vec_multiply(-4, body_get_centroid(body)));
+}
+
+// Returns the distance between a mass on a spring and its exact position
+// after integrating its motion with the given integrator
+double oscillator_error(integrator_t integrator, double dt, int steps) {
+  scene_t *scene = scene_init();
+  assert(scene_get_integrator(scene) == INTEGRATOR_DEFAULT);
+  scene_set_integrator(scene, integrator);
+  assert(scene_get_integrator(scene) == integrator);
+  body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  body_set_centroid(body, (vector_t){1, 0});
+  scene_add_body(scene, body);
+  scene_add_force_creator(scene, hooke_force, body, NULL);
+  for (int i = 0; i < steps; i++) {
+    scene_tick(scene, dt);
+  }
+  // x(t) = cos(omega * t) with omega = sqrt(K / M) = 2
+  vector_t diff = vec_subtract(body_get_centroid(body),
+                               (vector_t){cos(2 * dt * steps), 0});
+  scene_free(scene);
+  return sqrt(vec_dot(diff, diff));
+}
+
+void test_integrators() {
+  const double DT = 1e-2;
+  const int STEPS = 500;
+  double euler = oscillator_error(INTEGRATOR_SYMPLECTIC_EULER, DT, STEPS);
+  double verlet = oscillator_error(INTEGRATOR_VELOCITY_VERLET, DT, STEPS);
+  double rk4 = oscillator_error(INTEGRATOR_RK4, DT, STEPS);
+  assert(euler < 1e-1);
+  assert(verlet < 1e-3);
+  assert(rk4 < 1e-7);
+
+  // Halving the step divides the error by 2 ^ order
+  assert(verlet / oscillator_error(INTEGRATOR_VELOCITY_VERLET, DT / 2,
+                                   2 * STEPS) > 3.5);
+  assert(rk4 / oscillator_error(INTEGRATOR_RK4, DT / 2, 2 * STEPS) > 14);
+}
+
+typedef struct {
+  body_t *body1;
+  body_t *body2;
+} pair_aux_t;
+
+// A spring-like force creator whose result depends on the forces already
+// applied to its bodies, so it detects force creators running out of order
+void halving_spring(void *aux) {
+  pair_aux_t *pair = aux;
+  vector_t stretch = vec_subtract(body_get_centroid(pair->body2),
+                                  body_get_centroid(pair->body1));
+  vector_t force1 = vec_multiply(0.5, body_get_force(pair->body1));
+  vector_t force2 = vec_multiply(0.5, body_get_force(pair->body2));
+  body_set_force(pair->body1, vec_add(force1, stretch));
+  body_set_force(pair->body2, vec_subtract(force2, stretch));
+}
+
+void add_halving_springs(scene_t *scene, size_t first) {
+  for (size_t i = first; i + 1 < scene_bodies(scene); i += 2) {
+    pair_aux_t *aux = malloc(sizeof(pair_aux_t));
+    aux->body1 = scene_get_body(scene, i);
+    aux->body2 = scene_get_body(scene, i + 1);
+    list_t *bodies = list_init(2, NULL);
+    list_add(bodies, aux->body1);
+    list_add(bodies, aux->body2);
+    scene_add_bodies_force_creator(scene, halving_spring, aux, bodies, free);
+  }
+}
+
+scene_t *make_chain_scene(size_t threads, integrator_t integrator) {
+  const size_t BODIES = 64;
+  scene_t *scene = scene_init();
+  scene_set_threads(scene, threads);
+  scene_set_integrator(scene, integrator);
+  for (size_t i = 0; i < BODIES; i++) {
+    body_t *body = body_init(make_shape(), 1 + i % 3, (rgb_color_t){0, 0, 0});
+    body_set_centroid(body, (vector_t){i * 1.5, (i * 7 % 5) * 0.1});
+    scene_add_body(scene, body);
+    if (i > 0) {
+      scene_add_batched_force(scene, FORCE_PHYSICS_COLLISION, 0.5,
+                              scene_get_body(scene, i - 1), body);
+    }
+  }
+  add_halving_springs(scene, 0);
+  add_halving_springs(scene, 1);
+  // A force creator without bodies runs after every earlier force creator
+  force_aux_t *gravity = malloc(sizeof(force_aux_t));
+  gravity->scene = scene;
+  gravity->coefficient = 9.8;
+  scene_add_force_creator(scene, constant_gravity, gravity, free);
+  add_halving_springs(scene, 0);
+  return scene;
+}
+
+void test_threads() {
+  const size_t STEPS = 200;
+  for (integrator_t integrator = 0; integrator < INTEGRATOR_KINDS;
+       integrator++) {
+    scene_t *serial = make_chain_scene(1, integrator);
+    scene_t *parallel = make_chain_scene(4, integrator);
+    assert(scene_get_threads(serial) == 1);
+    assert(scene_get_threads(parallel) == 4);
+    // Even springs, odd springs, gravity, then even springs again
+    assert(scene_force_levels(parallel) == 4);
+    for (size_t step = 0; step < STEPS; step++) {
+      scene_tick(serial, 1e-3);
+      scene_tick(parallel, 1e-3);
+    }
+    // Each body sees the same forces in the same order on any number of
+    // threads, and the contacts are solved in the same order
+    for (size_t i = 0; i < scene_bodies(serial); i++) {
+      body_t *expected = scene_get_body(serial, i);
+      body_t *actual = scene_get_body(parallel, i);
+      assert(vec_equal(body_get_centroid(expected), body_get_centroid(actual)));
+      assert(vec_equal(body_get_velocity(expected), body_get_velocity(actual)));
+    }
+
+    // Removing bodies removes their forces on any number of threads
+    body_remove(scene_get_body(serial, 0));
+    body_remove(scene_get_body(parallel, 0));
+    scene_tick(serial, 1e-3);
+    scene_tick(parallel, 1e-3);
+    assert(scene_bodies(parallel) == scene_bodies(serial));
+    assert(scene_memory_stats(parallel).force_count ==
+           scene_memory_stats(serial).force_count);
+    assert(scene_force_levels(parallel) == 4);
+    scene_set_threads(parallel, 1);
+    assert(scene_get_threads(parallel) == 1);
+    scene_tick(parallel, 1e-3);
+    scene_free(serial);
+    scene_free(parallel);
+  }
+}
+
+void test_fields() {
+  const vector_t G = {0, -9.8};
+  const double GAMMA = 0.5;
+  const double DT = 1e-2;
+  scene_t *scene = scene_init();
+  body_t *falling = body_init(make_shape(), 2, (rgb_color_t){0, 0, 0});
+  body_t *floating = body_init(make_shape(), 3, (rgb_color_t){0, 0, 0});
+  body_t *wall = body_init(make_shape(), INFINITY, (rgb_color_t){0, 0, 0});
+  body_set_layers(floating, 0x2);
+  body_set_velocity(floating, (vector_t){4, 0});
+  scene_add_body(scene, falling);
+  scene_add_body(scene, floating);
+  scene_add_body(scene, wall);
+  scene_add_uniform_field(scene, G, LAYER_DEFAULT);
+  scene_add_global_drag(scene, GAMMA, LAYER_ALL);
+  assert(scene_fields(scene) == 2);
+  assert(scene_memory_stats(scene).force_count == 2);
+  scene_set_integrator(scene, INTEGRATOR_SYMPLECTIC_EULER);
+  scene_tick(scene, DT);
+  // Gravity only acts on layer 0, and drag acts on every layer
+  assert(vec_isclose(body_get_velocity(falling), vec_multiply(DT, G)));
+  assert(vec_isclose(body_get_velocity(floating),
+                     (vector_t){4 - DT * GAMMA * 4 / 3, 0}));
+  assert(vec_equal(body_get_velocity(wall), VEC_ZERO));
+  scene_free(scene);
+}
+
+void do_nothing(void *aux) {}
+
+void test_tick_stats() {
+  scene_t *scene = scene_init();
+  scene_tick_stats_t stats = scene_get_stats(scene);
+  assert(stats.ticks == 0);
+  assert(stats.tick_seconds == 0);
+
+  for (size_t i = 0; i < 3; i++) {
+    body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+    body_set_centroid(body, (vector_t){i, 0});
+    scene_add_body(scene, body);
+  }
+  // Bodies 0 and 1 overlap and destroy each other in the first tick
+  create_destructive_collision(scene, scene_get_body(scene, 0),
+                               scene_get_body(scene, 1));
+  scene_add_force_creator(scene, do_nothing, NULL, NULL);
+  scene_tick(scene, 0.1);
+  stats = scene_get_stats(scene);
+#ifdef SCENE_PROFILE
+  assert(stats.ticks == 1);
+  assert(stats.force_creators == 1);
+  assert(stats.collision_tests == 1);
+  assert(stats.collisions == 1);
+  assert(stats.bodies_integrated == 3);
+  assert(stats.bodies_removed == 2);
+  double stage_sum = 0;
+  for (tick_stage_t stage = 0; stage < TICK_STAGES; stage++) {
+    assert(stats.stage_seconds[stage] >= 0);
+    stage_sum += stats.stage_seconds[stage];
+  }
+  assert(stage_sum <= stats.tick_seconds * (1 + 1e-9));
+
+  // The second tick has nothing to remove, so the average halves
+  scene_tick(scene, 0.1);
+  stats = scene_get_stats(scene);
+  assert(stats.ticks == 2);
+  assert(stats.bodies_integrated == 2);
+  assert(stats.bodies_removed == 1);
+  assert(stats.collision_tests == 0.5);
+
+  // Only the most recent ticks are averaged
+  for (size_t i = 0; i < 100; i++) {
+    scene_tick(scene, 0.1);
+  }
+  stats = scene_get_stats(scene);
+  assert(stats.ticks == 60);
+  assert(stats.bodies_integrated == 1);
+  assert(stats.bodies_removed == 0);
+#else
+  // Without profiling, nothing is recorded
+  assert(stats.ticks == 0);
+  assert(stats.bodies_integrated == 0);
+#endif
+  scene_free(scene);
+}
+
 int main(int argc, char *argv[]) {
   // Run all tests if there are no command-line arguments
   bool all_tests = argc == 1;
@@ -242,6 +530,11 @@ int main(int argc, char *argv[]) {
   DO_TEST(test_force_creator)
   DO_TEST(test_force_creator_aux)
   DO_TEST(test_reaping)
+  DO_TEST(test_memory_stats)
+  DO_TEST(test_integrators)
+  DO_TEST(test_threads)
+  DO_TEST(test_fields)
+  DO_TEST(test_tick_stats)
 
   puts("scene_test PASS");
 }
@@ -0,0 +1,170 @@
+#include "mem_stats.h"
+#include "snapshot.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+list_t *make_shape() {
+  list_t *shape = list_init(4, free);
+  vector_t *v = malloc(sizeof(*v));
+  *v = (vector_t){-1, -1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){+1, -1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){+1, +1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){-1, +1};
+  list_add(shape, v);
+  return shape;
+}
+
+scene_t *make_scene(size_t bodies) {
+  scene_t *scene = scene_init();
+  for (size_t i = 0; i < bodies; i++) {
+    body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 1});
+    body_set_centroid(body, (vector_t){i, 0});
+    scene_add_body(scene, body);
+  }
+  return scene;
+}
+
+void test_publish_acquire() {
+  snapshot_buffer_t *buffer = snapshot_buffer_init();
+  assert(snapshot_buffer_acquire(buffer) == NULL);
+
+  scene_t *scene = make_scene(2);
+  body_t *body = scene_get_body(scene, 1);
+  body_set_static(body, true);
+  body_set_rotation(body, 0.5);
+  snapshot_buffer_publish(buffer, scene, "00 || 00");
+  const snapshot_t *snapshot = snapshot_buffer_acquire(buffer);
+  assert(snapshot != NULL);
+  assert(snapshot_sequence(snapshot) == 0);
+  assert(snapshot_bodies(snapshot) == 2);
+  assert(strcmp(snapshot_message(snapshot), "00 || 00") == 0);
+  const snapshot_body_t *copy = snapshot_get_body(snapshot, 1);
+  assert(copy->body == body);
+  assert(copy->version == body_get_version(body));
+  assert(copy->mesh == body_get_mesh(body));
+  assert(vec_isclose(copy->position, (vector_t){1, 0}));
+  assert(isclose(copy->angle, body_get_rotation(body) - copy->mesh->rotation));
+  assert(copy->color.b == 1);
+  assert(copy->is_static);
+  assert(!snapshot_get_body(snapshot, 0)->is_static);
+
+  // Nothing new was published, so the reader keeps its snapshot
+  assert(snapshot_buffer_acquire(buffer) == snapshot);
+
+  // The reader skips to the newest snapshot
+  scene_add_body(scene, body_init(make_shape(), 1, (rgb_color_t){0, 0, 0}));
+  snapshot_buffer_publish(buffer, scene, "01 || 00");
+  snapshot_buffer_publish(buffer, scene, NULL);
+  snapshot = snapshot_buffer_acquire(buffer);
+  assert(snapshot_sequence(snapshot) == 2);
+  assert(snapshot_bodies(snapshot) == 3);
+  assert(snapshot_message(snapshot) == NULL);
+
+  scene_free(scene);
+  snapshot_buffer_free(buffer);
+}
+
+void test_mesh_outlives_body() {
+  size_t body_bytes = mem_live_bytes(MEM_BODY);
+  size_t scene_bytes = mem_live_bytes(MEM_SCENE);
+  snapshot_buffer_t *buffer = snapshot_buffer_init();
+  scene_t *scene = make_scene(3);
+  snapshot_buffer_publish(buffer, scene, "hello");
+  const snapshot_t *snapshot = snapshot_buffer_acquire(buffer);
+
+  // Reshaping a body gives it a new mesh, but the snapshot keeps the old one
+  body_t *body = scene_get_body(scene, 2);
+  const body_mesh_t *old_mesh = body_get_mesh(body);
+  body_y_scale(body, 3);
+  assert(snapshot_get_body(snapshot, 2)->mesh == old_mesh);
+  snapshot_buffer_publish(buffer, scene, "hello");
+  assert(snapshot_get_body(snapshot, 2)->mesh == old_mesh);
+
+  // Even freeing the scene leaves the reader's meshes readable
+  scene_free(scene);
+  for (size_t i = 0; i < snapshot_bodies(snapshot); i++) {
+    const body_mesh_t *mesh = snapshot_get_body(snapshot, i)->mesh;
+    assert(mesh->vertex_count == 4);
+    assert(mesh->triangle_count == 2);
+    assert(vec_isclose(mesh->vertices[0], (vector_t){-1, -1}));
+  }
+  snapshot_buffer_free(buffer);
+  assert(mem_live_bytes(MEM_BODY) == body_bytes);
+  assert(mem_live_bytes(MEM_SCENE) == scene_bytes);
+}
+
+const size_t PUBLISHES = 2000;
+const size_t THREAD_BODIES = 20;
+
+// Publishes scenes whose bodies all sit at x = the snapshot's sequence
+void *publish_scenes(void *aux) {
+  snapshot_buffer_t *buffer = aux;
+  scene_t *scene = make_scene(THREAD_BODIES);
+  for (size_t i = 0; i < PUBLISHES; i++) {
+    for (size_t j = 0; j < THREAD_BODIES; j++) {
+      body_t *body = scene_get_body(scene, j);
+      body_set_centroid(body, (vector_t){i, j});
+      // Reshape some bodies so meshes are replaced while being read
+      if (i % 7 == j % 7) {
+        body_y_scale(body, i % 2 == 0 ? 2 : 0.5);
+      }
+    }
+    snapshot_buffer_publish(buffer, scene, NULL);
+  }
+  scene_free(scene);
+  return NULL;
+}
+
+void test_threads() {
+  snapshot_buffer_t *buffer = snapshot_buffer_init();
+  pthread_t writer;
+  int error = pthread_create(&writer, NULL, publish_scenes, buffer);
+  assert(error == 0);
+
+  size_t last_sequence = 0;
+  while (last_sequence + 1 < PUBLISHES) {
+    const snapshot_t *snapshot = snapshot_buffer_acquire(buffer);
+    if (snapshot == NULL) {
+      continue;
+    }
+    size_t sequence = snapshot_sequence(snapshot);
+    assert(sequence >= last_sequence);
+    last_sequence = sequence;
+    // A snapshot is never mixed with a later one
+    assert(snapshot_bodies(snapshot) == THREAD_BODIES);
+    for (size_t j = 0; j < THREAD_BODIES; j++) {
+      const snapshot_body_t *copy = snapshot_get_body(snapshot, j);
+      assert(copy->position.x == sequence);
+      assert(copy->position.y == j);
+      assert(copy->mesh->vertex_count == 4);
+    }
+  }
+  pthread_join(writer, NULL);
+  snapshot_buffer_free(buffer);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_publish_acquire)
+  DO_TEST(test_mesh_outlives_body)
+  DO_TEST(test_threads)
+
+  puts("snapshot_test PASS");
+}
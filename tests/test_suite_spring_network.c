@@ -0,0 +1,160 @@
+#include "forces.h"
+#include "spring_network.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+list_t *make_shape() {
+  list_t *shape = list_init(4, free);
+  vector_t *v = malloc(sizeof(*v));
+  *v = (vector_t){-1, -1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){+1, -1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){+1, +1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){-1, +1};
+  list_add(shape, v);
+  return shape;
+}
+
+body_t *make_body(vector_t centroid) {
+  body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  body_set_centroid(body, centroid);
+  return body;
+}
+
+void test_rest_length() {
+  body_t *body1 = make_body(VEC_ZERO);
+  body_t *body2 = make_body((vector_t){3, 4});
+  spring_network_t *network = spring_network_init(0, 0);
+  size_t index1 = spring_network_add_body(network, body1);
+  size_t index2 = spring_network_add_body(network, body2);
+  assert(index1 == 0 && index2 == 1);
+
+  // At its rest length the spring exerts no force
+  spring_network_add_spring(network, index1, index2, 2, 5);
+  spring_network_apply(network);
+  assert(vec_isclose(body_get_force(body1), VEC_ZERO));
+  assert(vec_isclose(body_get_force(body2), VEC_ZERO));
+
+  // Stretched by 5, it pulls with force k * 5 along the spring
+  body_set_centroid(body2, (vector_t){6, 8});
+  spring_network_apply(network);
+  assert(vec_isclose(body_get_force(body1), (vector_t){6, 8}));
+  assert(vec_isclose(body_get_force(body2), (vector_t){-6, -8}));
+  body_tick(body1, 0);
+  body_tick(body2, 0);
+
+  // Compressed by 2.5, it pushes the bodies apart
+  body_set_centroid(body2, (vector_t){1.5, 2});
+  spring_network_apply(network);
+  assert(vec_isclose(body_get_force(body1), (vector_t){-3, -4}));
+  assert(vec_isclose(body_get_force(body2), (vector_t){3, 4}));
+
+  spring_network_free(network);
+  body_free(body1);
+  body_free(body2);
+}
+
+// Tests that a chain's forces match the sum over its springs,
+// including springs added after the network was first applied
+void test_chain() {
+  const size_t LINKS = 100;
+  body_t *bodies[LINKS];
+  spring_network_t *network = spring_network_init(1, 1);
+  for (size_t i = 0; i < LINKS; i++) {
+    bodies[i] = make_body((vector_t){i * 1.5, (i % 3) * 0.25});
+    assert(spring_network_add_body(network, bodies[i]) == i);
+  }
+  for (size_t i = 1; i < LINKS / 2; i++) {
+    spring_network_add_spring(network, i - 1, i, i, 0);
+  }
+  spring_network_apply(network);
+  for (size_t i = 0; i < LINKS; i++) {
+    body_tick(bodies[i], 0);
+  }
+  for (size_t i = LINKS / 2; i < LINKS; i++) {
+    spring_network_add_spring(network, i - 1, i, i, 0);
+  }
+  assert(spring_network_springs(network) == LINKS - 1);
+  spring_network_apply(network);
+  for (size_t i = 0; i < LINKS; i++) {
+    vector_t expected = VEC_ZERO;
+    vector_t centroid = body_get_centroid(bodies[i]);
+    if (i > 0) {
+      vector_t offset =
+          vec_subtract(body_get_centroid(bodies[i - 1]), centroid);
+      expected = vec_add(expected, vec_multiply(i, offset));
+    }
+    if (i + 1 < LINKS) {
+      vector_t offset =
+          vec_subtract(body_get_centroid(bodies[i + 1]), centroid);
+      expected = vec_add(expected, vec_multiply(i + 1, offset));
+    }
+    assert(vec_isclose(body_get_force(bodies[i]), expected));
+  }
+  spring_network_free(network);
+  for (size_t i = 0; i < LINKS; i++) {
+    body_free(bodies[i]);
+  }
+}
+
+// Tests that a zero-rest-length network moves bodies like create_spring()
+void test_matches_create_spring() {
+  const double DT = 1e-3;
+  const int STEPS = 1000;
+  scene_t *springs = scene_init();
+  scene_t *networked = scene_init();
+  spring_network_t *network = spring_network_init(3, 3);
+  for (size_t i = 0; i < 3; i++) {
+    vector_t centroid = {10.0 * i, i * i};
+    scene_add_body(springs, make_body(centroid));
+    body_t *body = make_body(centroid);
+    scene_add_body(networked, body);
+    spring_network_add_body(network, body);
+  }
+  for (size_t i = 0; i < 3; i++) {
+    size_t j = (i + 1) % 3;
+    create_spring(springs, i + 1, scene_get_body(springs, i),
+                  scene_get_body(springs, j));
+    spring_network_add_spring(network, i, j, i + 1, 0);
+  }
+  create_spring_network(networked, network);
+  for (int i = 0; i < STEPS; i++) {
+    scene_tick(springs, DT);
+    scene_tick(networked, DT);
+    for (size_t j = 0; j < 3; j++) {
+      assert(vec_isclose(body_get_centroid(scene_get_body(springs, j)),
+                         body_get_centroid(scene_get_body(networked, j))));
+    }
+  }
+
+  // Removing one of the network's bodies removes the network
+  assert(scene_forces(networked) == 1);
+  scene_remove_body(networked, 1);
+  scene_tick(networked, DT);
+  assert(scene_forces(networked) == 0);
+  scene_free(springs);
+  scene_free(networked);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_rest_length)
+  DO_TEST(test_chain)
+  DO_TEST(test_matches_create_spring)
+
+  puts("spring_network_test PASS");
+}
@@ -0,0 +1,124 @@
+#include "mem_stats.h"
+#include "test_util.h"
+#include "timing.h"
+#include <assert.h>
+#include <pthread.h>
+#include <time.h>
+
+void test_now() {
+  double start = timing_now();
+  // Sleeping uses no CPU time, but the clock still advances
+  struct timespec delay = {.tv_sec = 0, .tv_nsec = 20000000};
+  nanosleep(&delay, NULL);
+  double elapsed = timing_now() - start;
+  assert(0.02 <= elapsed && elapsed < 1);
+
+  double last = timing_now();
+  for (size_t i = 0; i < 1000; i++) {
+    double now = timing_now();
+    assert(now >= last);
+    last = now;
+  }
+}
+
+void test_empty() {
+  timing_histogram_t *histogram = timing_histogram_init(10);
+  timing_summary_t summary = timing_histogram_summary(histogram);
+  assert(summary.samples == 0);
+  assert(summary.p50 == 0 && summary.p99 == 0 && summary.max == 0);
+  timing_histogram_free(histogram);
+}
+
+void test_percentiles() {
+  timing_histogram_t *histogram = timing_histogram_init(100);
+  // Add 1 through 100 out of order
+  for (size_t i = 0; i < 100; i++) {
+    timing_histogram_add(histogram, (i * 37) % 100 + 1);
+  }
+  timing_summary_t summary = timing_histogram_summary(histogram);
+  assert(summary.samples == 100);
+  assert(summary.p50 == 50);
+  assert(summary.p95 == 95);
+  assert(summary.p99 == 99);
+  assert(summary.max == 100);
+
+  // One slow sample shows up in the maximum but not the median
+  timing_histogram_t *small = timing_histogram_init(3);
+  timing_histogram_add(small, 1);
+  timing_histogram_add(small, 9);
+  timing_histogram_add(small, 2);
+  summary = timing_histogram_summary(small);
+  assert(summary.p50 == 2);
+  assert(summary.p95 == 9);
+  assert(summary.max == 9);
+  timing_histogram_free(small);
+  timing_histogram_free(histogram);
+}
+
+void test_window() {
+  size_t bytes = mem_live_bytes(MEM_TIMING);
+  size_t aux_bytes = mem_live_bytes(MEM_AUX);
+  timing_histogram_t *histogram = timing_histogram_init(4);
+  assert(mem_live_bytes(MEM_TIMING) > bytes);
+  assert(mem_live_bytes(MEM_AUX) == aux_bytes);
+  for (size_t i = 0; i < 10; i++) {
+    timing_histogram_add(histogram, i);
+  }
+  // Only the last 4 samples (6 through 9) are kept
+  timing_summary_t summary = timing_histogram_summary(histogram);
+  assert(summary.samples == 4);
+  assert(summary.p50 == 7);
+  assert(summary.max == 9);
+  timing_histogram_add(histogram, 0.5);
+  summary = timing_histogram_summary(histogram);
+  assert(summary.p50 == 7);
+  assert(summary.p95 == 9);
+  timing_histogram_free(histogram);
+  assert(mem_live_bytes(MEM_TIMING) == bytes);
+}
+
+const size_t THREAD_SAMPLES = 10000;
+
+void *add_samples(void *aux) {
+  timing_histogram_t *histogram = aux;
+  for (size_t i = 0; i < THREAD_SAMPLES; i++) {
+    timing_histogram_add(histogram, i % 10);
+  }
+  return NULL;
+}
+
+void test_threads() {
+  timing_histogram_t *histogram = timing_histogram_init(50);
+  pthread_t writer;
+  int error = pthread_create(&writer, NULL, add_samples, histogram);
+  assert(error == 0);
+  for (size_t i = 0; i < 100; i++) {
+    timing_summary_t summary = timing_histogram_summary(histogram);
+    assert(summary.samples <= 50);
+    assert(summary.p50 <= summary.p95 && summary.p95 <= summary.p99 &&
+           summary.p99 <= summary.max && summary.max <= 9);
+  }
+  pthread_join(writer, NULL);
+  timing_summary_t summary = timing_histogram_summary(histogram);
+  assert(summary.samples == 50);
+  assert(summary.max == 9);
+  timing_histogram_free(histogram);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_now)
+  DO_TEST(test_empty)
+  DO_TEST(test_percentiles)
+  DO_TEST(test_window)
+  DO_TEST(test_threads)
+
+  puts("timing_test PASS");
+}
@@ -0,0 +1,120 @@
+#include "mem_stats.h"
+#include "test_util.h"
+#include "voice_pool.h"
+#include <assert.h>
+
+#define MAX_PLAYS 16
+
+// Records the sounds started by a flush and the voices they started on
+typedef struct plays {
+  size_t count;
+  size_t sounds[MAX_PLAYS];
+  size_t voices[MAX_PLAYS];
+} plays_t;
+
+void record_play(size_t sound, size_t voice, void *aux) {
+  plays_t *plays = aux;
+  assert(plays->count < MAX_PLAYS);
+  plays->sounds[plays->count] = sound;
+  plays->voices[plays->count] = voice;
+  plays->count++;
+}
+
+size_t flush(voice_pool_t *pool, plays_t *plays) {
+  plays->count = 0;
+  size_t started = voice_pool_flush(pool, record_play, plays);
+  assert(started == plays->count);
+  return started;
+}
+
+void test_dedupe() {
+  size_t bytes = mem_live_bytes(MEM_AUDIO);
+  voice_pool_t *pool = voice_pool_init(3, 8, 2);
+  plays_t plays;
+  assert(flush(pool, &plays) == 0);
+
+  // Jittery contacts queue the same sound many times in a frame
+  for (size_t i = 0; i < 10; i++) {
+    voice_pool_queue(pool, 2);
+    voice_pool_queue(pool, 0);
+  }
+  assert(flush(pool, &plays) == 2);
+  assert(plays.sounds[0] == 2 && plays.sounds[1] == 0);
+  assert(plays.voices[0] != plays.voices[1]);
+  assert(voice_pool_playing(pool, 2) == 1);
+  assert(voice_pool_playing(pool, 0) == 1);
+  assert(voice_pool_playing(pool, 1) == 0);
+
+  // The queue starts over after a flush
+  assert(flush(pool, &plays) == 0);
+  voice_pool_queue(pool, 2);
+  assert(flush(pool, &plays) == 1);
+  assert(voice_pool_playing(pool, 2) == 2);
+  voice_pool_free(pool);
+  assert(mem_live_bytes(MEM_AUDIO) == bytes);
+}
+
+void test_per_sound_cap() {
+  voice_pool_t *pool = voice_pool_init(2, 8, 2);
+  plays_t plays;
+  size_t voices[3];
+  for (size_t i = 0; i < 3; i++) {
+    voice_pool_queue(pool, 1);
+    flush(pool, &plays);
+    voices[i] = plays.voices[0];
+  }
+  // The third play restarts the sound's oldest voice
+  assert(voices[0] != voices[1]);
+  assert(voices[2] == voices[0]);
+  assert(voice_pool_playing(pool, 1) == 2);
+  voice_pool_queue(pool, 1);
+  flush(pool, &plays);
+  assert(plays.voices[0] == voices[1]);
+
+  // A voice that finishes frees up room for the sound
+  voice_pool_finished(pool, voices[1]);
+  assert(voice_pool_playing(pool, 1) == 1);
+  voice_pool_queue(pool, 1);
+  flush(pool, &plays);
+  assert(voice_pool_playing(pool, 1) == 2);
+  voice_pool_free(pool);
+}
+
+void test_stealing() {
+  voice_pool_t *pool = voice_pool_init(4, 3, 3);
+  plays_t plays;
+  for (size_t sound = 0; sound < 3; sound++) {
+    voice_pool_queue(pool, sound);
+    flush(pool, &plays);
+  }
+  // Every voice is busy, so the oldest (sound 0's) is stolen
+  voice_pool_queue(pool, 3);
+  flush(pool, &plays);
+  assert(voice_pool_playing(pool, 0) == 0);
+  assert(voice_pool_playing(pool, 3) == 1);
+
+  // Free voices are used before any are stolen
+  voice_pool_finished(pool, plays.voices[0]);
+  voice_pool_queue(pool, 0);
+  flush(pool, &plays);
+  for (size_t sound = 0; sound < 4; sound++) {
+    assert(voice_pool_playing(pool, sound) == (sound != 3));
+  }
+  voice_pool_free(pool);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_dedupe)
+  DO_TEST(test_per_sound_cap)
+  DO_TEST(test_stealing)
+
+  puts("voice_pool_test PASS");
+}